@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <opencv2/aruco.hpp>
+#include <opencv2/imgproc.hpp>
+#include "../src/detectors/markerdetector.h"
+
+/*
+ * Times MarkerDetector::find() with 0, 1 and 2 pyramid levels on a synthetic frame with known markers, and reports how
+ * many of the markers each finds. Detection is single threaded, so only the search itself is compared
+ *
+ * Usage: PyramidBenchmark [iterations]
+ */
+
+// Size of the synthetic frame, about what the arena cameras capture at full resolution
+const cv::Size FRAME_SIZE(2048, 1536);
+// Side lengths of the markers, cycled through. Robots further from the camera are smaller
+const int MARKER_SIZES[] = {40, 60, 90, 140};
+// Markers are placed on a grid of this many columns and rows, one per cell
+constexpr int GRID_COLUMNS = 6;
+constexpr int GRID_ROWS = 4;
+// Space left around the grid, so that even the largest rotated marker is completely within the frame
+constexpr int GRID_MARGIN = 150;
+// Standard deviation of the sensor noise in grey levels, and of the blur in pixels
+constexpr double NOISE = 4.0;
+constexpr double BLUR = 0.8;
+constexpr unsigned int SEED = 5489u;
+
+/** @brief A marker drawn onto the synthetic frame
+ *
+ */
+struct PlacedMarker
+{
+    int id;
+    cv::Point2d center;
+    int size;
+};
+
+/** @brief Render a frame of rotated markers on a grey floor, with noise and blur
+ *
+ * @param dictionary [in] Dictionary to draw the markers from
+ * @param frame [out] Rendered grayscale frame
+ * @return The markers that were drawn
+ */
+static std::vector<PlacedMarker> render_frame(const cv::Ptr<cv::aruco::Dictionary>& dictionary, cv::Mat& frame)
+{
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<double> angle_dist(-CV_PI, CV_PI);
+    std::uniform_real_distribution<double> jitter_dist(-0.1, 0.1);
+
+    frame.create(FRAME_SIZE, CV_8UC1);
+    frame.setTo(cv::Scalar(170));
+    const cv::Size2d cell(static_cast<double>(FRAME_SIZE.width - 2 * GRID_MARGIN) / GRID_COLUMNS,
+                          static_cast<double>(FRAME_SIZE.height - 2 * GRID_MARGIN) / GRID_ROWS);
+    std::vector<PlacedMarker> placed;
+    for(int i = 0; i < GRID_COLUMNS * GRID_ROWS; ++i)
+    {
+        // The first ids are the arena's corner markers
+        const int id = 4 + i;
+        const int size = MARKER_SIZES[i % (sizeof(MARKER_SIZES) / sizeof(MARKER_SIZES[0]))];
+        const cv::Point2d center(GRID_MARGIN + (i % GRID_COLUMNS + 0.5 + jitter_dist(rng)) * cell.width,
+                                 GRID_MARGIN + (i / GRID_COLUMNS + 0.5 + jitter_dist(rng)) * cell.height);
+
+        // Draw the marker with a white border, then rotate it onto the floor around its center
+        cv::Mat marker, bordered;
+        cv::aruco::drawMarker(dictionary, id, size, marker, 1);
+        const int border = size / 4;
+        cv::copyMakeBorder(marker, bordered, border, border, border, border, cv::BORDER_CONSTANT, cv::Scalar(255));
+        const double half = bordered.cols / 2.0;
+        cv::Mat to_frame = cv::getRotationMatrix2D(cv::Point2f(half, half), angle_dist(rng) * 180 / CV_PI, 1.0);
+        to_frame.at<double>(0, 2) += center.x - half;
+        to_frame.at<double>(1, 2) += center.y - half;
+        cv::warpAffine(bordered, frame, to_frame, frame.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+        placed.push_back({id, center, size});
+    }
+
+    cv::GaussianBlur(frame, frame, cv::Size(), BLUR);
+    cv::Mat noise(frame.size(), CV_16SC1);
+    cv::randn(noise, 0, NOISE);
+    cv::Mat noisy;
+    frame.convertTo(noisy, CV_16SC1);
+    noisy += noise;
+    noisy.convertTo(frame, CV_8UC1);
+    return placed;
+}
+
+/** @brief Count the placed markers that were found where they were drawn
+ *
+ * @param placed [in] Markers that were drawn
+ * @param corners [in] Corners of the markers that were found
+ * @param ids [in] Ids of the markers that were found
+ * @return Amount of placed markers that were found with their id, within a quarter of their size of their center
+ */
+static std::size_t count_found(const std::vector<PlacedMarker>& placed,
+                               const std::vector<std::vector<cv::Point2f>>& corners, const std::vector<int>& ids)
+{
+    std::size_t found = 0;
+    for(const auto& marker : placed)
+    {
+        for(std::size_t i = 0; i < ids.size(); ++i)
+        {
+            if(ids[i] != marker.id)
+                continue;
+            cv::Point2d center;
+            for(const auto& corner : corners[i])
+                center += cv::Point2d(corner) / static_cast<double>(corners[i].size());
+            if(cv::norm(center - marker.center) < marker.size / 4.0)
+            {
+                ++found;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    const int dictionary_id = cv::aruco::DICT_4X4_50;
+    cv::Mat frame;
+    const std::vector<PlacedMarker> placed = render_frame(cv::aruco::getPredefinedDictionary(dictionary_id), frame);
+
+    std::cout << FRAME_SIZE.width << "x" << FRAME_SIZE.height << " frame, " << placed.size() << " markers, "
+              << iterations << " iterations" << std::endl;
+    std::cout << "levels     mean ms   median ms   recall" << std::endl;
+    for(int levels = 0; levels <= 2; ++levels)
+    {
+        MarkerDetector detector(CameraCalib(), dictionary_id, nullptr, {}, levels);
+        std::vector<std::vector<cv::Point2f>> corners;
+        std::vector<int> ids;
+        // Let the per thread buffers settle before timing
+        detector.find(frame, corners, ids);
+
+        std::vector<double> times;
+        std::size_t found = 0;
+        for(int i = 0; i < iterations; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            detector.find(frame, corners, ids);
+            const auto end = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            found += count_found(placed, corners, ids);
+        }
+
+        double total = 0;
+        for(double time : times)
+            total += time;
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        const double recall = static_cast<double>(found) / (placed.size() * iterations);
+        std::cout << std::setw(6) << levels << std::fixed << std::setprecision(2)
+                  << std::setw(12) << total / iterations
+                  << std::setw(12) << times[times.size() / 2]
+                  << std::setw(9) << recall * 100 << "%" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include "../src/detectors/adaptivethreshold.h"
+
+/*
+ * Times adaptive_threshold() with each of its kernels against calling cv::adaptiveThreshold() once per window size,
+ * the way ArUco does. The image is the size of the coarse level of a 2048x1536 frame searched with 1 and 2 pyramid
+ * levels, which is the only place that MarkerDetector thresholds with adaptive_threshold()
+ *
+ * Usage: ThresholdBenchmark [iterations]
+ */
+
+// Sizes of the images to threshold
+const cv::Size IMAGE_SIZES[] = {{1024, 768}, {512, 384}};
+// ArUco's default window sizes and constant
+const std::vector<int> WINDOW_SIZES = {3, 13, 23};
+constexpr double CONSTANT = 7;
+
+/** @brief Time a function
+ *
+ * @param iterations [in] Amount of times to call the function
+ * @param func [in] Function to time
+ * @return Median time of a call, in milliseconds
+ */
+static double time_median(int iterations, const std::function<void()>& func)
+{
+    // Let any buffers settle before timing
+    func();
+    std::vector<double> times;
+    for(int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    // Only one thread, so that OpenCV's box filter isn't split over several cores while adaptive_threshold() isn't
+    cv::setNumThreads(1);
+
+    std::cout << "Window sizes 3, 13, 23, " << iterations << " iterations, rows are "
+              << (is_threshold_vectorized() ? "vectorized" : "not vectorized") << " on this CPU" << std::endl;
+    std::cout << "    size     opencv ms    scalar ms   fastest ms" << std::endl;
+    for(const cv::Size& size : IMAGE_SIZES)
+    {
+        cv::Mat image(size, CV_8UC1);
+        cv::randu(image, 0, 256);
+        cv::GaussianBlur(image, image, cv::Size(), 2);
+
+        std::vector<cv::Mat> thresholds(WINDOW_SIZES.size());
+        const double opencv = time_median(iterations, [&]
+        {
+            for(std::size_t i = 0; i < WINDOW_SIZES.size(); ++i)
+            {
+                cv::adaptiveThreshold(image, thresholds[i], 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV,
+                                      WINDOW_SIZES[i], CONSTANT);
+            }
+        });
+        const double scalar = time_median(iterations, [&]
+        {
+            adaptive_threshold(image, WINDOW_SIZES, CONSTANT, thresholds, ThresholdKernel::SCALAR);
+        });
+        const double fastest = time_median(iterations, [&]
+        {
+            adaptive_threshold(image, WINDOW_SIZES, CONSTANT, thresholds, ThresholdKernel::FASTEST);
+        });
+
+        std::cout << std::setw(4) << size.width << "x" << std::left << std::setw(4) << size.height << std::right
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(13) << opencv << std::setw(13) << scalar << std::setw(13) << fastest << std::endl;
+    }
+    return 0;
+}
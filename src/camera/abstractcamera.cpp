@@ -2,10 +2,37 @@
 #include "opencvcamera.h"
 #include "spinnakercamera.h"
 #include "../cmdhandler/constants/variables.h"
+#include "../pipeline/threadplacement.h"
 #include <spdlog/spdlog.h>
 
-AbstractCamera::AbstractCamera(const StateVariables& state) : m_type(state.camera.type)
+// How long get_frame() waits for the capture thread before giving up
+constexpr std::chrono::milliseconds CAPTURE_POP_TIMEOUT(100);
+// Frames that are usually held by the pipeline stages at once, on top of the ones in the capture thread's frame ring.
+// The pool grows if the pipeline holds more, i.e. with many detection threads
+constexpr std::size_t PIPELINE_FRAMES = 8;
+
+/** @brief Convert a pixel format name from the camera system into a PixelFormat
+ *
+ * @param name [in] One of CameraSystemVars::PIXEL_FORMATS
+ * @return Matching pixel format, PixelFormat::BGR8 if the name is unknown
+ */
+static PixelFormat to_pixel_format(const std::string& name)
+{
+    if(name == CameraSystemVars::PIXEL_FORMAT_MONO8)
+        return PixelFormat::MONO8;
+    if(name == CameraSystemVars::PIXEL_FORMAT_BAYER_RG8)
+        return PixelFormat::BAYER_RG8;
+    return PixelFormat::BGR8;
+}
+
+AbstractCamera::AbstractCamera(const CameraSystem& camera) : m_type(camera.type)
+{
+}
+
+AbstractCamera::~AbstractCamera()
 {
+    // Derived classes should have already done this, but make sure the thread is never left running
+    stop_capture();
 }
 
 void AbstractCamera::enable_video_output() { m_video_output = true; }
@@ -18,21 +45,132 @@ bool AbstractCamera::video_postprocessing_enabled() { return m_video_postprocess
 const CameraCalib& AbstractCamera::get_camera_calib() const { return m_calib; }
 const std::string& AbstractCamera::get_source() const { return m_source; }
 const std::string& AbstractCamera::get_type() const { return m_type; }
+PixelFormat AbstractCamera::get_pixel_format() const { return m_pixel_format; }
 bool AbstractCamera::is_connected() const { return m_connected; }
+bool AbstractCamera::is_capturing() const { return m_capturing; }
+std::uint64_t AbstractCamera::dropped_frames() const { return m_ring ? m_ring->dropped_frames() : 0; }
+std::uint64_t AbstractCamera::frame_allocations() const { return m_pool.allocations(); }
+
+void AbstractCamera::acquire_frame(Frame& frame, cv::Size size, int type)
+{
+    // The ring can hold one more frame than its capacity while the capture thread is pushing
+    const std::size_t ring_frames = m_ring ? m_ring->capacity() + 1 : 0;
+    m_pool.acquire(frame, size, type, ring_frames + PIPELINE_FRAMES);
+}
+
+bool AbstractCamera::get_frame(Frame& frame)
+{
+    if(m_capturing)
+        return m_ring->pop(frame, CAPTURE_POP_TIMEOUT);
+    return read_frame(frame);
+}
 
-void AbstractCamera::update_state(const StateVariables& state)
+bool AbstractCamera::read_frame(Frame& frame)
+{
+    // Clear the timestamp so that a stale one isn't kept if the camera doesn't set one
+    frame.timestamp = {};
+    frame.device_timestamp = 0;
+    if(!do_get_frame(frame))
+        return false;
+
+    if(frame.timestamp == std::chrono::steady_clock::time_point())
+        frame.timestamp = std::chrono::steady_clock::now();
+    return true;
+}
+
+void AbstractCamera::start_capture(std::size_t capacity, FrameRing::Policy policy)
+{
+    stop_capture();
+
+    m_ring = std::make_unique<FrameRing>(capacity, policy);
+    m_capture_buffer_size = capacity;
+    m_capturing = true;
+    m_capture_thread = std::thread(&AbstractCamera::capture_thread_func, this);
+    spdlog::info("Started capture thread with a {} frame ring", m_ring->capacity());
+}
+
+void AbstractCamera::stop_capture()
+{
+    if(!m_capturing)
+        return;
+
+    m_capturing = false;
+    // Wake up the capture thread if it's blocked on a full ring
+    m_ring->close();
+    if(m_capture_thread.joinable())
+        m_capture_thread.join();
+
+    // Let go of any frames left in the ring so their buffers are given back to the camera before it's disconnected
+    Frame frame;
+    while(m_ring->try_pop(frame))
+        frame.release();
+
+    spdlog::info("Stopped capture thread. {} frames captured, {} frames dropped",
+                 m_ring->pushed_frames(), m_ring->dropped_frames());
+    m_capture_buffer_size = 0;
+}
+
+bool AbstractCamera::while_capture_paused(const std::function<bool()>& func)
+{
+    if(!m_capturing)
+        return func();
+
+    const std::size_t capacity = m_capture_buffer_size;
+    const FrameRing::Policy policy = m_ring->policy();
+    stop_capture();
+    const bool result = func();
+    start_capture(capacity, policy);
+    return result;
+}
+
+void AbstractCamera::fit_roi(const std::vector<cv::Point2f>&)
+{
+    // Cameras without sensor regions read out the whole sensor regardless of where the markers are
+}
+
+void AbstractCamera::capture_thread_func()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::CAPTURE);
+    while(m_capturing)
+    {
+        Frame frame;
+        if(read_frame(frame))
+        {
+            if(!m_ring->push(std::move(frame)))
+                break;
+        }
+        else
+        {
+            // Don't spin if the camera is failing to produce frames (i.e. the end of a video file was reached)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void AbstractCamera::update_state(const CameraSystem& camera)
 {
     // Make sure that somehow this camera wasn't replaced with a new one during a type change
-    if(m_type != state.camera.type)
-        throw std::runtime_error("Wrong camera type -- '" + m_type + "' != '" + state.camera.type + "'");
+    if(m_type != camera.type)
+        throw std::runtime_error("Wrong camera type -- '" + m_type + "' != '" + camera.type + "'");
+
+    m_calib.matrix = camera.camera_matrix;
+    m_calib.dist_coeffs = camera.distortion_matrix;
+
+    const PixelFormat pixel_format = to_pixel_format(camera.pixel_format);
 
-    // if the camera source has changed
-    if(m_source != state.camera.source)
+    // The capture thread can't be reading from the camera while the connection changes. It's started again below
+    // if it should still be running
+    if(m_source != camera.source || m_pixel_format != pixel_format || m_connected != camera.connected)
+        stop_capture();
+
+    // if the camera source or pixel format has changed
+    if(m_source != camera.source || m_pixel_format != pixel_format)
     {
-        m_source = state.camera.source;
+        m_source = camera.source;
+        m_pixel_format = pixel_format;
         // If the camera was connected while the source was changed and the camera should continue to be connected,
         // reset the connection
-        if(is_connected() && state.camera.connected)
+        if(is_connected() && camera.connected)
         {
             do_disconnect();
             do_connect();
@@ -40,7 +178,7 @@ void AbstractCamera::update_state(const StateVariables& state)
     }
 
     // If the camera is connected and no longer should be, then disconnect
-    if(m_connected && !state.camera.connected)
+    if(m_connected && !camera.connected)
     {
         if(!do_disconnect())
         {
@@ -48,12 +186,26 @@ void AbstractCamera::update_state(const StateVariables& state)
         }
     }
     // If the camera is not connected and should be, then connect
-    else if(!m_connected && state.camera.connected)
+    else if(!m_connected && camera.connected)
     {
         if(!do_connect())
         {
             throw std::runtime_error("Camera failed to connect");
         }
     }
-    m_connected = state.camera.connected;
+    m_connected = camera.connected;
+
+    // Start, restart or stop the capture thread to match the state
+    if(m_connected && camera.capture_buffer_size > 0)
+    {
+        const auto capacity = static_cast<std::size_t>(camera.capture_buffer_size);
+        const FrameRing::Policy policy = camera.capture_policy == CameraSystemVars::CAPTURE_POLICY_BLOCK ?
+                                         FrameRing::Policy::BLOCK : FrameRing::Policy::DROP_OLDEST;
+        if(!m_capturing || m_capture_buffer_size != capacity || m_ring->policy() != policy)
+            start_capture(capacity, policy);
+    }
+    else
+    {
+        stop_capture();
+    }
 }
\ No newline at end of file
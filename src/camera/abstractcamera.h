@@ -4,20 +4,28 @@
 #include <vector>
 #include <opencv2/core/mat.hpp>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
 
 #include "../cmdhandler/statevariables.h"
 #include "cameracalib.h"
+#include "frame.h"
+#include "framering.h"
+#include "framepool.h"
 
 /** @brief Abstract base class for all camera types
  *
  * @note Use CameraWrapper to create a new camera. This class cannot be initialized directly, and derived classes should
  *       not be either
  * @note update_state() must be called immediately after object creation to ensure proper initialization
+ * @note Derived classes must call stop_capture() in their destructor, before their connection is torn down, since the
+ *       capture thread calls into the derived class
  */
-class AbstractCamera : public UpdateableState
+class AbstractCamera
 {
 public:
-    virtual ~AbstractCamera() = default;
+    virtual ~AbstractCamera();
     // Don't allow copying since it would mess with connections
     AbstractCamera(AbstractCamera& other) = delete;
 
@@ -91,6 +99,16 @@ public:
      */
     const std::string& get_type() const;
 
+    /** @brief Get the pixel format frames should be acquired in
+     *
+     * Camera types that can't deliver frames in other formats may ignore this and always produce PixelFormat::BGR8
+     * frames; the format of a frame is always given by Frame::format
+     *
+     * @return Requested pixel format
+     * @see CameraSystemVars::PIXEL_FORMATS
+     */
+    PixelFormat get_pixel_format() const;
+
     /** @brief Is the camera currently connected
      *
      * @return True if the camera is currently connected, false if it is not
@@ -99,26 +117,73 @@ public:
 
     /** @brief Get a frame from the camera
      *
-     * This returns the most recent frame from the camera's video feed
+     * This returns the next frame from the camera's video feed. Depending on the camera type, the frame's
+     * pixels may reference a buffer owned by the camera backend instead of a copy, see Frame. <br>
+     * If asynchronous capture is enabled (CameraSystem::capture_buffer_size > 0), the frame is taken from the capture
+     * thread's frame ring, waiting for a short time if no frame is available yet. Otherwise the frame is read from the
+     * camera on the calling thread. <br>
+     * Every frame carries the time it was captured in Frame::timestamp, see Frame
+     *
+     * @param frame [out] The frame that was retrieved
+     * @return True if the frame was successfully retrieved, false otherwise
+     */
+    bool get_frame(Frame& frame);
+
+    /** @brief Is the camera being read by an asynchronous capture thread
+     *
+     * @return True if a capture thread is currently running, false if frames are read synchronously
+     */
+    bool is_capturing() const;
+
+    /** @brief Get the amount of frames the capture thread has thrown away
+     *
+     * Frames are thrown away when the capture thread's frame ring is full and the capture policy is
+     * CameraSystemVars::CAPTURE_POLICY_DROP_OLDEST
+     *
+     * @return Amount of dropped frames since the capture thread was started, or 0 if it isn't running
+     */
+    std::uint64_t dropped_frames() const;
+
+    /** @brief Get the amount of frame buffers the camera has allocated
+     *
+     * Once the camera is running this should stop changing, see FramePool
+     *
+     * @return Amount of frame buffer allocations
+     */
+    std::uint64_t frame_allocations() const;
+
+    /** @brief Fit the camera's sensor region to a set of points
+     *
+     * If the camera supports reading out only part of its sensor and CameraSystem::auto_roi is enabled, this shrinks
+     * the sensor region to the bounding box of the given points plus CameraSystem::roi_margin. This is meant to be
+     * given the arena corners from the last detection. Camera types that don't support sensor regions ignore this
+     *
+     * @param points [in] Points in sensor coordinates (i.e. with Frame::offset added). If empty, the points were lost
+     *                    and the camera may go back to its full region
+     */
+    virtual void fit_roi(const std::vector<cv::Point2f>& points);
+
+    /** @brief Stop the asynchronous capture thread
      *
-     * @param frame [out] The frame that was retrieved as a cv::Mat
-     * @return True if the frame was successfully retrieved as a cv::Mat, false otherwise
+     * This closes the frame ring and waits for the capture thread to finish. Does nothing if the capture thread isn't
+     * running. The camera stays connected, and the next call to update_state() starts the capture thread again if the
+     * camera system asks for one
      */
-    virtual bool get_frame(cv::Mat& frame)=0;
+    void stop_capture();
 
-    /** @brief Update camera class members from the given state
+    /** @brief Update camera class members from the given camera system
      *
-     * @param state [in] State to update class members from
-     * @throws std::runtime_error if this camera type is different than the camera type in the state
+     * @param camera [in] Camera system to update class members from
+     * @throws std::runtime_error if this camera type is different than the camera type in the camera system
      */
-    void update_state(const StateVariables& state) override;
+    virtual void update_state(const CameraSystem& camera);
 
 protected:
     /** @brief Creates new AbstractCamera instance
      *
-     * @param state [in] State that this camera should get its configuration from
+     * @param camera [in] Camera system that this camera should get its configuration from
      */
-    explicit AbstractCamera(const StateVariables& state);
+    explicit AbstractCamera(const CameraSystem& camera);
 
     /** @brief Establish connection to the camera
      *
@@ -140,13 +205,74 @@ protected:
      */
     virtual bool do_disconnect()=0;
 
+    /** @brief Read a frame from the camera
+     *
+     * This reads the next frame from the camera's video feed. It's called either by get_frame() or by the capture
+     * thread, but never by both at once. Cameras with hardware timestamps should set Frame::timestamp and
+     * Frame::device_timestamp; otherwise the time the frame was read is used
+     *
+     * @param frame [out] The frame that was retrieved
+     * @return True if the frame was successfully retrieved, false otherwise
+     * @see AbstractCamera::get_frame()
+     */
+    virtual bool do_get_frame(Frame& frame)=0;
+
+    /** @brief Run a function while the capture thread is stopped
+     *
+     * This stops the capture thread (if it's running), calls the function and then starts the capture thread again
+     * with the same configuration. It's for changes to the camera that can't be made while frames are being read
+     *
+     * @param func [in] Function to run
+     * @return The return value of func
+     */
+    bool while_capture_paused(const std::function<bool()>& func);
+
+    /** @brief Give a frame a buffer from the camera's frame pool
+     *
+     * Camera types that have to produce the pixels themselves (rather than handing out a driver's buffer) should
+     * write them into a pooled frame so that no memory is allocated per frame
+     *
+     * @param frame [out] Frame to give the buffer to
+     * @param size [in] Size of the image
+     * @param type [in] OpenCV type of the image, i.e. CV_8UC1
+     * @see FramePool::acquire()
+     */
+    void acquire_frame(Frame& frame, cv::Size size, int type);
+
 private:
+    /** @brief Start the asynchronous capture thread
+     *
+     * @param capacity [in] Minimum capacity of the frame ring
+     * @param policy [in] Behavior when the frame ring is full
+     */
+    void start_capture(std::size_t capacity, FrameRing::Policy policy);
+
+    /** @brief Read a frame from the camera and make sure it's timestamped
+     *
+     * @param frame [out] The frame that was retrieved
+     * @return True if the frame was successfully retrieved, false otherwise
+     */
+    bool read_frame(Frame& frame);
+
+    /** @brief Callback function for the capture thread
+     *
+     * Reads frames from the camera and pushes them into the frame ring until capture is stopped
+     */
+    void capture_thread_func();
+
+    std::unique_ptr<FrameRing> m_ring;
+    FramePool m_pool;
+    std::thread m_capture_thread;
+    std::atomic_bool m_capturing {false};
+    std::size_t m_capture_buffer_size {0};
+
     bool m_video_output {false};
     bool m_video_postprocessing {true};
     bool m_connected {false};
 
     CameraCalib m_calib;
     std::string m_source;
+    PixelFormat m_pixel_format {PixelFormat::BGR8};
     const std::string m_type;
 };
 
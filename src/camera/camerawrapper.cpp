@@ -2,8 +2,11 @@
 #include "../cmdhandler/constants/variables.h"
 #include "opencvcamera.h"
 #include "spinnakercamera.h"
+#include "replaycamera.h"
+#include "syntheticcamera.h"
 
-CameraWrapper::CameraWrapper(StateVariables& state) : m_camera(new_camera(state))
+CameraWrapper::CameraWrapper(std::string name, const StateVariables& state) :
+        m_name(std::move(name)), m_camera(new_camera(find_camera(state)))
 {
 }
 
@@ -12,32 +15,58 @@ AbstractCamera* CameraWrapper::operator->() const noexcept
     return m_camera.get();
 }
 
+const std::string& CameraWrapper::get_name() const
+{
+    return m_name;
+}
+
 void CameraWrapper::update_state(const StateVariables& state)
 {
+    const CameraSystem& camera = find_camera(state);
     // If the camera type has changed, create a new camera of the new type
-    if(m_camera->get_type() != state.camera.type)
-        m_camera = new_camera(state);
+    if(m_camera->get_type() != camera.type)
+    {
+        // Tear down the old camera first so that both don't hold on to the same device at once
+        m_camera.reset();
+        m_camera = new_camera(camera);
+    }
     // Otherwise, just update the state of the camera
     else
-        m_camera->update_state(state);
+        m_camera->update_state(camera);
+}
+
+const CameraSystem& CameraWrapper::find_camera(const StateVariables& state) const
+{
+    const CameraSystem* camera = state.find_camera(m_name);
+    if(camera == nullptr)
+        throw std::runtime_error("Camera '" + m_name + "' does not exist");
+    return *camera;
 }
 
-std::unique_ptr<AbstractCamera> CameraWrapper::new_camera(const StateVariables& state)
+std::unique_ptr<AbstractCamera> CameraWrapper::new_camera(const CameraSystem& camera)
 {
     std::unique_ptr<AbstractCamera> ptr;
-    if(state.camera.type == CameraSystemVars::TYPE_OPENCV)
+    if(camera.type == CameraSystemVars::TYPE_OPENCV)
+    {
+        ptr = std::make_unique<OpenCvCamera>(camera);
+    }
+    else if(camera.type == CameraSystemVars::TYPE_SPINNAKER)
+    {
+        ptr = std::make_unique<SpinnakerCamera>(camera);
+    }
+    else if(camera.type == CameraSystemVars::TYPE_REPLAY)
     {
-        ptr = std::make_unique<OpenCvCamera>(state);
+        ptr = std::make_unique<ReplayCamera>(camera);
     }
-    else if(state.camera.type == CameraSystemVars::TYPE_SPINNAKER)
+    else if(camera.type == CameraSystemVars::TYPE_SYNTHETIC)
     {
-        ptr = std::make_unique<SpinnakerCamera>(state);
+        ptr = std::make_unique<SyntheticCamera>(camera);
     }
     else
     {
-        throw std::runtime_error("Invalid camera type '" + state.camera.type + "'");
+        throw std::runtime_error("Invalid camera type '" + camera.type + "'");
     }
 
-    ptr->update_state(state);
+    ptr->update_state(camera);
     return ptr;
 }
\ No newline at end of file
@@ -3,11 +3,14 @@
 
 #include "abstractcamera.h"
 #include <memory>
+#include <string>
 
 /** @brief Wrapper for initializing cameras
  *
  * This is a wrapper class for AbstractCamera and derivative classes. Internally it holds a smart pointer to an
- * AbstractCamera. It's mainly for easily managing the multiple possible camera types
+ * AbstractCamera. It's mainly for easily managing the multiple possible camera types. <br>
+ * Each wrapper is bound to one camera by name (see Variables::find_camera()), so that several cameras can be run side
+ * by side from the same program state
  *
  */
 class CameraWrapper : public UpdateableState
@@ -15,10 +18,11 @@ class CameraWrapper : public UpdateableState
 public:
      /** @brief Create a new CameraWrapper instance
      *
+     * @param name [in] Name of the camera within the program state
      * @param variables [in] Current program state
-     * @throws std::runtime_error If camera type within current state is invalid
+     * @throws std::runtime_error If the camera doesn't exist or its type within current state is invalid
      */
-    explicit CameraWrapper(StateVariables& variables);
+    CameraWrapper(std::string name, const StateVariables& variables);
 
     // Gets the current camera instance
     // NOTE: DO NOT STORE THIS!! If this pointer is stored somewhere and the internal camera pointer changes,
@@ -46,19 +50,34 @@ public:
      */
     void update_state(const StateVariables& state) override;
 
+    /** @brief Get the name of the wrapped camera
+     *
+     * @return Name of the camera within the program state
+     */
+    const std::string& get_name() const;
+
 private:
+    const std::string m_name;
     std::unique_ptr<AbstractCamera> m_camera;
 
+    /** @brief Get this wrapper's camera system from the program state
+     *
+     * @param state [in] Current program state
+     * @return The camera system with this wrapper's name
+     * @throws std::runtime_error if there is no camera with this wrapper's name
+     */
+    const CameraSystem& find_camera(const StateVariables& state) const;
+
     /** @brief Create a new AbstractCamera instance
      *
-     * This creates a new instance of an AbstractCamera derivative based on the current program state and casts it
+     * This creates a new instance of an AbstractCamera derivative based on the given camera system and casts it
      * back into an AbstractCamera using a smart pointer
      *
-     * @param state Current program state
+     * @param camera Camera system to create the camera from
      * @return Smart pointer to AbstractCamera instance
-     * @throws std::runtime_error if camera type in state is invalid
+     * @throws std::runtime_error if camera type in the camera system is invalid
      */
-    static std::unique_ptr<AbstractCamera> new_camera(const StateVariables& state);
+    static std::unique_ptr<AbstractCamera> new_camera(const CameraSystem& camera);
 };
 
 
@@ -0,0 +1,51 @@
+#include "frame.h"
+#include <opencv2/imgproc.hpp>
+
+// OpenCV names its Bayer conversions after the pattern starting at the second row and column, so an RGGB sensor
+// pattern is OpenCV's 'BG' pattern
+constexpr int BAYER_RG_TO_GRAY = cv::COLOR_BayerBG2GRAY;
+constexpr int BAYER_RG_TO_BGR = cv::COLOR_BayerBG2BGR;
+
+cv::Mat Frame::gray() const
+{
+    cv::Mat gray_image;
+    return gray(gray_image);
+}
+
+cv::Mat Frame::gray(cv::Mat& gray_image) const
+{
+    switch(format)
+    {
+        case PixelFormat::MONO8:
+            return image;
+        case PixelFormat::BAYER_RG8:
+            cv::cvtColor(image, gray_image, BAYER_RG_TO_GRAY);
+            break;
+        case PixelFormat::BGR8:
+            cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+            break;
+    }
+    return gray_image;
+}
+
+cv::Mat Frame::bgr() const
+{
+    cv::Mat bgr_image;
+    return bgr(bgr_image);
+}
+
+cv::Mat Frame::bgr(cv::Mat& bgr_image) const
+{
+    switch(format)
+    {
+        case PixelFormat::BGR8:
+            return image;
+        case PixelFormat::BAYER_RG8:
+            cv::cvtColor(image, bgr_image, BAYER_RG_TO_BGR);
+            break;
+        case PixelFormat::MONO8:
+            cv::cvtColor(image, bgr_image, cv::COLOR_GRAY2BGR);
+            break;
+    }
+    return bgr_image;
+}
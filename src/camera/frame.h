@@ -0,0 +1,139 @@
+#ifndef MELON_FRAME_H
+#define MELON_FRAME_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+/** @brief Layout of the pixel data in a Frame
+ *
+ */
+enum class PixelFormat
+{
+    /// 3 channels, 8 bits per channel, blue-green-red
+    BGR8,
+    /// 1 channel, 8 bits
+    MONO8,
+    /// 1 channel, 8 bits, raw sensor data with an RGGB Bayer filter pattern
+    BAYER_RG8
+};
+
+/** @brief Known position and pose of a marker within a frame
+ *
+ * This is only known for frames that were rendered rather than captured, see SyntheticCamera
+ */
+struct MarkerTruth
+{
+    int id;
+    /// Corners in sensor coordinates, in the same order as detected by cv::aruco::detectMarkers()
+    std::vector<cv::Point2f> corners;
+    /// Rotation and translation of the marker relative to the camera
+    cv::Vec3d rvec, tvec;
+};
+
+/** @brief A single frame retrieved from a camera
+ *
+ * The pixel data in Frame::image is not necessarily owned by the cv::Mat itself. Camera backends that can hand out
+ * their own buffers (i.e. the Spinnaker driver's image buffers) wrap that memory directly in the cv::Mat and store
+ * whatever keeps the memory valid in Frame::owner. The buffer is given back to the backend once the last copy of the
+ * Frame (and so the last reference to the owner) is destroyed, so a Frame can be passed to other stages without any
+ * pixel copies.
+ *
+ * @note Holding on to frames for a long time may starve the camera backend of buffers. Stages that need to keep the
+ *       pixels around longer than a few frames should use Frame::detach()
+ */
+struct Frame
+{
+    /// Pixel data for the frame
+    cv::Mat image;
+    /// Keeps the memory referenced by Frame::image alive. Null if Frame::image owns its own memory
+    std::shared_ptr<const void> owner;
+    /// Layout of the pixel data in Frame::image
+    PixelFormat format = PixelFormat::BGR8;
+    /// Position of the frame's top-left pixel on the sensor, for cameras that only read out a region of the sensor
+    cv::Point offset;
+    /// When the frame was captured. Cameras with hardware timestamps map them onto this clock, others use the time
+    /// the frame was read
+    std::chrono::steady_clock::time_point timestamp;
+    /// The camera's own timestamp for the frame in nanoseconds, on the camera's clock. 0 if the camera has none
+    std::int64_t device_timestamp = 0;
+    /// Position of the frame in its camera's pipeline, counting up from 0. Set by the pipeline, not the camera
+    std::uint64_t sequence = 0;
+    /// Markers known to be in the frame. Null unless the camera knows what it's looking at
+    std::shared_ptr<const std::vector<MarkerTruth>> ground_truth;
+
+    /** @brief Get a grayscale version of the frame
+     *
+     * This is meant for detection, which only needs intensity. For PixelFormat::MONO8 frames no conversion or copy is
+     * done. BGR and Bayer frames are converted into a new single channel image
+     *
+     * @return Single channel, 8 bit image
+     */
+    cv::Mat gray() const;
+
+    /** @brief Get a grayscale version of the frame, converting into a reusable buffer
+     *
+     * Same as Frame::gray(), but a conversion is written into the given buffer. The buffer's memory is reused if it
+     * already has the right size, so converting every frame into the same buffer doesn't allocate
+     *
+     * @note The buffer's memory must not be referenced anywhere else, since it's overwritten
+     *
+     * @param buffer [in, out] Buffer for the converted image
+     * @return Single channel, 8 bit image. Either Frame::image or the buffer
+     */
+    cv::Mat gray(cv::Mat& buffer) const;
+
+    /** @brief Get a BGR version of the frame
+     *
+     * This is meant for video output and post processing. For PixelFormat::BGR8 frames no conversion or copy is done.
+     * Bayer frames are demosaiced and mono frames are expanded to 3 channels, so this should only be called when the
+     * color image is actually needed
+     *
+     * @return 3 channel, 8 bit image
+     */
+    cv::Mat bgr() const;
+
+    /** @brief Get a BGR version of the frame, converting into a reusable buffer
+     *
+     * Same as Frame::bgr(), but a conversion is written into the given buffer, see Frame::gray(cv::Mat&)
+     *
+     * @param buffer [in, out] Buffer for the converted image
+     * @return 3 channel, 8 bit image. Either Frame::image or the buffer
+     */
+    cv::Mat bgr(cv::Mat& buffer) const;
+
+    /** @brief Does this frame reference memory owned by a camera backend
+     *
+     * @return True if Frame::image points to backend-owned memory, false if it owns its memory
+     */
+    bool is_borrowed() const { return owner != nullptr; }
+
+    /** @brief Copy the pixel data into memory owned by this frame
+     *
+     * This performs a deep copy of Frame::image if it references backend-owned memory and then lets go of the
+     * backend's buffer. If the frame already owns its memory, this does nothing
+     */
+    void detach()
+    {
+        if(!is_borrowed())
+            return;
+        image = image.clone();
+        owner.reset();
+    }
+
+    /** @brief Release the frame's pixel data
+     *
+     * This drops the reference to the pixel data (and returns the buffer to its camera backend if this was the last
+     * reference to it)
+     */
+    void release()
+    {
+        image.release();
+        owner.reset();
+        ground_truth.reset();
+    }
+};
+
+#endif //MELON_FRAME_H
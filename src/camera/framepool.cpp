@@ -0,0 +1,72 @@
+#include "framepool.h"
+#include <new>
+
+// Buffers are aligned to and sized in multiples of a memory page
+constexpr std::size_t PAGE_SIZE = 4096;
+
+FramePool::Buffer::Buffer(std::size_t bytes) :
+        data(::operator new(bytes, std::align_val_t(PAGE_SIZE))),
+        bytes(bytes)
+{
+}
+
+FramePool::Buffer::~Buffer()
+{
+    ::operator delete(data, std::align_val_t(PAGE_SIZE));
+}
+
+void FramePool::allocate()
+{
+    const std::size_t row_bytes = static_cast<std::size_t>(m_size.width) * CV_ELEM_SIZE(m_type);
+    const std::size_t bytes = (row_bytes * m_size.height + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    m_buffers.push_back(std::make_shared<Buffer>(bytes));
+    ++m_allocations;
+}
+
+void FramePool::acquire(Frame& frame, cv::Size size, int type, std::size_t count)
+{
+    // Release the frame's previous buffer first, so that it can be reused if it came from this pool
+    frame.release();
+
+    std::shared_ptr<Buffer> buffer;
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+
+        // Start over with a new set of buffers if the resolution changed
+        if(size != m_size || type != m_type)
+        {
+            m_buffers.clear();
+            m_size = size;
+            m_type = type;
+            m_next = 0;
+            for(std::size_t i = 0; i < count; ++i)
+                allocate();
+        }
+
+        // A buffer is free if the pool holds the only reference to it. Only the pool hands out new references, and
+        // it only does so under the lock, so a free buffer can't be taken by anyone else in the meantime
+        for(std::size_t i = 0; i < m_buffers.size() && !buffer; ++i)
+        {
+            const std::size_t index = (m_next + i) % m_buffers.size();
+            if(m_buffers[index].use_count() == 1)
+            {
+                buffer = m_buffers[index];
+                m_next = index + 1;
+            }
+        }
+
+        if(!buffer)
+        {
+            allocate();
+            buffer = m_buffers.back();
+        }
+    }
+
+    frame.image = cv::Mat(size, type, buffer->data);
+    frame.owner = std::move(buffer);
+}
+
+std::uint64_t FramePool::allocations() const
+{
+    return m_allocations;
+}
\ No newline at end of file
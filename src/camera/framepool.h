@@ -0,0 +1,79 @@
+#ifndef MELON_FRAMEPOOL_H
+#define MELON_FRAMEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "frame.h"
+
+/** @brief Pool of preallocated frame buffers
+ *
+ * This hands out page-aligned buffers of a single resolution and type, so that frames don't need a fresh heap
+ * allocation each. A buffer is given to a frame as its Frame::owner and goes back to the pool on its own once the
+ * last copy of the frame is gone. <br>
+ * The buffers are allocated the first time a resolution is asked for. If the resolution changes, the pool lets go of
+ * its buffers (frames still using them keep them alive) and allocates a new set. If every buffer is in use, one more
+ * is allocated and kept, so a pool that is too small grows to what the pipeline needs. FramePool::allocations()
+ * counts every buffer allocation, so in steady state it should stop changing
+ *
+ * @note Thread safe
+ */
+class FramePool
+{
+public:
+    FramePool() = default;
+    FramePool(const FramePool& other) = delete;
+
+    /** @brief Give a frame a buffer from the pool
+     *
+     * This sets Frame::image to an image of the given size and type backed by a pooled buffer, and Frame::owner to
+     * the buffer. The contents of the image are undefined. <br>
+     * OpenCV functions reallocate an output image that doesn't have the size or type they need, so backends that
+     * write into the image should check that its data pointer didn't change, and reset Frame::owner if it did
+     *
+     * @param frame [out] Frame to give the buffer to
+     * @param size [in] Size of the image
+     * @param type [in] OpenCV type of the image, i.e. CV_8UC1
+     * @param count [in] Amount of buffers to preallocate if the pool has to be (re)filled
+     */
+    void acquire(Frame& frame, cv::Size size, int type, std::size_t count);
+
+    /** @brief Get the amount of buffers that have been allocated
+     *
+     * @return Total amount of buffer allocations since the pool was created
+     */
+    std::uint64_t allocations() const;
+
+private:
+    /** @brief A single page-aligned buffer
+     *
+     */
+    struct Buffer
+    {
+        explicit Buffer(std::size_t bytes);
+        ~Buffer();
+        Buffer(const Buffer& other) = delete;
+
+        void* data;
+        std::size_t bytes;
+    };
+
+    /** @brief Allocate a new buffer for the pool's current resolution
+     *
+     * @note m_mutex must be held
+     */
+    void allocate();
+
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<Buffer>> m_buffers;
+    cv::Size m_size;
+    int m_type {-1};
+    // Where to start looking for a free buffer
+    std::size_t m_next {0};
+    std::atomic<std::uint64_t> m_allocations {0};
+};
+
+#endif //MELON_FRAMEPOOL_H
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "framering.h"
+#include <thread>
+
+/** @brief Round a number up to the next power of two
+ *
+ * @param value [in] Value to round
+ * @return Smallest power of two that is greater than or equal to value (and at least 2)
+ */
+static std::size_t next_power_of_two(std::size_t value)
+{
+    std::size_t result = 2;
+    while(result < value)
+        result <<= 1;
+    return result;
+}
+
+/** @brief Back off while waiting on the ring
+ *
+ * Spins by yielding for the first few attempts and then starts sleeping so that a waiting thread doesn't burn a core
+ *
+ * @param attempt [in, out] Amount of times the caller has backed off so far
+ */
+static void backoff(unsigned int& attempt)
+{
+    if(attempt++ < 64)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+FrameRing::FrameRing(std::size_t capacity, Policy policy) :
+        m_mask(next_power_of_two(capacity) - 1),
+        m_policy(policy),
+        m_cells(new Cell[m_mask + 1])
+{
+    for(std::size_t i = 0; i <= m_mask; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool FrameRing::try_push(Frame& frame)
+{
+    Cell* cell;
+    std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    while(true)
+    {
+        cell = &m_cells[pos & m_mask];
+        const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+        // The cell is free for this position, try to claim it
+        if(diff == 0)
+        {
+            if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        // The cell still holds a frame from the previous lap, so the ring is full
+        else if(diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->frame = std::move(frame);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameRing::try_pop(Frame& frame)
+{
+    Cell* cell;
+    std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    while(true)
+    {
+        cell = &m_cells[pos & m_mask];
+        const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+        // The cell holds a frame for this position, try to claim it
+        if(diff == 0)
+        {
+            if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        // The cell hasn't been written yet, so the ring is empty
+        else if(diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    frame = std::move(cell->frame);
+    // Make sure the cell doesn't keep a camera buffer alive until it's overwritten
+    cell->frame.release();
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameRing::push(Frame frame)
+{
+    unsigned int attempt = 0;
+    while(!try_push(frame))
+    {
+        if(m_closed)
+            return false;
+
+        if(m_policy == Policy::DROP_OLDEST)
+        {
+            // Make space by throwing away the oldest frame. A consumer may have taken it first, in which case
+            // there is space now anyways
+            Frame oldest;
+            if(try_pop(oldest))
+                ++m_dropped;
+        }
+        else
+        {
+            backoff(attempt);
+        }
+    }
+
+    ++m_pushed;
+    return true;
+}
+
+bool FrameRing::pop(Frame& frame, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    unsigned int attempt = 0;
+    while(!try_pop(frame))
+    {
+        if(m_closed || std::chrono::steady_clock::now() >= deadline)
+            return false;
+        backoff(attempt);
+    }
+    return true;
+}
+
+void FrameRing::close() { m_closed = true; }
+bool FrameRing::is_closed() const { return m_closed; }
+std::size_t FrameRing::capacity() const { return m_mask + 1; }
+FrameRing::Policy FrameRing::policy() const { return m_policy; }
+std::uint64_t FrameRing::dropped_frames() const { return m_dropped; }
+std::uint64_t FrameRing::pushed_frames() const { return m_pushed; }
@@ -0,0 +1,131 @@
+#ifndef MELON_FRAMERING_H
+#define MELON_FRAMERING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include "frame.h"
+
+/** @brief Fixed-capacity, lock-free ring buffer of frames
+ *
+ * This is a bounded queue for passing frames from a single producer (the camera's capture thread) to any number of
+ * consumers without locking. Every frame is handed to exactly one consumer. <br>
+ * What happens when the ring is full is determined by the ring's policy, see FrameRing::Policy
+ *
+ * @note Internally this is a sequence-numbered ring (Vyukov's bounded queue), so the capacity is rounded up to the
+ *       next power of two
+ */
+class FrameRing
+{
+public:
+    /** @brief Behavior of FrameRing::push() when the ring is full
+     *
+     */
+    enum class Policy
+    {
+        /// Throw away the oldest frame in the ring to make space for the new one. This never blocks the producer
+        DROP_OLDEST,
+        /// Wait until a consumer has taken a frame out of the ring
+        BLOCK
+    };
+
+    /** @brief Create a new ring
+     *
+     * @param capacity [in] Minimum amount of frames the ring can hold
+     * @param policy [in] Behavior when pushing to a full ring
+     */
+    FrameRing(std::size_t capacity, Policy policy);
+    FrameRing(const FrameRing& other) = delete;
+
+    /** @brief Add a frame to the ring
+     *
+     * If the ring is full, the frame is added according to the ring's policy
+     *
+     * @note Only one thread may push to the ring
+     *
+     * @param frame [in] Frame to add
+     * @return True if the frame was added, false if the ring was closed
+     */
+    bool push(Frame frame);
+
+    /** @brief Take the oldest frame out of the ring without waiting
+     *
+     * @param frame [out] Frame that was taken out of the ring
+     * @return True if a frame was taken, false if the ring was empty
+     */
+    bool try_pop(Frame& frame);
+
+    /** @brief Take the oldest frame out of the ring, waiting for one if the ring is empty
+     *
+     * @param frame [out] Frame that was taken out of the ring
+     * @param timeout [in] Maximum amount of time to wait for a frame
+     * @return True if a frame was taken, false if the timeout was reached or the ring was closed while empty
+     */
+    bool pop(Frame& frame, std::chrono::milliseconds timeout);
+
+    /** @brief Close the ring
+     *
+     * This wakes up a producer that is blocked in FrameRing::push() and makes any further pushes fail. Frames that
+     * are already in the ring can still be taken out
+     */
+    void close();
+
+    /** @brief Has the ring been closed
+     *
+     * @return True if FrameRing::close() has been called
+     */
+    bool is_closed() const;
+
+    /** @brief Get the amount of frames the ring can hold
+     *
+     * @return Capacity of the ring
+     */
+    std::size_t capacity() const;
+
+    /** @brief Get the ring's policy when full
+     *
+     * @return The ring's policy
+     */
+    Policy policy() const;
+
+    /** @brief Get the amount of frames thrown away because the ring was full
+     *
+     * @return Amount of dropped frames
+     */
+    std::uint64_t dropped_frames() const;
+
+    /** @brief Get the amount of frames that have been added to the ring
+     *
+     * @return Amount of pushed frames
+     */
+    std::uint64_t pushed_frames() const;
+
+private:
+    /** @brief Add a frame to the ring if there is space
+     *
+     * @param frame [in, out] Frame to add. It is only moved from if it was added
+     * @return True if the frame was added, false if the ring was full
+     */
+    bool try_push(Frame& frame);
+
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        Frame frame;
+    };
+
+    const std::size_t m_mask;
+    const Policy m_policy;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // Keep the producer and consumer positions on separate cache lines so that they don't fight over one
+    alignas(64) std::atomic<std::size_t> m_enqueue_pos {0};
+    alignas(64) std::atomic<std::size_t> m_dequeue_pos {0};
+
+    std::atomic_bool m_closed {false};
+    std::atomic<std::uint64_t> m_dropped {0};
+    std::atomic<std::uint64_t> m_pushed {0};
+};
+
+#endif //MELON_FRAMERING_H
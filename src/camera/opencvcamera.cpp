@@ -1,10 +1,15 @@
 #include "opencvcamera.h"
 #include <charconv>
 
-OpenCvCamera::OpenCvCamera(const StateVariables& state) : AbstractCamera(state)
+OpenCvCamera::OpenCvCamera(const CameraSystem& camera) : AbstractCamera(camera)
 {
 }
 
+OpenCvCamera::~OpenCvCamera()
+{
+    stop_capture();
+}
+
 bool OpenCvCamera::do_connect()
 {
     // Get a local variable reference since we'll be using this string in several places
@@ -24,11 +29,38 @@ bool OpenCvCamera::do_connect()
 bool OpenCvCamera::do_disconnect()
 {
     m_video_feed.release();
+    m_frame_size = cv::Size();
     // OpenCV video feed doesn't return any success/error messages on disconnect, so just return true
     return true;
 }
 
-bool OpenCvCamera::get_frame(cv::Mat& frame)
+bool OpenCvCamera::do_get_frame(Frame& frame)
 {
-    return m_video_feed.grab() && m_video_feed.retrieve(frame);
+    if(!m_video_feed.grab())
+        return false;
+
+    // Retrieve into a buffer from the frame pool rather than into whatever frame.image was. VideoCapture reuses the
+    // memory of the Mat it's given, which would overwrite the pixels of a previous frame that is still referenced
+    // elsewhere. The resolution isn't known until the first frame, so that one is retrieved into a fresh Mat
+    if(m_frame_size.empty())
+        frame.release();
+    else
+        acquire_frame(frame, m_frame_size, CV_8UC3);
+
+    const uchar* pooled_data = frame.image.data;
+    if(!m_video_feed.retrieve(frame.image))
+        return false;
+
+    // VideoCapture reallocated the image, so it doesn't belong to the pool. This happens for the first frame and
+    // when the resolution changes
+    if(frame.image.data != pooled_data)
+    {
+        frame.owner.reset();
+        m_frame_size = frame.image.size();
+    }
+
+    // VideoCapture always converts to BGR, the requested pixel format doesn't apply to this camera type
+    frame.format = PixelFormat::BGR8;
+    frame.offset = cv::Point();
+    return true;
 }
\ No newline at end of file
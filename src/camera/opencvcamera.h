@@ -11,16 +11,18 @@
 class OpenCvCamera : public AbstractCamera
 {
 public:
-    explicit OpenCvCamera(const StateVariables& state);
-
-    bool get_frame(cv::Mat& frame) override;
+    explicit OpenCvCamera(const CameraSystem& camera);
+    ~OpenCvCamera() override;
 
 protected:
     bool do_disconnect() override;
     bool do_connect() override;
+    bool do_get_frame(Frame& frame) override;
 
 private:
     cv::VideoCapture m_video_feed;
+    // Resolution of the video feed, known after the first frame
+    cv::Size m_frame_size;
 };
 
 
@@ -0,0 +1,382 @@
+#include "replaycamera.h"
+#include "../cmdhandler/constants/variables.h"
+#include <spdlog/spdlog.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <thread>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File within an image directory containing the time each image was recorded at
+const std::string TIMESTAMPS_FILE = "timestamps.txt";
+// Extensions of the files within an image directory that are replayed
+const std::array<const char*, 8> IMAGE_EXTENSIONS = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".pgm", ".ppm"};
+
+/** @brief Read-only view of a file's contents
+ *
+ * On Unix systems the file is memory mapped, so its pages are only read from disk (or the page cache) when the image
+ * is decoded. Elsewhere the file is read into memory
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#ifdef __unix__
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return;
+        struct stat st {};
+        if(::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED)
+            {
+                m_data = static_cast<const unsigned char*>(data);
+                m_size = st.st_size;
+            }
+        }
+        // The mapping stays valid after the file is closed
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef __unix__
+        if(m_data != nullptr)
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    }
+
+    MappedFile(const MappedFile& other) = delete;
+
+    /** @brief Wrap the file's contents in a cv::Mat for decoding
+     *
+     * @return Single row matrix referencing the file's contents, without copying
+     */
+    cv::Mat as_mat() const
+    {
+        return cv::Mat(1, static_cast<int>(m_size), CV_8UC1, const_cast<unsigned char*>(m_data));
+    }
+
+    bool is_open() const { return m_data != nullptr && m_size > 0; }
+
+private:
+    const unsigned char* m_data {nullptr};
+    std::size_t m_size {0};
+#ifndef __unix__
+    std::vector<unsigned char> m_buffer;
+#endif
+};
+
+ReplayCamera::ReplayCamera(const CameraSystem& camera) :
+        AbstractCamera(camera),
+        m_replay_mode(camera.replay_mode),
+        m_frame_rate(camera.frame_rate),
+        m_preload(camera.replay_preload),
+        m_loop(camera.replay_loop)
+{
+}
+
+ReplayCamera::~ReplayCamera()
+{
+    stop_capture();
+    if(is_connected())
+        do_disconnect();
+}
+
+int ReplayCamera::imread_flags() const
+{
+    // Decoding straight to grayscale means detection never has to convert the frame
+    return get_pixel_format() == PixelFormat::MONO8 ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+}
+
+bool ReplayCamera::do_connect()
+{
+    const std::filesystem::path source(get_source());
+    std::error_code ec;
+    const bool opened = std::filesystem::is_directory(source, ec) ? open_directory(source) : open_video(get_source());
+    if(!opened)
+        return false;
+
+    if(m_preload)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Frame frame;
+        double timestamp;
+        while(read_next(frame, timestamp))
+        {
+            // Pooled buffers get reused, so every preloaded frame needs its own copy
+            frame.detach();
+            m_preloaded.push_back(frame.image);
+            // Videos only know their timestamps while being read
+            if(m_video.isOpened())
+                m_timestamps.push_back(timestamp);
+        }
+        // Everything is in memory now, so let go of the source
+        m_mapped_files.clear();
+        m_video.release();
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        spdlog::info("Preloaded {} frames from '{}' in {}ms", m_preloaded.size(), get_source(), elapsed.count());
+        if(m_preloaded.empty())
+            return false;
+    }
+
+    rewind();
+    return true;
+}
+
+bool ReplayCamera::open_directory(const std::filesystem::path& directory)
+{
+    for(const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        if(!entry.is_regular_file())
+            continue;
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if(std::find(IMAGE_EXTENSIONS.begin(), IMAGE_EXTENSIONS.end(), extension) != IMAGE_EXTENSIONS.end())
+            m_files.push_back(entry.path());
+    }
+    std::sort(m_files.begin(), m_files.end());
+
+    if(m_files.empty())
+    {
+        spdlog::critical("No images found in '{}'", directory.string());
+        return false;
+    }
+
+    // Map the images now so that opening files doesn't happen while replaying
+    for(const auto& file : m_files)
+    {
+        auto mapped = std::make_shared<MappedFile>(file);
+        if(!mapped->is_open())
+        {
+            spdlog::critical("Failed to open '{}'", file.string());
+            return false;
+        }
+        m_mapped_files.push_back(mapped);
+    }
+
+    // Read the recorded timestamps, if there are any
+    std::ifstream timestamps_file(directory / TIMESTAMPS_FILE);
+    double timestamp;
+    while(timestamps_file >> timestamp)
+        m_timestamps.push_back(timestamp);
+    if(!m_timestamps.empty() && m_timestamps.size() != m_files.size())
+    {
+        spdlog::warn("'{}' has {} timestamps for {} images, ignoring it", TIMESTAMPS_FILE, m_timestamps.size(),
+                     m_files.size());
+        m_timestamps.clear();
+    }
+
+    spdlog::info("Replaying {} images from '{}'", m_files.size(), directory.string());
+    return true;
+}
+
+bool ReplayCamera::open_video(const std::string& file)
+{
+    if(!m_video.open(file))
+    {
+        spdlog::critical("Failed to open video '{}'", file);
+        return false;
+    }
+
+    spdlog::info("Replaying video '{}'", file);
+    return true;
+}
+
+bool ReplayCamera::do_disconnect()
+{
+    m_files.clear();
+    m_mapped_files.clear();
+    m_video.release();
+    m_preloaded.clear();
+    m_timestamps.clear();
+    m_decoded.release();
+    m_frame_size = cv::Size();
+    m_index = 0;
+    return true;
+}
+
+void ReplayCamera::acquire_pooled(Frame& frame)
+{
+    // The resolution isn't known until the first frame has been decoded, so that one is decoded into a fresh image
+    if(m_frame_size.empty())
+        frame.release();
+    else
+        acquire_frame(frame, m_frame_size, frame_type());
+}
+
+void ReplayCamera::check_pooled(Frame& frame, const uchar* pooled_data)
+{
+    // OpenCV reallocated the image because the resolution changed (or wasn't known yet), so it isn't pooled
+    if(frame.image.data != pooled_data)
+    {
+        frame.owner.reset();
+        m_frame_size = frame.image.size();
+    }
+}
+
+int ReplayCamera::frame_type() const
+{
+    return get_pixel_format() == PixelFormat::MONO8 ? CV_8UC1 : CV_8UC3;
+}
+
+bool ReplayCamera::read_next(Frame& frame, double& timestamp)
+{
+    timestamp = -1;
+    if(!m_preloaded.empty())
+    {
+        if(m_index >= m_preloaded.size())
+            return false;
+        // Share the preloaded frame instead of copying it
+        frame.release();
+        frame.image = m_preloaded[m_index];
+    }
+    else if(!m_mapped_files.empty())
+    {
+        // Skip over images that fail to decode
+        while(true)
+        {
+            if(m_index >= m_mapped_files.size())
+                return false;
+            acquire_pooled(frame);
+            const uchar* pooled_data = frame.image.data;
+            cv::imdecode(m_mapped_files[m_index]->as_mat(), imread_flags(), &frame.image);
+            if(!frame.image.empty())
+            {
+                check_pooled(frame, pooled_data);
+                break;
+            }
+            spdlog::warn("Failed to decode '{}'", m_files[m_index].string());
+            ++m_index;
+        }
+    }
+    else if(m_video.isOpened())
+    {
+        acquire_pooled(frame);
+        const uchar* pooled_data = frame.image.data;
+        // VideoCapture always decodes to BGR, so grayscale frames are decoded into a scratch image first
+        if(get_pixel_format() == PixelFormat::MONO8)
+        {
+            if(!m_video.read(m_decoded))
+                return false;
+            cv::cvtColor(m_decoded, frame.image, cv::COLOR_BGR2GRAY);
+        }
+        else if(!m_video.read(frame.image))
+        {
+            return false;
+        }
+        check_pooled(frame, pooled_data);
+        timestamp = m_video.get(cv::CAP_PROP_POS_MSEC);
+    }
+    else
+    {
+        return false;
+    }
+
+    if(m_index < m_timestamps.size())
+        timestamp = m_timestamps[m_index];
+    ++m_index;
+    return true;
+}
+
+void ReplayCamera::rewind()
+{
+    m_index = 0;
+    m_frames_replayed = 0;
+    if(m_preloaded.empty() && m_video.isOpened())
+        m_video.set(cv::CAP_PROP_POS_FRAMES, 0);
+}
+
+void ReplayCamera::wait_until_due(double timestamp)
+{
+    const auto now = std::chrono::steady_clock::now();
+    // The first frame sets the starting point that every other frame is paced from
+    if(m_frames_replayed == 0)
+    {
+        m_replay_start = now;
+        m_first_timestamp = timestamp;
+        return;
+    }
+
+    std::chrono::duration<double, std::milli> offset;
+    if(m_replay_mode == CameraSystemVars::REPLAY_MODE_FIXED && m_frame_rate > 0)
+        offset = std::chrono::duration<double, std::milli>(1000.0 * m_frames_replayed / m_frame_rate);
+    else if(m_replay_mode == CameraSystemVars::REPLAY_MODE_RECORDED && timestamp >= 0 && m_first_timestamp >= 0)
+        offset = std::chrono::duration<double, std::milli>(timestamp - m_first_timestamp);
+    else
+        return;
+
+    std::this_thread::sleep_until(m_replay_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+}
+
+bool ReplayCamera::do_get_frame(Frame& frame)
+{
+    double timestamp;
+    if(!read_next(frame, timestamp))
+    {
+        if(!m_loop)
+            return false;
+        rewind();
+        if(!read_next(frame, timestamp))
+            return false;
+    }
+
+    wait_until_due(timestamp);
+    ++m_frames_replayed;
+
+    frame.format = frame.image.channels() == 1 ? PixelFormat::MONO8 : PixelFormat::BGR8;
+    frame.offset = cv::Point();
+    return true;
+}
+
+void ReplayCamera::update_state(const CameraSystem& camera)
+{
+    const bool replay_changed = camera.replay_mode != m_replay_mode ||
+                                camera.frame_rate != m_frame_rate ||
+                                camera.replay_loop != m_loop ||
+                                camera.replay_preload != m_preload;
+    if(replay_changed)
+    {
+        // Preloading only happens while connecting, so the footage has to be reopened if it changed. This isn't
+        // needed if the base class is going to reconnect anyways
+        const bool reopen = camera.replay_preload != m_preload && is_connected() && camera.connected &&
+                            camera.source == get_source();
+
+        // The capture thread reads these while replaying
+        const bool success = while_capture_paused([&]()
+        {
+            m_replay_mode = camera.replay_mode;
+            m_frame_rate = camera.frame_rate;
+            m_loop = camera.replay_loop;
+            m_preload = camera.replay_preload;
+            if(!reopen)
+                return true;
+            do_disconnect();
+            return do_connect();
+        });
+
+        if(!success)
+            throw std::runtime_error("Replay camera failed to reopen its footage");
+    }
+
+    AbstractCamera::update_state(camera);
+}
\ No newline at end of file
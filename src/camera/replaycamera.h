@@ -0,0 +1,127 @@
+#ifndef MELON_REPLAYCAMERA_H
+#define MELON_REPLAYCAMERA_H
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "abstractcamera.h"
+
+class MappedFile;
+
+/** @brief A camera that replays recorded footage
+ *
+ * This class is for replaying recorded footage through the pipeline as if it came from a live camera, so that
+ * throughput can be measured reproducibly without any camera attached. The camera's source is either a video file or
+ * a directory of images, which are replayed in file name order. <br>
+ * Frames are replayed according to CameraSystem::replay_mode:
+ * - CameraSystemVars::REPLAY_MODE_FAST replays frames as fast as they are requested
+ * - CameraSystemVars::REPLAY_MODE_FIXED replays frames at CameraSystem::frame_rate
+ * - CameraSystemVars::REPLAY_MODE_RECORDED replays frames at the times they were recorded. For videos this is the
+ *   video's own timestamps; for directories it's a 'timestamps.txt' file within the directory containing one time in
+ *   milliseconds per image
+ *
+ * With CameraSystem::replay_preload, every frame is decoded into memory when connecting so that replaying does no
+ * decoding at all. Otherwise images are memory mapped when connecting and decoded as they are replayed, and videos
+ * are decoded as they are replayed
+ *
+ * @note Preloaded frames are handed out without copying, so stages must not draw onto Frame::image directly
+ */
+class ReplayCamera : public AbstractCamera
+{
+public:
+    explicit ReplayCamera(const CameraSystem& camera);
+    ~ReplayCamera() override;
+
+    void update_state(const CameraSystem& camera) override;
+
+protected:
+    bool do_disconnect() override;
+    bool do_connect() override;
+    bool do_get_frame(Frame& frame) override;
+
+private:
+    /** @brief Find and load the images within a directory source
+     *
+     * @param directory [in] Directory containing the images
+     * @return True if at least one image was found
+     */
+    bool open_directory(const std::filesystem::path& directory);
+
+    /** @brief Open a video file source
+     *
+     * @param file [in] Path to the video file
+     * @return True if the video could be opened
+     */
+    bool open_video(const std::string& file);
+
+    /** @brief Read the next frame from the source without pacing
+     *
+     * Frames are decoded into buffers from the camera's frame pool, except for preloaded frames which are shared
+     *
+     * @param frame [out] The decoded frame
+     * @param timestamp [out] Time that the frame was recorded at, in milliseconds, or a negative value if unknown
+     * @return True if a frame was read, false if the end of the footage was reached or it couldn't be decoded
+     */
+    bool read_next(Frame& frame, double& timestamp);
+
+    /** @brief Give a frame a pooled buffer for the footage's resolution, if it's known yet
+     *
+     * @param frame [out] Frame to give the buffer to
+     */
+    void acquire_pooled(Frame& frame);
+
+    /** @brief Check if decoding into a pooled frame had to reallocate its image
+     *
+     * If it did, the frame doesn't reference the pool anymore and the footage's resolution is updated
+     *
+     * @param frame [in, out] Frame that was decoded into
+     * @param pooled_data [in] Data pointer of the frame's image before decoding
+     */
+    void check_pooled(Frame& frame, const uchar* pooled_data);
+
+    // OpenCV type of the decoded frames, depends on the requested pixel format
+    int frame_type() const;
+
+    /** @brief Go back to the first frame of the footage
+     *
+     */
+    void rewind();
+
+    /** @brief Wait until a frame is due according to the replay mode
+     *
+     * @param timestamp [in] Time that the frame was recorded at, in milliseconds, or a negative value if unknown
+     */
+    void wait_until_due(double timestamp);
+
+    // Flag for decoding images, depends on the requested pixel format
+    int imread_flags() const;
+
+    std::string m_replay_mode;
+    double m_frame_rate {0};
+    bool m_preload {false};
+    bool m_loop {true};
+
+    // Directory sources
+    std::vector<std::filesystem::path> m_files;
+    std::vector<std::shared_ptr<MappedFile>> m_mapped_files;
+    // Video sources, and the scratch image videos are decoded into when they have to be converted
+    cv::VideoCapture m_video;
+    cv::Mat m_decoded;
+    // Resolution of the decoded frames, known after the first frame
+    cv::Size m_frame_size;
+    // Preloaded sources
+    std::vector<cv::Mat> m_preloaded;
+
+    // Time each frame was recorded at in milliseconds. Empty if unknown
+    std::vector<double> m_timestamps;
+    std::size_t m_index {0};
+
+    // Pacing
+    std::chrono::steady_clock::time_point m_replay_start;
+    double m_first_timestamp {-1};
+    std::uint64_t m_frames_replayed {0};
+};
+
+#endif //MELON_REPLAYCAMERA_H
\ No newline at end of file
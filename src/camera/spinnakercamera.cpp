@@ -1,91 +1,99 @@
 #include "spinnakercamera.h"
-#include <SpinGenApi/SpinnakerGenApi.h>
+#include "spinnakernodes.h"
+#include "spinnakerdevices.h"
+#include "../cmdhandler/constants/variables.h"
 #include <spdlog/spdlog.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
 
-SpinnakerCamera::SpinnakerCamera(const StateVariables& state) :
-        AbstractCamera(state),
-        m_psys(Spinnaker::System::GetInstance()),
+// Amount of consecutive detections without the arena before an automatic sensor region goes back to the full region
+constexpr int AUTO_ROI_MAX_MISSES = 30;
+// How much the camera's clock is allowed to drift from the host's clock per frame, in nanoseconds
+constexpr std::int64_t CLOCK_DRIFT_PER_FRAME = 1000;
+
+SpinnakerCamera::SpinnakerCamera(const CameraSystem& camera) :
+        AbstractCamera(camera),
         m_pcam(nullptr)
 {
 }
 
 SpinnakerCamera::~SpinnakerCamera()
 {
+    stop_capture();
     if(is_connected())
         do_disconnect();
-    m_psys->ReleaseInstance();
 }
 
-// Set a new value to an enumeration node's entry value
-// Returns false if node value was unable to be set, true if node value was set successfully
-bool set_node_val(Spinnaker::GenApi::INodeMap& node_map, const char* node_name, const char* value_name)
+/** @brief Get the name of the Spinnaker PixelFormat node entry for a pixel format
+ *
+ * @param format [in] Pixel format to convert
+ * @return Name of the PixelFormat enumeration entry
+ */
+static const char* to_spinnaker_pixel_format(PixelFormat format)
 {
-    // Get the node itself
-    Spinnaker::GenApi::CEnumerationPtr node = node_map.GetNode(node_name);
-    if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsWritable(node))
-    {
-        spdlog::critical("Enumeration node '{}' is not available and/or writable", node_name);
-        return false;
-    }
-
-    // Get the new value that should be set to the node
-    Spinnaker::GenApi::CEnumEntryPtr value = node->GetEntryByName(value_name);
-    if(!Spinnaker::GenApi::IsAvailable(value) || !Spinnaker::GenApi::IsReadable(value))
+    switch(format)
     {
-        spdlog::critical("Enumeration value '{}' for enumeration node '{}' is not available and/or readable",
-                         node_name, value_name);
-        return false;
+        case PixelFormat::MONO8:
+            return "Mono8";
+        case PixelFormat::BAYER_RG8:
+            return "BayerRG8";
+        case PixelFormat::BGR8:
+        default:
+            return "BGR8";
     }
+}
 
-    // Set the value to the node
-    node->SetIntValue(value->GetValue());
-
-    return true;
+/** @brief Get the name of the Spinnaker StreamBufferHandlingMode node entry for a stream buffer mode
+ *
+ * @param mode [in] One of CameraSystemVars::STREAM_BUFFER_MODES
+ * @return Name of the StreamBufferHandlingMode enumeration entry
+ */
+static const char* to_spinnaker_stream_buffer_mode(const std::string& mode)
+{
+    if(mode == CameraSystemVars::STREAM_BUFFER_NEWEST_FIRST)
+        return "NewestFirst";
+    if(mode == CameraSystemVars::STREAM_BUFFER_OLDEST_FIRST)
+        return "OldestFirst";
+    if(mode == CameraSystemVars::STREAM_BUFFER_OLDEST_FIRST_OVERWRITE)
+        return "OldestFirstOverwrite";
+    return "NewestOnly";
 }
 
 bool SpinnakerCamera::do_connect()
 {
-    // Get available cameras
-    Spinnaker::CameraList clist = m_psys->GetCameras();
-    spdlog::info("{} cameras found", clist.GetSize());
-    if(clist.GetSize() < 1)
-        return false;
-
-    // Enumerate over cameras and attempt to find the camera with the given serial number
-    // CameraList does have a GetBySerial() function, but it just seems to crash the program for some reason
-    for(int i = 0; i < clist.GetSize(); ++i)
-    {
-        Spinnaker::CameraPtr pcam = clist.GetByIndex(i);
-        Spinnaker::GenApi::INodeMap& node_map = pcam->GetTLDeviceNodeMap();
-        Spinnaker::GenApi::CStringPtr pserial = node_map.GetNode("DeviceSerialNumber");
-        if(Spinnaker::GenApi::IsAvailable(pserial) && Spinnaker::GenApi::IsReadable(pserial))
-        {
-            Spinnaker::GenICam::gcstring serial = pserial->GetValue();
-            if(serial == get_source().c_str())
-            {
-                m_pcam = pcam;
-                break;
-            }
-        }
-    }
+    // The camera's clock may have been reset, so the offset to the host's clock has to be found again
+    m_clock_synced = false;
 
+    // Cameras that were connected before are still initialized, so this is usually quick
+    m_serial = get_source();
+    m_pcam = SpinnakerDevices::instance().acquire(m_serial);
     if(m_pcam == nullptr)
-    {
-        spdlog::critical("Camera with serial number '{}' not found", get_source());
         return false;
-    }
 
+    // Write every setting, since the camera keeps whatever it was last set to, and start video capture
     try
     {
-        spdlog::info("Initializing camera");
-        m_pcam->Init();
+        if(!configure())
+        {
+            SpinnakerDevices::instance().release(m_serial);
+            m_pcam = nullptr;
+            return false;
+        }
+        m_pcam->BeginAcquisition();
     }
-    catch (Spinnaker::Exception& e)
+    catch(Spinnaker::Exception& e)
     {
-        spdlog::critical("Error initializing camera: \n{}", e.what());
+        spdlog::critical("Error configuring camera: \n{}", e.what());
+        SpinnakerDevices::instance().release(m_serial, false);
+        m_pcam = nullptr;
         return false;
     }
 
+    return true;
+}
+
+bool SpinnakerCamera::configure()
+{
     // Get camera nodes (settings)
     Spinnaker::GenApi::INodeMap& node_map = m_pcam->GetNodeMap();
 
@@ -95,29 +103,76 @@ bool SpinnakerCamera::do_connect()
         spdlog::error("Failed to set camera 'AcquisitionMode' to 'Continuous'");
         return false;
     }
-    // Set the pixel format of the incoming image to BGR8 so that it's compatible with OpenCV
-    if(!set_node_val(node_map, "PixelFormat", "BGR8"))
+    // Set the pixel format of the incoming image. Mono8 and BayerRG8 are a third of the size of BGR8, so they use far
+    // less bandwidth; the conversion to BGR is then only done when it's actually needed (see Frame::bgr())
+    const char* pixel_format = to_spinnaker_pixel_format(get_pixel_format());
+    if(!set_node_val(node_map, "PixelFormat", pixel_format))
     {
-        spdlog::error("Failed to set camera 'PixelFormat' to 'BGR8'");
+        spdlog::error("Failed to set camera 'PixelFormat' to '{}'", pixel_format);
         return false;
     }
 
-    // Start video capture
-    m_pcam->BeginAcquisition();
+    // Set binning, decimation and the sensor region. A smaller readout means a higher possible frame rate
+    if(!apply_region(node_map))
+    {
+        spdlog::error("Failed to set the camera's sensor region");
+        return false;
+    }
+
+    if(!apply_acquisition_settings(node_map) || !apply_stream_settings(m_pcam->GetTLStreamNodeMap()))
+    {
+        spdlog::error("Failed to set the camera's acquisition settings");
+        return false;
+    }
 
     return true;
 }
 
 bool SpinnakerCamera::do_disconnect()
 {
-    m_pcam->EndAcquisition();
-    m_pcam->DeInit();
+    // The camera stays initialized in the cache, so that connecting it again doesn't have to initialize it again
+    bool result = true;
+    try
+    {
+        m_pcam->EndAcquisition();
+    }
+    catch(Spinnaker::Exception& e)
+    {
+        spdlog::error("Error stopping acquisition: \n{}", e.what());
+        result = false;
+    }
+    SpinnakerDevices::instance().release(m_serial, result);
     m_pcam = nullptr;
 
-    return true;
+    return result;
 }
 
-bool SpinnakerCamera::get_frame(cv::Mat& frame)
+/** @brief Make a shared owner for a Spinnaker image
+ *
+ * The image is given back to the driver's buffer pool (ImagePtr::Release()) once the last reference to the returned
+ * pointer is gone
+ *
+ * @param img [in] Image to take ownership of
+ * @return Shared pointer that releases the image when destroyed
+ */
+static std::shared_ptr<const void> make_image_owner(const Spinnaker::ImagePtr& img)
+{
+    return std::shared_ptr<Spinnaker::ImagePtr>(new Spinnaker::ImagePtr(img), [](Spinnaker::ImagePtr* pimg)
+    {
+        try
+        {
+            (*pimg)->Release();
+        }
+        catch(Spinnaker::Exception& e)
+        {
+            // This can happen if the camera was disconnected while the frame was still being used
+            spdlog::warn("Error releasing spinnaker image: \n{}", e.what());
+        }
+        delete pimg;
+    });
+}
+
+bool SpinnakerCamera::do_get_frame(Frame& frame)
 {
     try
     {
@@ -128,23 +183,306 @@ bool SpinnakerCamera::get_frame(cv::Mat& frame)
         if(img->IsIncomplete())
         {
             spdlog::warn("Image incomplete: {}", img->GetImageStatus());
+            img->Release();
             return false;
         }
 
-        // Convert the image to an OpenCV Mat
-        cv::Mat cv_img = cv::Mat(img->GetHeight() + img->GetYPadding(), img->GetWidth() + img->GetXPadding(), CV_8UC3);
-        cv_img.data = (uchar*)img->GetData();
-        // Perform a deep copy of the Mat and assign it to 'frame'. A deep copy must be done otherwise the
-        // 'data' pointer for the Mat will be invalid once the ImagePtr is freed
-        frame = cv_img.clone();
+        // Wrap the driver's buffer in an OpenCV Mat without copying it. The frame holds on to the ImagePtr so that
+        // the 'data' pointer for the Mat stays valid until every copy of the frame is gone
+        const PixelFormat format = get_pixel_format();
+        const int type = format == PixelFormat::BGR8 ? CV_8UC3 : CV_8UC1;
+        frame.image = cv::Mat(img->GetHeight(), img->GetWidth(), type, img->GetData(), img->GetStride());
+        frame.owner = make_image_owner(img);
+        frame.format = format;
+        frame.offset = cv::Point(static_cast<int>(img->GetXOffset()), static_cast<int>(img->GetYOffset()));
+
+        // Map the camera's timestamp onto the host's clock. The offset between the clocks is the smallest difference
+        // seen so far (i.e. the frame that took the least time to arrive), allowing for some drift between the clocks
+        const auto host_time = std::chrono::steady_clock::now();
+        frame.device_timestamp = static_cast<std::int64_t>(img->GetTimeStamp());
+        if(frame.device_timestamp != 0)
+        {
+            const std::int64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    host_time.time_since_epoch()).count() - frame.device_timestamp;
+            if(!m_clock_synced || offset < m_clock_offset + CLOCK_DRIFT_PER_FRAME)
+                m_clock_offset = offset;
+            else
+                m_clock_offset += CLOCK_DRIFT_PER_FRAME;
+            m_clock_synced = true;
 
-        // Release the image
-        img->Release();
+            frame.timestamp = std::chrono::steady_clock::time_point(std::chrono::duration_cast<
+                    std::chrono::steady_clock::duration>(std::chrono::nanoseconds(frame.device_timestamp + m_clock_offset)));
+        }
     }
     catch(Spinnaker::Exception& e)
     {
         spdlog::critical("Error acquiring frame from spinnaker camera: \n{}", e.what());
+        return false;
     }
 
     return true;
+}
+
+cv::Rect SpinnakerCamera::active_region() const
+{
+    return (m_auto_roi && !m_auto_region.empty()) ? m_auto_region : m_roi;
+}
+
+bool SpinnakerCamera::apply_region(Spinnaker::GenApi::INodeMap& node_map)
+{
+    // Binning and decimation change the size of the image, so they have to be set before the region. Not every camera
+    // supports them, which is only a problem if they're actually being used
+    for(const auto& [node_name, value] : {std::pair("BinningHorizontal", m_binning),
+                                          std::pair("BinningVertical", m_binning),
+                                          std::pair("DecimationHorizontal", m_decimation),
+                                          std::pair("DecimationVertical", m_decimation)})
+    {
+        if(is_node_writable(node_map, node_name))
+        {
+            // Values are clamped to what the camera supports, so check that it's actually the one that was asked for.
+            // The region below is in binned and decimated pixels, so it would be wrong otherwise
+            int64_t applied = 0;
+            if(!set_node_val(node_map, node_name, value) || !get_int_node_val(node_map, node_name, applied) ||
+               applied != value)
+            {
+                spdlog::error("Failed to set '{}' to {}", node_name, value);
+                return false;
+            }
+        }
+        else if(value != 1)
+        {
+            spdlog::error("Camera doesn't support '{}'", node_name);
+            return false;
+        }
+    }
+
+    // Reset the offsets first so that the full width and height are available
+    if(!set_node_val(node_map, "OffsetX", 0) || !set_node_val(node_map, "OffsetY", 0))
+        return false;
+
+    // Size of the sensor at the current binning and decimation
+    int64_t width_max = 0;
+    int64_t height_max = 0;
+    if(!get_int_node_val(node_map, "WidthMax", width_max) || !get_int_node_val(node_map, "HeightMax", height_max))
+        return false;
+    m_sensor_size = cv::Size(static_cast<int>(width_max), static_cast<int>(height_max));
+
+    // Keep the region on the sensor. An empty region reads out the full sensor
+    const cv::Rect region = active_region() & cv::Rect(cv::Point(), m_sensor_size);
+    if(region.empty() && !active_region().empty())
+        spdlog::warn("Camera sensor region is outside of the {}x{} sensor, using the full sensor", width_max,
+                     height_max);
+    if(!set_node_val(node_map, "Width", region.empty() ? width_max : region.width) ||
+       !set_node_val(node_map, "Height", region.empty() ? height_max : region.height))
+        return false;
+
+    if(!region.empty() &&
+       (!set_node_val(node_map, "OffsetX", region.x) || !set_node_val(node_map, "OffsetY", region.y)))
+        return false;
+
+    spdlog::info("Camera sensor region set to {}x{} at ({}, {}), binning {}, decimation {}",
+                 region.width, region.height, region.x, region.y, m_binning, m_decimation);
+    return true;
+}
+
+bool SpinnakerCamera::apply_acquisition_settings(Spinnaker::GenApi::INodeMap& node_map, unsigned settings)
+{
+    // Exposure time. A short, fixed exposure is what keeps moving robots from blurring
+    if(settings & EXPOSURE_SETTING)
+    {
+        // Not every camera has automatic exposure, those are always set manually
+        const bool has_auto = is_node_writable(node_map, "ExposureAuto");
+        if(m_exposure_time > 0)
+        {
+            if((has_auto && !set_node_val(node_map, "ExposureAuto", "Off")) ||
+               !set_node_val(node_map, "ExposureTime", m_exposure_time))
+                return false;
+        }
+        else if(!has_auto)
+        {
+            spdlog::warn("Camera doesn't have automatic exposure, its exposure time is left as is");
+        }
+        else if(!set_node_val(node_map, "ExposureAuto", "Continuous"))
+        {
+            return false;
+        }
+        spdlog::info("Camera exposure time set to {}",
+                     m_exposure_time > 0 ? std::to_string(m_exposure_time) + "us" : "auto");
+    }
+
+    // Gain
+    if(settings & GAIN_SETTING)
+    {
+        // 0dB is a valid fixed gain (the least noisy one), so automatic gain is negative
+        const bool has_auto = is_node_writable(node_map, "GainAuto");
+        if(m_gain >= 0)
+        {
+            if((has_auto && !set_node_val(node_map, "GainAuto", "Off")) || !set_node_val(node_map, "Gain", m_gain))
+                return false;
+        }
+        else if(!has_auto)
+        {
+            spdlog::warn("Camera doesn't have automatic gain, its gain is left as is");
+        }
+        else if(!set_node_val(node_map, "GainAuto", "Continuous"))
+        {
+            return false;
+        }
+        spdlog::info("Camera gain set to {}", m_gain >= 0 ? std::to_string(m_gain) + "dB" : "auto");
+    }
+
+    // Frame rate. Older cameras name the enable node 'AcquisitionFrameRateEnabled'
+    if(settings & FRAME_RATE_SETTING)
+    {
+        const char* frame_rate_enable = is_node_writable(node_map, "AcquisitionFrameRateEnable") ?
+                                        "AcquisitionFrameRateEnable" : "AcquisitionFrameRateEnabled";
+        if(!set_node_val(node_map, frame_rate_enable, m_frame_rate > 0))
+            return false;
+        if(m_frame_rate > 0 && !set_node_val(node_map, "AcquisitionFrameRate", m_frame_rate))
+            return false;
+        spdlog::info("Camera frame rate set to {}",
+                     m_frame_rate > 0 ? std::to_string(m_frame_rate) + "fps" : "unlimited");
+    }
+
+    return true;
+}
+
+bool SpinnakerCamera::apply_stream_settings(Spinnaker::GenApi::INodeMap& stream_node_map)
+{
+    // NewestOnly makes GetNextImage() always return the most recent image, so a slow consumer gets fresh frames
+    // instead of working through a backlog
+    const char* mode = to_spinnaker_stream_buffer_mode(m_stream_buffer_mode);
+    if(!set_node_val(stream_node_map, "StreamBufferHandlingMode", mode))
+        return false;
+
+    if(m_stream_buffer_count > 0)
+    {
+        if(!set_node_val(stream_node_map, "StreamBufferCountMode", "Manual") ||
+           !set_node_val(stream_node_map, "StreamBufferCountManual", m_stream_buffer_count))
+            return false;
+    }
+    else if(is_node_writable(stream_node_map, "StreamBufferCountMode"))
+    {
+        set_node_val(stream_node_map, "StreamBufferCountMode", "Auto");
+    }
+
+    spdlog::info("Camera stream buffer handling mode set to {}, buffer count set to {}", mode,
+                 m_stream_buffer_count > 0 ? std::to_string(m_stream_buffer_count) : "auto");
+    return true;
+}
+
+bool SpinnakerCamera::reconfigure_stopped(bool region, bool stream)
+{
+    return while_capture_paused([this, region, stream]()
+    {
+        try
+        {
+            // The region and stream nodes can only be written while the camera isn't acquiring
+            m_pcam->EndAcquisition();
+            const bool result = (!region || apply_region(m_pcam->GetNodeMap())) &&
+                                (!stream || apply_stream_settings(m_pcam->GetTLStreamNodeMap()));
+            m_pcam->BeginAcquisition();
+            return result;
+        }
+        catch(Spinnaker::Exception& e)
+        {
+            spdlog::error("Error reconfiguring the camera: \n{}", e.what());
+            return false;
+        }
+    });
+}
+
+void SpinnakerCamera::fit_roi(const std::vector<cv::Point2f>& points)
+{
+    if(!m_auto_roi || !is_connected())
+        return;
+
+    cv::Rect target;
+    if(points.empty())
+    {
+        // If the arena has been lost for a while it may have moved out of the region, so go back to the full region
+        if(m_auto_region.empty() || ++m_roi_misses < AUTO_ROI_MAX_MISSES)
+            return;
+    }
+    else
+    {
+        m_roi_misses = 0;
+        target = cv::boundingRect(points);
+        target.x -= m_roi_margin;
+        target.y -= m_roi_margin;
+        target.width += 2 * m_roi_margin;
+        target.height += 2 * m_roi_margin;
+        // Keep the region on the sensor, and within the manually set region if there is one
+        target &= cv::Rect(cv::Point(), m_sensor_size);
+        if(!m_roi.empty())
+            target &= m_roi;
+
+        // Every change briefly stops acquisition, so only change the region if the points are leaving the current
+        // region or if the region can shrink considerably
+        if(!m_auto_region.empty() &&
+           (target & m_auto_region) == target &&
+           target.area() > m_auto_region.area() / 2)
+            return;
+    }
+
+    m_auto_region = target;
+    if(!reconfigure_stopped(true, false))
+        spdlog::warn("Failed to fit the camera's sensor region to the arena");
+}
+
+void SpinnakerCamera::update_state(const CameraSystem& camera)
+{
+    // Settings that can only be changed while the camera isn't acquiring
+    const bool region_changed = camera.roi != m_roi ||
+                                camera.binning != m_binning ||
+                                camera.decimation != m_decimation ||
+                                camera.auto_roi != m_auto_roi;
+    const bool stream_changed = camera.stream_buffer_mode != m_stream_buffer_mode ||
+                                camera.stream_buffer_count != m_stream_buffer_count;
+    // Settings that can be changed while the camera is acquiring. Only the ones that changed are written
+    unsigned live_changed = 0;
+    if(camera.exposure_time != m_exposure_time)
+        live_changed |= EXPOSURE_SETTING;
+    if(camera.gain != m_gain)
+        live_changed |= GAIN_SETTING;
+    if(camera.frame_rate != m_frame_rate)
+        live_changed |= FRAME_RATE_SETTING;
+    if(camera.roi != m_roi || camera.auto_roi != m_auto_roi ||
+       camera.binning != m_binning || camera.decimation != m_decimation)
+        m_auto_region = cv::Rect();
+
+    m_roi = camera.roi;
+    m_binning = camera.binning;
+    m_decimation = camera.decimation;
+    m_auto_roi = camera.auto_roi;
+    m_roi_margin = camera.roi_margin;
+    m_exposure_time = camera.exposure_time;
+    m_gain = camera.gain;
+    m_frame_rate = camera.frame_rate;
+    m_stream_buffer_mode = camera.stream_buffer_mode;
+    m_stream_buffer_count = camera.stream_buffer_count;
+
+    const bool was_connected = is_connected();
+    AbstractCamera::update_state(camera);
+
+    // do_connect() writes all of the settings itself, so they only need to be written here if the camera stayed
+    // connected
+    if(!was_connected || !is_connected())
+        return;
+
+    if((region_changed || stream_changed) && !reconfigure_stopped(region_changed, stream_changed))
+        throw std::runtime_error("Failed to change the camera's sensor region and/or stream settings");
+
+    if(live_changed)
+    {
+        try
+        {
+            if(!apply_acquisition_settings(m_pcam->GetNodeMap(), live_changed))
+                throw std::runtime_error("Failed to change the camera's acquisition settings");
+        }
+        catch(Spinnaker::Exception& e)
+        {
+            throw std::runtime_error(std::string("Error changing the camera's acquisition settings: \n") + e.what());
+        }
+    }
 }
\ No newline at end of file
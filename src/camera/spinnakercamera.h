@@ -3,26 +3,118 @@
 
 #include "abstractcamera.h"
 #include <Spinnaker.h>
+#include <string>
 
 /** @brief A camera that uses Spinnaker SDK
  *
- * This class is for cameras that are interfaced with using Flir's Spinnaker SDK
+ * This class is for cameras that are interfaced with using Flir's Spinnaker SDK. Cameras are taken from and given back
+ * to SpinnakerDevices, so connecting a camera that was connected before skips the enumeration and initialization. <br>
+ * Changing the camera system only writes the nodes whose settings changed: exposure, gain and frame rate are written
+ * while the camera keeps acquiring, and the sensor region and stream settings only stop acquisition briefly
  */
 class SpinnakerCamera : public AbstractCamera
 {
 public:
-    explicit SpinnakerCamera(const StateVariables& state);
+    explicit SpinnakerCamera(const CameraSystem& camera);
     ~SpinnakerCamera();
 
-    bool get_frame(cv::Mat &frame) override;
+    void fit_roi(const std::vector<cv::Point2f>& points) override;
+    void update_state(const CameraSystem& camera) override;
 
 protected:
     bool do_disconnect() override;
     bool do_connect() override;
+    bool do_get_frame(Frame& frame) override;
 
 private:
-    Spinnaker::SystemPtr m_psys;
+    /** @brief Get the sensor region that should currently be read out
+     *
+     * @return The region fitted to the arena if auto ROI is active, otherwise the manually set region. An empty rect
+     *         means the full sensor
+     */
+    cv::Rect active_region() const;
+
+    /** @brief Write binning, decimation and the sensor region to the camera
+     *
+     * @note The camera must not be acquiring when this is called
+     *
+     * @param node_map [in] The camera's node map
+     * @return True if all values were written, false otherwise
+     */
+    bool apply_region(Spinnaker::GenApi::INodeMap& node_map);
+
+    // Flags for the settings written by apply_acquisition_settings()
+    static constexpr unsigned EXPOSURE_SETTING = 1u << 0;
+    static constexpr unsigned GAIN_SETTING = 1u << 1;
+    static constexpr unsigned FRAME_RATE_SETTING = 1u << 2;
+    static constexpr unsigned ALL_ACQUISITION_SETTINGS = EXPOSURE_SETTING | GAIN_SETTING | FRAME_RATE_SETTING;
+
+    /** @brief Write every setting to a newly connected camera
+     *
+     * @note The camera must not be acquiring when this is called
+     *
+     * @return True if all values were written, false otherwise
+     */
+    bool configure();
+
+    /** @brief Write exposure, gain and/or frame rate to the camera
+     *
+     * These can be written while the camera is acquiring
+     *
+     * @param node_map [in] The camera's node map
+     * @param settings [in] Flags of the settings to write, i.e. SpinnakerCamera::EXPOSURE_SETTING
+     * @return True if all values were written, false otherwise
+     */
+    bool apply_acquisition_settings(Spinnaker::GenApi::INodeMap& node_map,
+                                    unsigned settings = ALL_ACQUISITION_SETTINGS);
+
+    /** @brief Write the stream buffer handling mode and buffer count to the camera
+     *
+     * @note The camera must not be acquiring when this is called
+     *
+     * @param stream_node_map [in] The camera's transport layer stream node map
+     * @return True if all values were written, false otherwise
+     */
+    bool apply_stream_settings(Spinnaker::GenApi::INodeMap& stream_node_map);
+
+    /** @brief Write the settings that require acquisition to be stopped to a connected camera
+     *
+     * This writes the sensor region and/or stream settings. It briefly stops acquisition (and the capture thread, if
+     * it's running) since these can't be changed while the camera is acquiring
+     *
+     * @param region [in] Write the sensor region, binning and decimation
+     * @param stream [in] Write the stream settings
+     * @return True if the settings were written, false otherwise
+     */
+    bool reconfigure_stopped(bool region, bool stream);
+
     Spinnaker::CameraPtr m_pcam;
+    // Serial number the camera was acquired from SpinnakerDevices with. The source may have changed since
+    std::string m_serial;
+
+    // Sensor region configuration from the camera system
+    cv::Rect m_roi;
+    int m_binning {1};
+    int m_decimation {1};
+    bool m_auto_roi {false};
+    int m_roi_margin {0};
+    // Region fitted to the arena by fit_roi(). Empty if the region hasn't been fitted
+    cv::Rect m_auto_region;
+    // Consecutive calls to fit_roi() without any points
+    int m_roi_misses {0};
+    // Size of the sensor at the current binning and decimation, read when the region is applied
+    cv::Size m_sensor_size;
+
+    // Acquisition configuration from the camera system
+    double m_exposure_time {0};
+    double m_gain {-1};
+    double m_frame_rate {0};
+    std::string m_stream_buffer_mode;
+    int m_stream_buffer_count {0};
+
+    // Offset from the camera's timestamps to the host's steady clock, in nanoseconds
+    std::int64_t m_clock_offset {0};
+    bool m_clock_synced {false};
 };
 
 
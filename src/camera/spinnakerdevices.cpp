@@ -0,0 +1,124 @@
+#include "spinnakerdevices.h"
+#include <spdlog/spdlog.h>
+
+SpinnakerDevices::SpinnakerDevices() :
+        m_system(Spinnaker::System::GetInstance())
+{
+}
+
+SpinnakerDevices::~SpinnakerDevices()
+{
+    for(auto& pair : m_devices)
+    {
+        try
+        {
+            if(pair.second.initialized)
+                pair.second.camera->DeInit();
+        }
+        catch(Spinnaker::Exception& e)
+        {
+            spdlog::warn("Error deinitializing camera '{}': \n{}", pair.first, e.what());
+        }
+    }
+    // Every camera must be gone before the system is released
+    m_devices.clear();
+    m_system->ReleaseInstance();
+}
+
+SpinnakerDevices& SpinnakerDevices::instance()
+{
+    static SpinnakerDevices devices;
+    return devices;
+}
+
+Spinnaker::CameraPtr SpinnakerDevices::acquire(const std::string& serial)
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+
+    // Forget cameras that were unplugged, so that they're looked for again
+    auto it = m_devices.find(serial);
+    if(it != m_devices.end() && !it->second.in_use && !it->second.camera->IsValid())
+    {
+        m_devices.erase(it);
+        it = m_devices.end();
+    }
+    if(it == m_devices.end())
+    {
+        enumerate();
+        it = m_devices.find(serial);
+        if(it == m_devices.end())
+        {
+            spdlog::critical("Camera with serial number '{}' not found", serial);
+            return nullptr;
+        }
+    }
+
+    Device& device = it->second;
+    if(device.in_use)
+    {
+        spdlog::critical("Camera with serial number '{}' is already in use", serial);
+        return nullptr;
+    }
+
+    if(!device.initialized)
+    {
+        try
+        {
+            spdlog::info("Initializing camera '{}'", serial);
+            device.camera->Init();
+            device.initialized = true;
+        }
+        catch(Spinnaker::Exception& e)
+        {
+            spdlog::critical("Error initializing camera: \n{}", e.what());
+            m_devices.erase(it);
+            return nullptr;
+        }
+    }
+
+    device.in_use = true;
+    return device.camera;
+}
+
+void SpinnakerDevices::release(const std::string& serial, bool keep)
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    auto it = m_devices.find(serial);
+    if(it == m_devices.end())
+        return;
+
+    it->second.in_use = false;
+    if(keep)
+        return;
+
+    try
+    {
+        if(it->second.initialized)
+            it->second.camera->DeInit();
+    }
+    catch(Spinnaker::Exception& e)
+    {
+        spdlog::warn("Error deinitializing camera '{}': \n{}", serial, e.what());
+    }
+    m_devices.erase(it);
+}
+
+void SpinnakerDevices::enumerate()
+{
+    Spinnaker::CameraList clist = m_system->GetCameras();
+    spdlog::info("{} cameras found", clist.GetSize());
+
+    // CameraList does have a GetBySerial() function, but it just seems to crash the program for some reason
+    for(unsigned int i = 0; i < clist.GetSize(); ++i)
+    {
+        Spinnaker::CameraPtr pcam = clist.GetByIndex(i);
+        Spinnaker::GenApi::INodeMap& node_map = pcam->GetTLDeviceNodeMap();
+        Spinnaker::GenApi::CStringPtr pserial = node_map.GetNode("DeviceSerialNumber");
+        if(!Spinnaker::GenApi::IsAvailable(pserial) || !Spinnaker::GenApi::IsReadable(pserial))
+            continue;
+
+        const std::string serial(pserial->GetValue().c_str());
+        if(m_devices.find(serial) == m_devices.end())
+            m_devices[serial].camera = pcam;
+    }
+}
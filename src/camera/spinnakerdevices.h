@@ -0,0 +1,80 @@
+#ifndef MELON_SPINNAKERDEVICES_H
+#define MELON_SPINNAKERDEVICES_H
+
+#include <Spinnaker.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+/** @brief Cache of the Spinnaker cameras attached to the system, keyed by serial number
+ *
+ * Connecting a camera from scratch means creating the Spinnaker system, enumerating every device to read its serial
+ * number and initializing the camera (which reads its whole node map), and together that takes seconds. The cache
+ * does each of these once: the system lives until the program exits, devices are only enumerated again when a serial
+ * number isn't known yet, and cameras stay initialized when they're given back. So reconnecting a camera, i.e. after
+ * its source or pixel format changed or its pipeline was restarted, only has to write its settings and start
+ * acquisition again. <br>
+ * Everything is thread safe
+ */
+class SpinnakerDevices
+{
+public:
+    SpinnakerDevices(const SpinnakerDevices& other) = delete;
+
+    /** @brief Get the process-wide cache
+     *
+     * The cache (and with it the Spinnaker system) is created on first use
+     *
+     * @return The cache
+     */
+    static SpinnakerDevices& instance();
+
+    /** @brief Take an initialized camera out of the cache
+     *
+     * If the serial number isn't known, the devices are enumerated again in case the camera was attached since the
+     * last time. The camera is initialized if it isn't yet, but acquisition isn't started
+     *
+     * @param serial [in] Serial number of the camera
+     * @return The camera, or null if there is no camera with that serial number, it's already taken or it failed to
+     *         initialize
+     */
+    Spinnaker::CameraPtr acquire(const std::string& serial);
+
+    /** @brief Give a camera back to the cache
+     *
+     * The camera must not be acquiring anymore. It stays initialized, so that the next SpinnakerDevices::acquire() for
+     * it is quick
+     *
+     * @param serial [in] Serial number the camera was acquired with
+     * @param keep [in] False if the camera misbehaved. It's deinitialized and forgotten, so the next
+     *                  SpinnakerDevices::acquire() looks for it again
+     */
+    void release(const std::string& serial, bool keep = true);
+
+private:
+    /** @brief A camera known to the cache
+     *
+     */
+    struct Device
+    {
+        Spinnaker::CameraPtr camera;
+        bool initialized = false;
+        // Acquired by a SpinnakerCamera and not given back yet
+        bool in_use = false;
+    };
+
+    SpinnakerDevices();
+    ~SpinnakerDevices();
+
+    /** @brief Enumerate the attached devices and add the ones that aren't known yet
+     *
+     * @note m_mutex must be held
+     */
+    void enumerate();
+
+    std::mutex m_mutex;
+    Spinnaker::SystemPtr m_system;
+    std::map<std::string, Device> m_devices;
+};
+
+#endif //MELON_SPINNAKERDEVICES_H
@@ -0,0 +1,123 @@
+#ifndef MELON_SPINNAKERNODES_H
+#define MELON_SPINNAKERNODES_H
+
+#include <Spinnaker.h>
+#include <SpinGenApi/SpinnakerGenApi.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <type_traits>
+#include <string>
+
+/** @brief Check if a node is available and writable
+ *
+ * @param node_map [in] Node map containing the node
+ * @param node_name [in] Name of the node
+ * @return True if the node exists on the camera and can currently be written to
+ */
+inline bool is_node_writable(Spinnaker::GenApi::INodeMap& node_map, const char* node_name)
+{
+    Spinnaker::GenApi::CNodePtr node = node_map.GetNode(node_name);
+    return Spinnaker::GenApi::IsAvailable(node) && Spinnaker::GenApi::IsWritable(node);
+}
+
+/** @brief Get the value of an integer node
+ *
+ * @param node_map [in] Node map containing the node
+ * @param node_name [in] Name of the node
+ * @param value [out] Value of the node
+ * @return True if the node was read successfully, false if it isn't available or readable
+ */
+inline bool get_int_node_val(Spinnaker::GenApi::INodeMap& node_map, const char* node_name, int64_t& value)
+{
+    Spinnaker::GenApi::CIntegerPtr node = node_map.GetNode(node_name);
+    if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsReadable(node))
+    {
+        spdlog::error("Integer node '{}' is not available and/or readable", node_name);
+        return false;
+    }
+
+    value = node->GetValue();
+    return true;
+}
+
+/** @brief Set a new value to a node
+ *
+ * The type of node is chosen by the type of the value:
+ * - bool sets a boolean node
+ * - Integer types set an integer node. The value is clamped to the node's range and rounded down to its increment
+ * - Floating point types set a float node. The value is clamped to the node's range
+ * - Strings set an enumeration node to the entry with the given name
+ *
+ * @param node_map [in] Node map containing the node
+ * @param node_name [in] Name of the node
+ * @param value [in] Value to set
+ * @return True if the node value was set successfully, false if it was unable to be set
+ */
+template<typename T>
+bool set_node_val(Spinnaker::GenApi::INodeMap& node_map, const char* node_name, const T& value)
+{
+    if constexpr(std::is_same_v<T, bool>)
+    {
+        Spinnaker::GenApi::CBooleanPtr node = node_map.GetNode(node_name);
+        if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsWritable(node))
+        {
+            spdlog::error("Boolean node '{}' is not available and/or writable", node_name);
+            return false;
+        }
+
+        node->SetValue(value);
+    }
+    else if constexpr(std::is_integral_v<T>)
+    {
+        Spinnaker::GenApi::CIntegerPtr node = node_map.GetNode(node_name);
+        if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsWritable(node))
+        {
+            spdlog::error("Integer node '{}' is not available and/or writable", node_name);
+            return false;
+        }
+
+        const int64_t min = node->GetMin();
+        const int64_t inc = node->GetInc();
+        int64_t new_value = std::clamp(static_cast<int64_t>(value), min, node->GetMax());
+        new_value -= (new_value - min) % inc;
+        node->SetValue(new_value);
+    }
+    else if constexpr(std::is_floating_point_v<T>)
+    {
+        Spinnaker::GenApi::CFloatPtr node = node_map.GetNode(node_name);
+        if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsWritable(node))
+        {
+            spdlog::error("Float node '{}' is not available and/or writable", node_name);
+            return false;
+        }
+
+        node->SetValue(std::clamp(static_cast<double>(value), node->GetMin(), node->GetMax()));
+    }
+    else
+    {
+        // Get the node itself
+        Spinnaker::GenApi::CEnumerationPtr node = node_map.GetNode(node_name);
+        if(!Spinnaker::GenApi::IsAvailable(node) || !Spinnaker::GenApi::IsWritable(node))
+        {
+            spdlog::critical("Enumeration node '{}' is not available and/or writable", node_name);
+            return false;
+        }
+
+        // Get the new value that should be set to the node
+        const std::string entry_name(value);
+        Spinnaker::GenApi::CEnumEntryPtr entry = node->GetEntryByName(entry_name.c_str());
+        if(!Spinnaker::GenApi::IsAvailable(entry) || !Spinnaker::GenApi::IsReadable(entry))
+        {
+            spdlog::critical("Enumeration value '{}' for enumeration node '{}' is not available and/or readable",
+                             entry_name, node_name);
+            return false;
+        }
+
+        // Set the value to the node
+        node->SetIntValue(entry->GetValue());
+    }
+
+    return true;
+}
+
+#endif //MELON_SPINNAKERNODES_H
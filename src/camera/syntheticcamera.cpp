@@ -0,0 +1,292 @@
+#include "syntheticcamera.h"
+#include "../detectors/arena.h"
+#include <spdlog/spdlog.h>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <thread>
+
+// Seed for placing and moving robots, so that every run renders the same frames
+constexpr unsigned int SCENE_SEED = 5489u;
+// Time between frames used for moving robots when frames are rendered as fast as possible
+constexpr double UNPACED_FRAME_TIME = 1.0 / 30.0;
+// Fraction of the view that's left around the arena
+constexpr double VIEW_MARGIN = 1.1;
+
+SyntheticCamera::SyntheticCamera(const CameraSystem& camera) :
+        AbstractCamera(camera),
+        m_dictionary_id(camera.marker_dictionary),
+        m_robot_count(camera.synthetic_robots),
+        m_marker_size(camera.synthetic_marker_size),
+        m_noise(camera.synthetic_noise),
+        m_blur(camera.synthetic_blur),
+        m_frame_rate(camera.frame_rate),
+        m_rng(SCENE_SEED)
+{
+}
+
+SyntheticCamera::~SyntheticCamera()
+{
+    stop_capture();
+    if(is_connected())
+        do_disconnect();
+}
+
+bool SyntheticCamera::do_connect()
+{
+    m_arena = cv::imread(get_source(), cv::IMREAD_GRAYSCALE);
+    if(m_arena.empty())
+    {
+        spdlog::critical("Failed to load arena image '{}'", get_source());
+        return false;
+    }
+
+    m_dictionary = cv::aruco::getPredefinedDictionary(m_dictionary_id);
+    reset_scene();
+    spdlog::info("Rendering {} robots on '{}' at {}x{}", m_robots.size(), get_source(), m_sensor_size.width,
+                 m_sensor_size.height);
+    return true;
+}
+
+bool SyntheticCamera::do_disconnect()
+{
+    m_arena.release();
+    m_floor.release();
+    m_rendered.release();
+    m_noise_image.release();
+    m_marker_images.clear();
+    m_robots.clear();
+    return true;
+}
+
+void SyntheticCamera::reset_scene()
+{
+    // Use the camera's calibration if there is one, otherwise a camera with a sensor the size of the arena image
+    cv::Matx33d k;
+    const CameraCalib& calib = get_camera_calib();
+    if(calib.matrix.rows == 3 && calib.matrix.cols == 3)
+    {
+        cv::Mat matrix;
+        calib.matrix.convertTo(matrix, CV_64F);
+        k = cv::Matx33d(matrix);
+        m_sensor_size = cv::Size(cvRound(2 * k(0, 2)), cvRound(2 * k(1, 2)));
+    }
+    else
+    {
+        const double focal = std::max(m_arena.cols, m_arena.rows);
+        k = cv::Matx33d(focal, 0, m_arena.cols / 2.0, 0, focal, m_arena.rows / 2.0, 0, 0, 1);
+        m_sensor_size = m_arena.size();
+    }
+
+    // Place the camera above the center of the arena, looking straight down, far enough away to see all of it
+    const double half_width = m_arena.cols / 2.0;
+    const double half_height = m_arena.rows / 2.0;
+    const double distance = VIEW_MARGIN * std::max(half_width * k(0, 0) / k(0, 2), half_height * k(1, 1) / k(1, 2));
+    m_camera_rotation = cv::Matx33d::eye();
+    m_camera_translation = cv::Vec3d(-half_width, -half_height, distance);
+    // Points on the arena floor have z = 0, so the projection reduces to a homography
+    const cv::Matx33d plane(1, 0, m_camera_translation[0],
+                            0, 1, m_camera_translation[1],
+                            0, 0, m_camera_translation[2]);
+    m_homography = cv::Mat(k * plane);
+
+    // Render each robot's marker once, with a white border so that it can be found on any floor
+    const int marker_count = m_dictionary->bytesList.rows;
+    if(m_robot_count > marker_count - ARENA_MARKER_COUNT)
+        spdlog::warn("Dictionary only has {} robot markers, {} robots will share ids",
+                     marker_count - ARENA_MARKER_COUNT, m_robot_count);
+
+    m_rng.seed(SCENE_SEED);
+    std::uniform_real_distribution<double> x_dist(m_marker_size, std::max<double>(m_marker_size, m_arena.cols - m_marker_size));
+    std::uniform_real_distribution<double> y_dist(m_marker_size, std::max<double>(m_marker_size, m_arena.rows - m_marker_size));
+    std::uniform_real_distribution<double> angle_dist(-CV_PI, CV_PI);
+    std::uniform_real_distribution<double> turn_dist(-1.0, 1.0);
+    // Robots cross the arena in about 10 seconds
+    const double speed = std::max(m_arena.cols, m_arena.rows) / 10.0;
+
+    m_marker_images.clear();
+    m_robots.clear();
+    m_robots.reserve(m_robot_count);
+    for(int i = 0; i < m_robot_count; ++i)
+    {
+        const int id = ARENA_MARKER_COUNT + i % std::max(1, marker_count - ARENA_MARKER_COUNT);
+        cv::Mat marker, bordered;
+        cv::aruco::drawMarker(m_dictionary, id % marker_count, m_marker_size, marker, 1);
+        const int border = m_marker_size / 4;
+        cv::copyMakeBorder(marker, bordered, border, border, border, border, cv::BORDER_CONSTANT, cv::Scalar(255));
+        m_marker_images.push_back(bordered);
+
+        const double direction = angle_dist(m_rng);
+        m_robots.push_back({id,
+                            cv::Point2d(x_dist(m_rng), y_dist(m_rng)),
+                            cv::Point2d(std::cos(direction), std::sin(direction)) * speed,
+                            angle_dist(m_rng),
+                            turn_dist(m_rng)});
+    }
+
+    m_next_frame = std::chrono::steady_clock::now();
+}
+
+void SyntheticCamera::move_robots(double dt)
+{
+    for(auto& robot : m_robots)
+    {
+        robot.position += robot.velocity * dt;
+        robot.heading += robot.turn_rate * dt;
+
+        // Bounce off of the edges of the arena
+        if(robot.position.x < m_marker_size || robot.position.x > m_arena.cols - m_marker_size)
+            robot.velocity.x = -robot.velocity.x;
+        if(robot.position.y < m_marker_size || robot.position.y > m_arena.rows - m_marker_size)
+            robot.velocity.y = -robot.velocity.y;
+        robot.position.x = std::clamp<double>(robot.position.x, m_marker_size, m_arena.cols - m_marker_size);
+        robot.position.y = std::clamp<double>(robot.position.y, m_marker_size, m_arena.rows - m_marker_size);
+    }
+}
+
+bool SyntheticCamera::do_get_frame(Frame& frame)
+{
+    if(m_arena.empty())
+        return false;
+
+    double dt = UNPACED_FRAME_TIME;
+    if(m_frame_rate > 0)
+    {
+        std::this_thread::sleep_until(m_next_frame);
+        dt = 1.0 / m_frame_rate;
+        m_next_frame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(dt));
+    }
+    move_robots(dt);
+
+    // Draw the robots onto the floor. The floor is kept between frames so that it isn't reallocated
+    m_arena.copyTo(m_floor);
+    cv::Mat& floor = m_floor;
+    const cv::Rect floor_rect(cv::Point(), floor.size());
+    auto truth = std::make_shared<std::vector<MarkerTruth>>();
+    truth->reserve(m_robots.size());
+    std::vector<cv::Point2f> corners(4);
+    for(std::size_t i = 0; i < m_robots.size(); ++i)
+    {
+        const Robot& robot = m_robots[i];
+        const cv::Mat& marker = m_marker_images[i];
+        const double c = std::cos(robot.heading);
+        const double s = std::sin(robot.heading);
+        const double half = marker.cols / 2.0;
+
+        // Only warp the area around the robot rather than the whole floor
+        const int reach = cvCeil(half * std::sqrt(2.0));
+        const cv::Rect roi = cv::Rect(cvRound(robot.position.x) - reach, cvRound(robot.position.y) - reach,
+                                      2 * reach, 2 * reach) & floor_rect;
+        if(roi.empty())
+            continue;
+
+        // Rotate the marker image around its center and move it to the robot's position, relative to the roi
+        const cv::Matx23d to_floor(c, -s, robot.position.x - (c * half - s * half),
+                                   s, c, robot.position.y - (s * half + c * half));
+        cv::Matx23d to_roi = to_floor;
+        to_roi(0, 2) -= roi.x;
+        to_roi(1, 2) -= roi.y;
+        cv::Mat target = floor(roi);
+        cv::warpAffine(marker, target, to_roi, roi.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+        // Corners of the marker itself (without its border), in the order that ArUco detects them
+        const double border = (marker.cols - m_marker_size) / 2.0;
+        const cv::Point2d marker_corners[4] = {{border, border}, {border + m_marker_size, border},
+                                               {border + m_marker_size, border + m_marker_size},
+                                               {border, border + m_marker_size}};
+        for(int j = 0; j < 4; ++j)
+        {
+            const cv::Vec2d corner = to_floor * cv::Vec3d(marker_corners[j].x, marker_corners[j].y, 1);
+            corners[j] = cv::Point2f(static_cast<float>(corner[0]), static_cast<float>(corner[1]));
+        }
+
+        MarkerTruth marker_truth;
+        marker_truth.id = robot.id;
+        cv::perspectiveTransform(corners, marker_truth.corners, m_homography);
+        // ArUco's marker axes are x right, y up and z out of the marker, which is towards the camera
+        const cv::Matx33d marker_rotation(c, s, 0,
+                                          s, -c, 0,
+                                          0, 0, -1);
+        cv::Rodrigues(m_camera_rotation * marker_rotation, marker_truth.rvec);
+        marker_truth.tvec = m_camera_rotation * cv::Vec3d(robot.position.x, robot.position.y, 0) + m_camera_translation;
+        truth->push_back(std::move(marker_truth));
+    }
+
+    // Look at the floor through the camera. Frames are rendered in grayscale, and only expanded into a pooled color
+    // frame if a color format was asked for
+    const bool color = get_pixel_format() == PixelFormat::BGR8;
+    Frame rendered;
+    if(!color)
+        acquire_frame(rendered, m_sensor_size, CV_8UC1);
+    cv::Mat& image = color ? m_rendered : rendered.image;
+    cv::warpPerspective(floor, image, m_homography, m_sensor_size, cv::INTER_LINEAR, cv::BORDER_CONSTANT,
+                        cv::Scalar(0));
+    if(m_blur > 0)
+        cv::GaussianBlur(image, image, cv::Size(), m_blur);
+    if(m_noise > 0)
+    {
+        m_noise_image.create(image.size(), CV_16SC1);
+        cv::randn(m_noise_image, 0, m_noise);
+        cv::add(image, m_noise_image, image, cv::noArray(), CV_8U);
+    }
+
+    if(color)
+    {
+        acquire_frame(frame, m_sensor_size, CV_8UC3);
+        cv::cvtColor(image, frame.image, cv::COLOR_GRAY2BGR);
+        frame.format = PixelFormat::BGR8;
+    }
+    else
+    {
+        frame.image = rendered.image;
+        frame.owner = std::move(rendered.owner);
+        frame.format = PixelFormat::MONO8;
+    }
+    frame.offset = cv::Point();
+    frame.ground_truth = std::move(truth);
+    return true;
+}
+
+void SyntheticCamera::update_state(const CameraSystem& camera)
+{
+    const bool scene_changed = camera.marker_dictionary != m_dictionary_id ||
+                               camera.synthetic_robots != m_robot_count ||
+                               camera.synthetic_marker_size != m_marker_size ||
+                               camera.camera_matrix.data != get_camera_calib().matrix.data;
+    const bool changed = scene_changed ||
+                         camera.synthetic_noise != m_noise ||
+                         camera.synthetic_blur != m_blur ||
+                         camera.frame_rate != m_frame_rate;
+
+    // The capture thread reads these while rendering
+    if(changed)
+    {
+        while_capture_paused([&]()
+        {
+            m_dictionary_id = camera.marker_dictionary;
+            m_robot_count = camera.synthetic_robots;
+            m_marker_size = camera.synthetic_marker_size;
+            m_noise = camera.synthetic_noise;
+            m_blur = camera.synthetic_blur;
+            m_frame_rate = camera.frame_rate;
+            m_next_frame = std::chrono::steady_clock::now();
+            return true;
+        });
+    }
+
+    const bool was_connected = is_connected();
+    AbstractCamera::update_state(camera);
+
+    // A new connection sets up the scene itself, otherwise it has to be rebuilt for the new configuration
+    if(scene_changed && was_connected && is_connected())
+    {
+        while_capture_paused([this]()
+        {
+            m_dictionary = cv::aruco::getPredefinedDictionary(m_dictionary_id);
+            reset_scene();
+            return true;
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef MELON_SYNTHETICCAMERA_H
+#define MELON_SYNTHETICCAMERA_H
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <opencv2/aruco.hpp>
+#include "abstractcamera.h"
+
+/** @brief A camera that renders synthetic frames of an arena
+ *
+ * This class is for stress testing detection with far more robots than are physically available. The camera's source
+ * is an image of the arena floor (i.e. one of the sample arenas in arucoMarkers/sampleArenas), which is seen from
+ * straight above through the camera's calibration matrix. CameraSystem::synthetic_robots markers from the camera's
+ * marker dictionary are moved around the arena, and noise and blur are added to each frame. <br>
+ * Every frame carries the known corners and poses of the robot markers in Frame::ground_truth, so detection accuracy
+ * can be measured alongside throughput. Frames are rendered as fast as they are requested, or at CameraSystem::frame_rate
+ *
+ * @note Poses are in pixels of the arena image. Lens distortion isn't rendered
+ */
+class SyntheticCamera : public AbstractCamera
+{
+public:
+    explicit SyntheticCamera(const CameraSystem& camera);
+    ~SyntheticCamera() override;
+
+    void update_state(const CameraSystem& camera) override;
+
+protected:
+    bool do_disconnect() override;
+    bool do_connect() override;
+    bool do_get_frame(Frame& frame) override;
+
+private:
+    /** @brief A robot marker moving around the arena
+     *
+     */
+    struct Robot
+    {
+        int id;
+        // Center of the marker and its velocity, in pixels of the arena image
+        cv::Point2d position;
+        cv::Point2d velocity;
+        // Heading of the marker and its rate of change, in radians
+        double heading;
+        double turn_rate;
+    };
+
+    /** @brief Set up the view of the arena and the robots
+     *
+     * This places the camera above the arena so that the whole arena is in view, and places the robots at random
+     */
+    void reset_scene();
+
+    /** @brief Move the robots by one frame
+     *
+     * @param dt [in] Time since the last frame, in seconds
+     */
+    void move_robots(double dt);
+
+    // Configuration from the camera system
+    int m_dictionary_id {0};
+    int m_robot_count {0};
+    int m_marker_size {0};
+    double m_noise {0};
+    double m_blur {0};
+    double m_frame_rate {0};
+
+    cv::Ptr<cv::aruco::Dictionary> m_dictionary;
+    // Grayscale arena floor and the image of each robot's marker
+    cv::Mat m_arena;
+    std::vector<cv::Mat> m_marker_images;
+    std::vector<Robot> m_robots;
+    std::mt19937 m_rng;
+    // Scratch images that are reused between frames
+    cv::Mat m_floor;
+    cv::Mat m_rendered;
+    cv::Mat m_noise_image;
+
+    // Maps the arena image onto the sensor, and the camera's pose above the arena
+    cv::Mat m_homography;
+    cv::Matx33d m_camera_rotation;
+    cv::Vec3d m_camera_translation;
+    cv::Size m_sensor_size;
+
+    std::chrono::steady_clock::time_point m_next_frame;
+};
+
+#endif //MELON_SYNTHETICCAMERA_H
\ No newline at end of file
@@ -46,12 +46,60 @@ std::string command_handler::do_command(const std::vector<std::string>& tokens,
         }else if(target_system == COLLECTOR_SYS_CMD){
             return collector_system(tokens, current_state);
         }else if(target_system == CAMERA_SYS_CMD){
-            return camera_system(tokens, current_state);
+            return camera_system(tokens, current_state.camera);
+        }else if(target_system.rfind(std::string(CAMERA_SYS_CMD) + CAMERA_NAME_SEPARATOR, 0) == 0){
+            //a named camera, i.e. 'camera:left'
+            std::string camera_name = target_system.substr(std::string(CAMERA_SYS_CMD).size() + 1);
+            if(camera_name.empty()){
+                return "please provide a camera name\n    ex: set camera:left source 0";
+            }else if(camera_name == CameraSystemVars::DEFAULT_CAMERA){
+                return camera_system(tokens, current_state.camera);
+            }
+
+            auto camera = current_state.cameras.find(camera_name);
+            if(camera != current_state.cameras.end()){
+                return camera_system(tokens, camera->second);
+            }else if(tokens[0] != SET_CMD){
+                return "camera '"+camera_name+"' not found";
+            }
+
+            //only setting a variable creates a new camera. It's set on a new camera system first so that an unknown
+            //variable or invalid value doesn't leave an empty camera behind
+            CameraSystem new_camera;
+            bool applied = false;
+            std::string response = camera_system(tokens, new_camera, &applied);
+            if(applied){
+                current_state.cameras.emplace(camera_name, std::move(new_camera));
+            }
+            return response;
+        }else if(target_system == CAMERAS_SYS_CMD){
+            return cameras_system(tokens, current_state);
+        }else if(target_system == THREADS_SYS_CMD){
+            return threads_system(tokens, current_state.threads);
         }else{
             return "target system: '"+target_system+"' not found";
         }
     }else if(command == HELP_CMD){
         return help_command();
+    }else if(command == SHUTDOWN_CMD){
+        current_state.shutdown = true;
+        return "shutting down";
+    }else if(command == START_CMD){
+        if(current_state.pipeline.running){
+            return "pipelines are already running";
+        }
+        current_state.pipeline.running = true;
+        return "starting pipelines";
+    }else if(command == STOP_CMD){
+        if(!current_state.pipeline.running){
+            return "pipelines are already stopped";
+        }
+        current_state.pipeline.running = false;
+        return "stopping pipelines, cameras stay connected";
+    }else if(command == RESTART_CMD){
+        current_state.pipeline.running = true;
+        ++current_state.pipeline.restarts;
+        return "restarting pipelines";
     }else{
         return "command: '"+command+"' not found";
     }
@@ -95,6 +143,137 @@ std::string command_handler::build_matrix_string(const cv::Mat& matrix){
     return response.str();
 }
 
+std::string command_handler::build_roi_string(const CameraSystem& camera){
+    if(camera.auto_roi){
+        return CameraSystemVars::ROI_AUTO;
+    }else if(camera.roi.empty()){
+        return CameraSystemVars::ROI_FULL;
+    }
+
+    std::stringstream response;
+    response << camera.roi.x << "," << camera.roi.y << "," << camera.roi.width << "," << camera.roi.height;
+    return response.str();
+}
+
+std::string command_handler::build_cores_string(const std::vector<int>& cores){
+    if(cores.empty()){
+        return ThreadSystemVars::CORES_ANY;
+    }
+
+    std::stringstream response;
+    for(std::size_t i = 0; i < cores.size(); ++i){
+        response << (i > 0 ? "," : "") << cores[i];
+    }
+    return response.str();
+}
+
+void command_handler::apply_detector_preset(const std::string& preset, CameraSystem& camera){
+    //the balanced preset is ArUco's own defaults, the others start from it
+    const CameraSystem defaults;
+    camera.detector_threshold_win_min = defaults.detector_threshold_win_min;
+    camera.detector_threshold_win_max = defaults.detector_threshold_win_max;
+    camera.detector_threshold_win_step = defaults.detector_threshold_win_step;
+    camera.detector_threshold_constant = defaults.detector_threshold_constant;
+    camera.detector_corner_refinement = defaults.detector_corner_refinement;
+    camera.detector_min_perimeter_rate = defaults.detector_min_perimeter_rate;
+    camera.detector_max_perimeter_rate = defaults.detector_max_perimeter_rate;
+
+    if(preset == CameraSystemVars::DETECTOR_PRESET_FAST){
+        //two threshold passes instead of three, and small contours are skipped before they're approximated
+        camera.detector_threshold_win_min = 5;
+        camera.detector_threshold_win_max = 15;
+        camera.detector_min_perimeter_rate = 0.05;
+    }else if(preset == CameraSystemVars::DETECTOR_PRESET_ACCURATE){
+        //seven threshold passes to find markers under uneven lighting, smaller markers, and sub-pixel corners
+        camera.detector_threshold_win_max = 33;
+        camera.detector_threshold_win_step = 5;
+        camera.detector_min_perimeter_rate = 0.02;
+        camera.detector_corner_refinement = CameraSystemVars::CORNER_REFINEMENT_SUBPIX;
+    }
+}
+
+std::string command_handler::detector_preset_name(const CameraSystem& camera){
+    for(const char* preset : CameraSystemVars::DETECTOR_PRESETS){
+        CameraSystem preset_camera = camera;
+        apply_detector_preset(preset, preset_camera);
+        if(preset_camera == camera){
+            return preset;
+        }
+    }
+    return CameraSystemVars::DETECTOR_PRESET_CUSTOM;
+}
+
+std::string command_handler::set_int_variable(const std::vector<std::string>& tokens, int min_value, int& variable,
+                                              bool* applied){
+    if(tokens.size() != 4){
+        return "please provide an integer for variable '"+tokens[2]+"'\n    ex: set camera "+tokens[2]+" "+std::to_string(min_value);
+    }
+
+    int value;
+    try{
+        value = std::stoi(tokens[3]);
+    }catch(const std::logic_error& err){
+        spdlog::error(err.what());
+        return "please provide a valid integer value";
+    }
+
+    if(value < min_value){
+        return "please provide an integer value of at least "+std::to_string(min_value);
+    }
+
+    variable = value;
+    if(applied != nullptr){
+        *applied = true;
+    }
+    return "'"+tokens[2]+"' variable set with value "+tokens[3];
+}
+
+std::string command_handler::set_double_variable(const std::vector<std::string>& tokens, double min_value, double& variable,
+                                                 bool* applied){
+    if(tokens.size() != 4){
+        return "please provide a number for variable '"+tokens[2]+"'\n    ex: set camera "+tokens[2]+" 1000";
+    }
+
+    double value;
+    try{
+        value = std::stod(tokens[3]);
+    }catch(const std::logic_error& err){
+        spdlog::error(err.what());
+        return "please provide a valid number";
+    }
+
+    if(value < min_value){
+        std::stringstream response;
+        response << "please provide a value of at least " << min_value;
+        return response.str();
+    }
+
+    variable = value;
+    if(applied != nullptr){
+        *applied = true;
+    }
+    return "'"+tokens[2]+"' variable set with value "+tokens[3];
+}
+
+std::string command_handler::set_bool_variable(const std::vector<std::string>& tokens, bool& variable, bool* applied){
+    if(tokens.size() != 4){
+        return "please provide a value for variable '"+tokens[2]+"'\n    ex: set camera "+tokens[2]+" true";
+    }
+
+    if(tokens[3] == "true"){
+        variable = true;
+    }else if(tokens[3] == "false"){
+        variable = false;
+    }else{
+        return "given value for variable '"+tokens[2]+"' is not valid. acceptable values are 'true' and 'false'";
+    }
+
+    if(applied != nullptr){
+        *applied = true;
+    }
+    return "'"+tokens[2]+"' variable set with value "+tokens[3];
+}
+
 std::string command_handler::robot_system(const std::vector<std::string>& tokens, StateVariables& current_state){
     if(tokens[0] == LIST_CMD){
         std::string response = "Current robots:";
@@ -166,6 +345,237 @@ std::string command_handler::robot_system(const std::vector<std::string>& tokens
     }
 }
 
+void command_handler::save_camera_system(const CameraSystem& camera, CameraSys& camera_to_save){
+    //save "type" variable
+    camera_to_save.set_type(camera.type);
+
+    //save "connected" variable
+    camera_to_save.set_connected(camera.connected);
+
+    //save "source" string variable
+    camera_to_save.set_source(camera.source);
+
+    //save "camera_matrix" cv::Mat
+    cv::Mat camera_matrix = camera.camera_matrix;
+    for (int row = 0; row < camera_matrix.rows; ++row) {
+        for (int col = 0; col < camera_matrix.cols; ++col) {
+            camera_to_save.mutable_camera_matrix()->Add(camera_matrix.at<double>(row, col));
+        }
+    }
+
+    //save "distortion_matrix" cv::Mat
+    cv::Mat distortion_matrix = camera.distortion_matrix;
+    for (int row = 0; row < distortion_matrix.rows; ++row) {
+        for (int col = 0; col < distortion_matrix.cols; ++col) {
+            camera_to_save.mutable_distortion_matrix()->Add(distortion_matrix.at<double>(row, col));
+        }
+    }
+
+    //save marker_dictionary int
+    camera_to_save.set_marker_dictionary(camera.marker_dictionary);
+
+    //save camera_options map
+    for(auto const& option : camera.camera_options){
+        (*camera_to_save.mutable_options())[option.first] = option.second;
+    }
+
+    //save capture_buffer_size int
+    camera_to_save.set_capture_buffer_size(camera.capture_buffer_size);
+
+    //save capture_policy string
+    camera_to_save.set_capture_policy(camera.capture_policy);
+
+    //save pixel_format string
+    camera_to_save.set_pixel_format(camera.pixel_format);
+
+    //save roi cv::Rect, as x,y,width,height
+    if(!camera.roi.empty()){
+        camera_to_save.mutable_roi()->Add(camera.roi.x);
+        camera_to_save.mutable_roi()->Add(camera.roi.y);
+        camera_to_save.mutable_roi()->Add(camera.roi.width);
+        camera_to_save.mutable_roi()->Add(camera.roi.height);
+    }
+
+    //save auto_roi, roi_margin, binning and decimation variables
+    camera_to_save.set_auto_roi(camera.auto_roi);
+    camera_to_save.set_roi_margin(camera.roi_margin);
+    camera_to_save.set_binning(camera.binning);
+    camera_to_save.set_decimation(camera.decimation);
+
+    //save acquisition variables
+    camera_to_save.set_exposure_time(camera.exposure_time);
+    camera_to_save.set_gain(camera.gain);
+    camera_to_save.set_frame_rate(camera.frame_rate);
+    camera_to_save.set_stream_buffer_mode(camera.stream_buffer_mode);
+    camera_to_save.set_stream_buffer_count(camera.stream_buffer_count);
+
+    //save replay variables
+    camera_to_save.set_replay_mode(camera.replay_mode);
+    camera_to_save.set_replay_preload(camera.replay_preload);
+    camera_to_save.set_replay_loop(camera.replay_loop);
+
+    //save synthetic camera variables
+    camera_to_save.set_synthetic_robots(camera.synthetic_robots);
+    camera_to_save.set_synthetic_marker_size(camera.synthetic_marker_size);
+    camera_to_save.set_synthetic_noise(camera.synthetic_noise);
+    camera_to_save.set_synthetic_blur(camera.synthetic_blur);
+
+    //save pipeline variables
+    camera_to_save.set_detect_threads(camera.detect_threads);
+    camera_to_save.set_detect_tile_size(camera.detect_tile_size);
+    camera_to_save.set_detect_tile_overlap(camera.detect_tile_overlap);
+    camera_to_save.set_detect_pyramid_levels(camera.detect_pyramid_levels);
+
+    //save display variables
+    camera_to_save.set_display_rate(camera.display_rate);
+
+    //save load shedding and tracking variables
+    camera_to_save.set_latency_budget(camera.latency_budget);
+    camera_to_save.set_tracking_frames(camera.tracking_frames);
+
+    //save detector settings
+    camera_to_save.set_detector_threshold_win_min(camera.detector_threshold_win_min);
+    camera_to_save.set_detector_threshold_win_max(camera.detector_threshold_win_max);
+    camera_to_save.set_detector_threshold_win_step(camera.detector_threshold_win_step);
+    camera_to_save.set_detector_threshold_constant(camera.detector_threshold_constant);
+    camera_to_save.set_detector_corner_refinement(camera.detector_corner_refinement);
+    camera_to_save.set_detector_min_perimeter_rate(camera.detector_min_perimeter_rate);
+    camera_to_save.set_detector_max_perimeter_rate(camera.detector_max_perimeter_rate);
+}
+
+void command_handler::load_camera_system(const CameraSys& loaded_camera, CameraSystem& camera){
+    //fill type variable from loaded state
+    camera.type = loaded_camera.type();
+
+    //fill connected variable from loaded state
+    camera.connected = loaded_camera.connected();
+
+    //fill source variable from loaded state
+    camera.source = loaded_camera.source();
+
+    //camera_matrix state variable, fill from loaded state
+    std::vector<double> values;
+    if(!loaded_camera.camera_matrix().empty()){
+        for(auto const &value : loaded_camera.camera_matrix()){
+            values.push_back(value);
+        };
+        cv::Mat new_camera_matrix (values);
+        camera.camera_matrix = new_camera_matrix.reshape(1, CameraSystemVars::CAMERA_MATRIX_ROWS).clone();
+    }
+
+
+    //distortion_state variable, fill from loaded state
+    if(!loaded_camera.distortion_matrix().empty()){
+        values.clear();
+        for(auto const &value : loaded_camera.distortion_matrix()){
+            values.push_back(value);
+        }
+        cv::Mat new_distortion_matrix (values);
+        camera.distortion_matrix = new_distortion_matrix.reshape(1, CameraSystemVars::DISTORTION_MATRIX_ROWS).clone();
+    }
+
+    //fill marker_dictionary variable from loaded state
+    camera.marker_dictionary = loaded_camera.marker_dictionary();
+
+    //camera_options map from loaded state
+    for(auto const &option : loaded_camera.options()){
+        camera.camera_options.insert(std::pair<std::string, bool>(option.first, option.second));
+    }
+
+    //fill capture_buffer_size variable from loaded state
+    camera.capture_buffer_size = loaded_camera.capture_buffer_size();
+
+    //fill capture_policy variable from loaded state, states saved before it existed keep the default
+    if(!loaded_camera.capture_policy().empty()){
+        camera.capture_policy = loaded_camera.capture_policy();
+    }
+
+    //fill pixel_format variable from loaded state, states saved before it existed keep the default
+    if(!loaded_camera.pixel_format().empty()){
+        camera.pixel_format = loaded_camera.pixel_format();
+    }
+
+    //fill roi variable from loaded state
+    if(loaded_camera.roi_size() == 4){
+        const auto& roi = loaded_camera.roi();
+        camera.roi = cv::Rect(roi.Get(0), roi.Get(1), roi.Get(2), roi.Get(3));
+    }
+
+    //fill auto_roi, roi_margin, binning and decimation variables from loaded state. Binning and decimation are 0 in
+    //states saved before they existed, so only use valid ones. A margin of 0 is valid, so only its presence is checked
+    camera.auto_roi = loaded_camera.auto_roi();
+    if(loaded_camera.has_roi_margin()){
+        camera.roi_margin = loaded_camera.roi_margin();
+    }
+    if(loaded_camera.binning() > 0){
+        camera.binning = loaded_camera.binning();
+    }
+    if(loaded_camera.decimation() > 0){
+        camera.decimation = loaded_camera.decimation();
+    }
+
+    //fill acquisition variables from loaded state
+    camera.exposure_time = loaded_camera.exposure_time();
+    //automatic gain used to be 0, which states saved back then leave out, so they keep the default of automatic gain
+    if(loaded_camera.has_gain()){
+        camera.gain = loaded_camera.gain();
+    }
+    camera.frame_rate = loaded_camera.frame_rate();
+    if(!loaded_camera.stream_buffer_mode().empty()){
+        camera.stream_buffer_mode = loaded_camera.stream_buffer_mode();
+    }
+    camera.stream_buffer_count = loaded_camera.stream_buffer_count();
+
+    //fill replay variables from loaded state
+    if(!loaded_camera.replay_mode().empty()){
+        camera.replay_mode = loaded_camera.replay_mode();
+    }
+    camera.replay_preload = loaded_camera.replay_preload();
+    //states saved before looping could be turned off leave it out, so they keep the default of looping
+    if(loaded_camera.has_replay_loop()){
+        camera.replay_loop = loaded_camera.replay_loop();
+    }
+
+    //fill synthetic camera variables from loaded state
+    camera.synthetic_robots = loaded_camera.synthetic_robots();
+    if(loaded_camera.synthetic_marker_size() > 0){
+        camera.synthetic_marker_size = loaded_camera.synthetic_marker_size();
+    }
+    camera.synthetic_noise = loaded_camera.synthetic_noise();
+    camera.synthetic_blur = loaded_camera.synthetic_blur();
+
+    //fill pipeline variables from loaded state
+    if(loaded_camera.detect_threads() > 0){
+        camera.detect_threads = loaded_camera.detect_threads();
+    }
+    camera.detect_tile_size = loaded_camera.detect_tile_size();
+    if(loaded_camera.detect_tile_overlap() > 0){
+        camera.detect_tile_overlap = loaded_camera.detect_tile_overlap();
+    }
+    camera.detect_pyramid_levels = loaded_camera.detect_pyramid_levels();
+
+    //fill display variables from loaded state. A rate of 0 turns the display off, so only its presence is checked
+    if(loaded_camera.has_display_rate()){
+        camera.display_rate = loaded_camera.display_rate();
+    }
+
+    //fill load shedding and tracking variables from loaded state
+    camera.latency_budget = loaded_camera.latency_budget();
+    camera.tracking_frames = loaded_camera.tracking_frames();
+
+    //fill detector settings from loaded state. The window sizes are at least 3 once saved, so states saved before the
+    //settings existed keep the defaults
+    if(loaded_camera.detector_threshold_win_min() > 0){
+        camera.detector_threshold_win_min = loaded_camera.detector_threshold_win_min();
+        camera.detector_threshold_win_max = loaded_camera.detector_threshold_win_max();
+        camera.detector_threshold_win_step = loaded_camera.detector_threshold_win_step();
+        camera.detector_threshold_constant = loaded_camera.detector_threshold_constant();
+        camera.detector_corner_refinement = loaded_camera.detector_corner_refinement();
+        camera.detector_min_perimeter_rate = loaded_camera.detector_min_perimeter_rate();
+        camera.detector_max_perimeter_rate = loaded_camera.detector_max_perimeter_rate();
+    }
+}
+
 std::string command_handler::state_system(const std::vector<std::string>& tokens, StateVariables& current_state){
     if(!std::filesystem::exists(StateSystemVars::SAVE_DIR)){
         std::error_code ec;
@@ -202,38 +612,23 @@ std::string command_handler::state_system(const std::vector<std::string>& tokens
             (*state_to_save.mutable_collector_system()->mutable_collectors())[collector.first] = endpoint;
         }
 
-        //save "type" variable
-        state_to_save.mutable_camera_system()->set_type(current_state.camera.type);
-
-        //save "connected" variable
-        state_to_save.mutable_camera_system()->set_connected(current_state.camera.connected);
-
-        //save "source" string variable
-        state_to_save.mutable_camera_system()->set_source(current_state.camera.source);
-
-        //save "camera_matrix" cv::Mat
-        cv::Mat camera_matrix = current_state.camera.camera_matrix;
-        for (int row = 0; row < camera_matrix.rows; ++row) {
-            for (int col = 0; col < camera_matrix.cols; ++col) {
-                state_to_save.mutable_camera_system()->mutable_camera_matrix()->Add(camera_matrix.at<double>(row, col));
-            }
-        }
-
-        //save "distortion_matrix" cv::Mat
-        cv::Mat distortion_matrix = current_state.camera.distortion_matrix;
-        for (int row = 0; row < distortion_matrix.rows; ++row) {
-            for (int col = 0; col < distortion_matrix.cols; ++col) {
-                state_to_save.mutable_camera_system()->mutable_distortion_matrix()->Add(distortion_matrix.at<double>(row, col));
-            }
+        //save camera systems
+        save_camera_system(current_state.camera, *state_to_save.mutable_camera_system());
+        for(auto const& camera : current_state.cameras){
+            save_camera_system(camera.second, (*state_to_save.mutable_cameras())[camera.first]);
         }
 
-        //save marker_dictionary int
-        state_to_save.mutable_camera_system()->set_marker_dictionary(current_state.camera.marker_dictionary);
-
-        //save camera_options map
-        for(auto const& option : current_state.camera.camera_options){
-            (*state_to_save.mutable_camera_system()->mutable_options())[option.first] = option.second;
-        }
+        //save thread placement
+        ThreadSys* threads_to_save = state_to_save.mutable_thread_system();
+        for(int core : current_state.threads.capture_cores)
+            threads_to_save->add_capture_cores(core);
+        for(int core : current_state.threads.detect_cores)
+            threads_to_save->add_detect_cores(core);
+        for(int core : current_state.threads.publish_cores)
+            threads_to_save->add_publish_cores(core);
+        for(int core : current_state.threads.housekeeping_cores)
+            threads_to_save->add_housekeeping_cores(core);
+        threads_to_save->set_capture_priority(current_state.threads.capture_priority);
 
         std::fstream output(StateSystemVars::SAVE_DIR+save_name, std::ios::out | std::ios::trunc | std::ios::binary);
         state_to_save.SerializeToOstream(&output);
@@ -255,8 +650,10 @@ std::string command_handler::state_system(const std::vector<std::string>& tokens
         }
         state_to_load.ParseFromIstream(&input);
 
-        //clear current state
+        //clear current state, but don't stop or restart the pipelines
+        PipelineSystem pipeline = current_state.pipeline;
         current_state = StateVariables();
+        current_state.pipeline = pipeline;
 
         //robots state variable, fill from loaded State instance above
         for(auto const &robot : state_to_load.robot_system().robots()){
@@ -275,43 +672,19 @@ std::string command_handler::state_system(const std::vector<std::string>& tokens
             current_state.collector.collectors.insert(std::pair(collector.first, endpoint));
         }
 
-        //fill type variable from loaded state
-        current_state.camera.type = state_to_load.camera_system().type();
-
-        //fill connected variable from loaded state
-        current_state.camera.connected = state_to_load.camera_system().connected();
-
-        //fill source variable from loaded state
-        current_state.camera.source = state_to_load.camera_system().source();
-
-        //camera_matrix state variable, fill from loaded state
-        std::vector<double> values;
-        if(!state_to_load.camera_system().camera_matrix().empty()){
-            for(auto const &value : state_to_load.camera_system().camera_matrix()){
-                values.push_back(value);
-            };
-            cv::Mat new_camera_matrix (values);
-            current_state.camera.camera_matrix = new_camera_matrix.reshape(1, CameraSystemVars::CAMERA_MATRIX_ROWS).clone();
-        }
-
-
-        //distortion_state variable, fill from loaded state
-        if(!state_to_load.camera_system().distortion_matrix().empty()){
-            values.clear();
-            for(auto const &value : state_to_load.camera_system().distortion_matrix()){
-                values.push_back(value);
-            }
-            cv::Mat new_distortion_matrix (values);
-            current_state.camera.distortion_matrix = new_distortion_matrix.reshape(1, CameraSystemVars::DISTORTION_MATRIX_ROWS).clone();
+        //camera systems, fill from loaded state
+        load_camera_system(state_to_load.camera_system(), current_state.camera);
+        for(auto const& camera : state_to_load.cameras()){
+            load_camera_system(camera.second, current_state.cameras[camera.first]);
         }
 
-        //fill marker_dictionary variable from loaded state
-        current_state.camera.marker_dictionary = state_to_load.camera_system().marker_dictionary();
-
-        //camera_options map from loaded state
-        for(auto const &option : state_to_load.camera_system().options()){
-            current_state.camera.camera_options.insert(std::pair<std::string, bool>(option.first, option.second));
-        }
+        //thread placement, fill from loaded state
+        const ThreadSys& loaded_threads = state_to_load.thread_system();
+        current_state.threads.capture_cores.assign(loaded_threads.capture_cores().begin(), loaded_threads.capture_cores().end());
+        current_state.threads.detect_cores.assign(loaded_threads.detect_cores().begin(), loaded_threads.detect_cores().end());
+        current_state.threads.publish_cores.assign(loaded_threads.publish_cores().begin(), loaded_threads.publish_cores().end());
+        current_state.threads.housekeeping_cores.assign(loaded_threads.housekeeping_cores().begin(), loaded_threads.housekeeping_cores().end());
+        current_state.threads.capture_priority = loaded_threads.capture_priority();
 
         input.close();
         return "current state loaded from '"+load_name+"'";
@@ -325,7 +698,9 @@ std::string command_handler::state_system(const std::vector<std::string>& tokens
         //if value is 'current', clear out current state
         //if not, attempt to delete given save state's file
         if(state_to_delete == StateSystemVars::CURRENT_KEYWORD){
+            PipelineSystem pipeline = current_state.pipeline;
             current_state = StateVariables();
+            current_state.pipeline = pipeline;
             return "current state has been cleared";
         }else{
             if(std::filesystem::remove((StateSystemVars::SAVE_DIR+state_to_delete).c_str())){
@@ -425,40 +800,101 @@ std::string command_handler::collector_system(const std::vector<std::string>& to
     }
 }
 
-std::string command_handler::camera_system(const std::vector<std::string>& tokens, StateVariables& current_state){
+std::string command_handler::camera_system(const std::vector<std::string>& tokens, CameraSystem& camera, bool* applied){
     if(tokens[0] == LIST_CMD){
         std::stringstream response;
         response << "Current camera variables:";
 
         //add type variable
-        response << "\n    " << CameraSystemVars::TYPE << ": " << current_state.camera.type;
+        response << "\n    " << CameraSystemVars::TYPE << ": " << camera.type;
 
         //add connected variable
-        response << "\n    " << CameraSystemVars::CONNECTED << ": " << std::boolalpha << current_state.camera.connected;
+        response << "\n    " << CameraSystemVars::CONNECTED << ": " << std::boolalpha << camera.connected;
 
         //add source variable
-        response << "\n    " << CameraSystemVars::SOURCE << ": " << current_state.camera.source;
+        response << "\n    " << CameraSystemVars::SOURCE << ": " << camera.source;
 
         //add camera_matrix variable
         response << "\n    camera_matrix: ";
-        cv::Mat camera_matrix = current_state.camera.camera_matrix;
+        cv::Mat camera_matrix = camera.camera_matrix;
         response << build_matrix_string(camera_matrix);
 
         //add distortion_matrix variable
         response << "\n    distortion_matrix: ";
-        cv::Mat distortion_matrix = current_state.camera.distortion_matrix;
+        cv::Mat distortion_matrix = camera.distortion_matrix;
         response << build_matrix_string(distortion_matrix);
 
         //add marker_dictionary variable
         response << "\n    marker_dictionary: ";
-        response << current_state.camera.marker_dictionary;
+        response << camera.marker_dictionary;
 
         //add camera_option variable
         response << "\n    camera_options: ";
-        for(auto const &option : current_state.camera.camera_options){
+        for(auto const &option : camera.camera_options){
             response << "\n        " << option.first << ": " << std::boolalpha << option.second;
         }
 
+        //add capture_buffer_size variable
+        response << "\n    " << CameraSystemVars::CAPTURE_BUFFER_SIZE << ": " << camera.capture_buffer_size;
+
+        //add capture_policy variable
+        response << "\n    " << CameraSystemVars::CAPTURE_POLICY << ": " << camera.capture_policy;
+
+        //add pixel_format variable
+        response << "\n    " << CameraSystemVars::PIXEL_FORMAT << ": " << camera.pixel_format;
+
+        //add sensor region variables
+        response << "\n    " << CameraSystemVars::ROI << ": " << build_roi_string(camera);
+        response << "\n    " << CameraSystemVars::ROI_MARGIN << ": " << camera.roi_margin;
+        response << "\n    " << CameraSystemVars::BINNING << ": " << camera.binning;
+        response << "\n    " << CameraSystemVars::DECIMATION << ": " << camera.decimation;
+
+        //add acquisition variables
+        response << "\n    " << CameraSystemVars::EXPOSURE_TIME << ": " << camera.exposure_time;
+        response << "\n    " << CameraSystemVars::GAIN << ": ";
+        if(camera.gain < 0){
+            response << CameraSystemVars::GAIN_AUTO;
+        }else{
+            response << camera.gain;
+        }
+        response << "\n    " << CameraSystemVars::FRAME_RATE << ": " << camera.frame_rate;
+        response << "\n    " << CameraSystemVars::STREAM_BUFFER_MODE << ": " << camera.stream_buffer_mode;
+        response << "\n    " << CameraSystemVars::STREAM_BUFFER_COUNT << ": " << camera.stream_buffer_count;
+
+        //add replay variables
+        response << "\n    " << CameraSystemVars::REPLAY_MODE << ": " << camera.replay_mode;
+        response << "\n    " << CameraSystemVars::REPLAY_PRELOAD << ": " << std::boolalpha << camera.replay_preload;
+        response << "\n    " << CameraSystemVars::REPLAY_LOOP << ": " << std::boolalpha << camera.replay_loop;
+
+        //add synthetic camera variables
+        response << "\n    " << CameraSystemVars::SYNTHETIC_ROBOTS << ": " << camera.synthetic_robots;
+        response << "\n    " << CameraSystemVars::SYNTHETIC_MARKER_SIZE << ": " << camera.synthetic_marker_size;
+        response << "\n    " << CameraSystemVars::SYNTHETIC_NOISE << ": " << camera.synthetic_noise;
+        response << "\n    " << CameraSystemVars::SYNTHETIC_BLUR << ": " << camera.synthetic_blur;
+
+        //add pipeline variables
+        response << "\n    " << CameraSystemVars::DETECT_THREADS << ": " << camera.detect_threads;
+        response << "\n    " << CameraSystemVars::DETECT_TILE_SIZE << ": " << camera.detect_tile_size;
+        response << "\n    " << CameraSystemVars::DETECT_TILE_OVERLAP << ": " << camera.detect_tile_overlap;
+        response << "\n    " << CameraSystemVars::DETECT_PYRAMID_LEVELS << ": " << camera.detect_pyramid_levels;
+
+        //add display variables
+        response << "\n    " << CameraSystemVars::DISPLAY_RATE << ": " << camera.display_rate;
+
+        //add load shedding and tracking variables
+        response << "\n    " << CameraSystemVars::LATENCY_BUDGET << ": " << camera.latency_budget;
+        response << "\n    " << CameraSystemVars::TRACKING_FRAMES << ": " << camera.tracking_frames;
+
+        //add detector settings
+        response << "\n    " << CameraSystemVars::DETECTOR_PRESET << ": " << detector_preset_name(camera);
+        response << "\n    " << CameraSystemVars::DETECTOR_THRESHOLD_WIN_MIN << ": " << camera.detector_threshold_win_min;
+        response << "\n    " << CameraSystemVars::DETECTOR_THRESHOLD_WIN_MAX << ": " << camera.detector_threshold_win_max;
+        response << "\n    " << CameraSystemVars::DETECTOR_THRESHOLD_WIN_STEP << ": " << camera.detector_threshold_win_step;
+        response << "\n    " << CameraSystemVars::DETECTOR_THRESHOLD_CONSTANT << ": " << camera.detector_threshold_constant;
+        response << "\n    " << CameraSystemVars::DETECTOR_CORNER_REFINEMENT << ": " << camera.detector_corner_refinement;
+        response << "\n    " << CameraSystemVars::DETECTOR_MIN_PERIMETER_RATE << ": " << camera.detector_min_perimeter_rate;
+        response << "\n    " << CameraSystemVars::DETECTOR_MAX_PERIMETER_RATE << ": " << camera.detector_max_perimeter_rate;
+
         return response.str();
     }else if(tokens[0] == SET_CMD){
         if(tokens.size() < 3){
@@ -466,6 +902,12 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
         }
 
         std::string variable = tokens[2];
+        //called right before returning from a set that was applied
+        const auto accept = [applied]{
+            if(applied != nullptr){
+                *applied = true;
+            }
+        };
 
         if(variable == CameraSystemVars::TYPE){
             std::string value;
@@ -492,25 +934,28 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
                 return ss.str();
             }
 
-            current_state.camera.type = value;
+            camera.type = value;
+            accept();
             return "camera " + variable + " set to '" + value + "'";
         }else if(variable == CameraSystemVars::CONNECTED){
             if(tokens.size() != 4)
                 return "please provide a value for variable '"+variable+"'\n    ex: set camera "+variable+" true";
 
             if(tokens[3] == "true")
-                current_state.camera.connected = true;
+                camera.connected = true;
             else if(tokens[3] == "false")
-                current_state.camera.connected = false;
+                camera.connected = false;
             else
                 return "given value for variable +'"+variable+"' is not valid. acceptable values are 'true' and 'false'";
 
+            accept();
             return "camera "+variable+" set to '"+tokens[3]+"'";
         }else if(variable == CameraSystemVars::SOURCE){
             if(tokens.size() != 4){
                 return "please provide a value for variable '"+variable+"'\n    ex: set camera source http://example.com";
             }
-            current_state.camera.source = tokens[3];
+            camera.source = tokens[3];
+            accept();
             return "camera source set to '"+tokens[3]+"'";
         }else if(variable == CameraSystemVars::CAM_MATRIX || variable == CameraSystemVars::DIST_MATRIX){
             // since camera_matrix/distortion_matrix are the same data type/format, just use a conditional to assign a
@@ -527,7 +972,8 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
                 }
 
                 try{
-                    current_state.camera.camera_matrix = values_by_comma_to_mat(values, CameraSystemVars::CAMERA_MATRIX_ROWS);
+                    camera.camera_matrix = values_by_comma_to_mat(values, CameraSystemVars::CAMERA_MATRIX_ROWS);
+                    accept();
                     return "'"+variable+"' variable set with values "+tokens[3];
                 }catch(const std::invalid_argument& err){
                     spdlog::error(err.what());
@@ -539,7 +985,8 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
                 }
 
                 try{
-                    current_state.camera.distortion_matrix = values_by_comma_to_mat(values, CameraSystemVars::DISTORTION_MATRIX_ROWS);
+                    camera.distortion_matrix = values_by_comma_to_mat(values, CameraSystemVars::DISTORTION_MATRIX_ROWS);
+                    accept();
                     return "'"+variable+"' variable set with values "+tokens[3];
                 }catch(const std::invalid_argument& err){
                     spdlog::error(err.what());
@@ -551,13 +998,21 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
                 return "please provide an integer for variable '"+variable+"'\n    ex: set camera "+variable+" 6";
             }
 
+            int dictionary;
             try{
-                current_state.camera.marker_dictionary = std::stoi(tokens[3]);
-            }catch(const std::invalid_argument& err){
+                dictionary = std::stoi(tokens[3]);
+            }catch(const std::logic_error& err){
                 spdlog::error(err.what());
                 return "please provide a valid integer value";
             }
 
+            //the detector can only be created from one of ArUco's predefined dictionaries
+            if(dictionary < 0 || dictionary > CameraSystemVars::MAX_MARKER_DICT){
+                return "please provide an integer value between 0 and "+std::to_string(CameraSystemVars::MAX_MARKER_DICT);
+            }
+            camera.marker_dictionary = dictionary;
+
+            accept();
             return "'"+variable+"' variable set with value "+tokens[3];
         }else if(variable == CameraSystemVars::OPTIONS){
             if(tokens.size() != 5){
@@ -568,13 +1023,165 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
             bool option_value = (tokens[4] == "true");
 
             //if the option already exists, update it, if not insert into camera_options map
-            auto index_found = current_state.camera.camera_options.find(option_name);
-            if(index_found != current_state.camera.camera_options.end()) {
+            auto index_found = camera.camera_options.find(option_name);
+            if(index_found != camera.camera_options.end()) {
                 index_found->second = option_value;
             }else{
-                current_state.camera.camera_options.insert(std::pair<std::string, bool>(option_name, option_value));
+                camera.camera_options.insert(std::pair<std::string, bool>(option_name, option_value));
             }
+            accept();
             return "'"+option_name+"' set to "+std::to_string(option_value);
+        }else if(variable == CameraSystemVars::CAPTURE_BUFFER_SIZE){
+            return set_int_variable(tokens, 0, camera.capture_buffer_size, applied);
+        }else if(variable == CameraSystemVars::CAPTURE_POLICY){
+            return set_option_variable(tokens, CameraSystemVars::CAPTURE_POLICIES, camera.capture_policy, applied);
+        }else if(variable == CameraSystemVars::PIXEL_FORMAT){
+            return set_option_variable(tokens, CameraSystemVars::PIXEL_FORMATS, camera.pixel_format, applied);
+        }else if(variable == CameraSystemVars::ROI){
+            if(tokens.size() != 4){
+                return "please provide a region as x,y,width,height, or 'auto' to fit the region to the arena, or 'full' for the full sensor\n    ex: set camera "+variable+" 0,0,1920,1080";
+            }
+
+            if(tokens[3] == CameraSystemVars::ROI_AUTO){
+                // The manually set region (if any) is kept as the bounds for the automatic region
+                camera.auto_roi = true;
+                accept();
+                return "camera "+variable+" set to 'auto'";
+            }else if(tokens[3] == CameraSystemVars::ROI_FULL){
+                camera.auto_roi = false;
+                camera.roi = cv::Rect();
+                accept();
+                return "camera "+variable+" set to 'full'";
+            }
+
+            std::vector<std::string> values = tokenize_values_by_commas(tokens[3]);
+            if(values.size() != 4){
+                return "please provide a comma separated list of 4 integers, "+std::to_string(values.size())+" given";
+            }
+
+            std::vector<int> values_as_int;
+            for(const auto& value : values){
+                try{
+                    values_as_int.push_back(std::stoi(value));
+                }catch(const std::logic_error& err){
+                    return "please provide a comma separated list of integers";
+                }
+            }
+
+            cv::Rect roi(values_as_int[0], values_as_int[1], values_as_int[2], values_as_int[3]);
+            if(roi.x < 0 || roi.y < 0 || roi.width <= 0 || roi.height <= 0){
+                return "please provide a non-negative offset and a positive width and height";
+            }
+
+            camera.auto_roi = false;
+            camera.roi = roi;
+            accept();
+            return "'"+variable+"' variable set with values "+tokens[3];
+        }else if(variable == CameraSystemVars::ROI_MARGIN){
+            return set_int_variable(tokens, 0, camera.roi_margin, applied);
+        }else if(variable == CameraSystemVars::BINNING){
+            return set_int_variable(tokens, 1, camera.binning, applied);
+        }else if(variable == CameraSystemVars::DECIMATION){
+            return set_int_variable(tokens, 1, camera.decimation, applied);
+        }else if(variable == CameraSystemVars::EXPOSURE_TIME){
+            return set_double_variable(tokens, 0, camera.exposure_time, applied);
+        }else if(variable == CameraSystemVars::GAIN){
+            if(tokens.size() == 4 && tokens[3] == CameraSystemVars::GAIN_AUTO){
+                camera.gain = CameraSystem{}.gain;
+                accept();
+                return "camera "+variable+" set to 'auto'";
+            }
+            return set_double_variable(tokens, 0, camera.gain, applied);
+        }else if(variable == CameraSystemVars::FRAME_RATE){
+            return set_double_variable(tokens, 0, camera.frame_rate, applied);
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_MODE){
+            return set_option_variable(tokens, CameraSystemVars::STREAM_BUFFER_MODES, camera.stream_buffer_mode, applied);
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_COUNT){
+            return set_int_variable(tokens, 0, camera.stream_buffer_count, applied);
+        }else if(variable == CameraSystemVars::REPLAY_MODE){
+            return set_option_variable(tokens, CameraSystemVars::REPLAY_MODES, camera.replay_mode, applied);
+        }else if(variable == CameraSystemVars::REPLAY_PRELOAD){
+            return set_bool_variable(tokens, camera.replay_preload, applied);
+        }else if(variable == CameraSystemVars::REPLAY_LOOP){
+            return set_bool_variable(tokens, camera.replay_loop, applied);
+        }else if(variable == CameraSystemVars::SYNTHETIC_ROBOTS){
+            return set_int_variable(tokens, 0, camera.synthetic_robots, applied);
+        }else if(variable == CameraSystemVars::SYNTHETIC_MARKER_SIZE){
+            return set_int_variable(tokens, 8, camera.synthetic_marker_size, applied);
+        }else if(variable == CameraSystemVars::SYNTHETIC_NOISE){
+            return set_double_variable(tokens, 0, camera.synthetic_noise, applied);
+        }else if(variable == CameraSystemVars::SYNTHETIC_BLUR){
+            return set_double_variable(tokens, 0, camera.synthetic_blur, applied);
+        }else if(variable == CameraSystemVars::DETECT_THREADS){
+            return set_int_variable(tokens, 1, camera.detect_threads, applied);
+        }else if(variable == CameraSystemVars::DETECT_TILE_SIZE){
+            return set_int_variable(tokens, 0, camera.detect_tile_size, applied);
+        }else if(variable == CameraSystemVars::DETECT_TILE_OVERLAP){
+            return set_int_variable(tokens, 0, camera.detect_tile_overlap, applied);
+        }else if(variable == CameraSystemVars::DETECT_PYRAMID_LEVELS){
+            //only apply the value if it's within range
+            int levels = camera.detect_pyramid_levels;
+            bool valid = false;
+            std::string response = set_int_variable(tokens, 0, levels, &valid);
+            if(levels > CameraSystemVars::MAX_PYRAMID_LEVELS){
+                return "please provide an integer value of at most "+std::to_string(CameraSystemVars::MAX_PYRAMID_LEVELS);
+            }
+            camera.detect_pyramid_levels = levels;
+            if(valid){
+                accept();
+            }
+            return response;
+        }else if(variable == CameraSystemVars::DISPLAY_RATE){
+            return set_double_variable(tokens, 0, camera.display_rate, applied);
+        }else if(variable == CameraSystemVars::LATENCY_BUDGET){
+            return set_double_variable(tokens, 0, camera.latency_budget, applied);
+        }else if(variable == CameraSystemVars::TRACKING_FRAMES){
+            return set_int_variable(tokens, 0, camera.tracking_frames, applied);
+        }else if(variable == CameraSystemVars::DETECTOR_PRESET){
+            std::string preset;
+            std::string response = set_option_variable(tokens, CameraSystemVars::DETECTOR_PRESETS, preset, applied);
+            if(!preset.empty()){
+                apply_detector_preset(preset, camera);
+            }
+            return response;
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MIN){
+            //only apply the window size if it keeps the smallest one below the largest
+            int size = camera.detector_threshold_win_min;
+            bool valid = false;
+            std::string response = set_int_variable(tokens, CameraSystemVars::MIN_THRESHOLD_WINDOW, size, &valid);
+            if(size > camera.detector_threshold_win_max){
+                return "please provide an integer value of at most "+std::to_string(camera.detector_threshold_win_max);
+            }
+            camera.detector_threshold_win_min = size;
+            if(valid){
+                accept();
+            }
+            return response;
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MAX){
+            return set_int_variable(tokens, camera.detector_threshold_win_min, camera.detector_threshold_win_max, applied);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_STEP){
+            return set_int_variable(tokens, 1, camera.detector_threshold_win_step, applied);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_CONSTANT){
+            return set_double_variable(tokens, 0, camera.detector_threshold_constant, applied);
+        }else if(variable == CameraSystemVars::DETECTOR_CORNER_REFINEMENT){
+            return set_option_variable(tokens, CameraSystemVars::CORNER_REFINEMENTS, camera.detector_corner_refinement, applied);
+        }else if(variable == CameraSystemVars::DETECTOR_MIN_PERIMETER_RATE){
+            //only apply the rate if it keeps the smallest perimeter below the largest
+            double rate = camera.detector_min_perimeter_rate;
+            bool valid = false;
+            std::string response = set_double_variable(tokens, 0, rate, &valid);
+            if(rate > camera.detector_max_perimeter_rate){
+                std::stringstream error;
+                error << "please provide a value of at most " << camera.detector_max_perimeter_rate;
+                return error.str();
+            }
+            camera.detector_min_perimeter_rate = rate;
+            if(valid){
+                accept();
+            }
+            return response;
+        }else if(variable == CameraSystemVars::DETECTOR_MAX_PERIMETER_RATE){
+            return set_double_variable(tokens, camera.detector_min_perimeter_rate, camera.detector_max_perimeter_rate, applied);
         }
 
         return "variable '"+variable+"' does not exist";
@@ -586,35 +1193,124 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
         std::string variable = tokens[2];
 
         if(variable == CameraSystemVars::TYPE){
-            return variable + ": " + current_state.camera.type;
+            return variable + ": " + camera.type;
         }else if(variable == CameraSystemVars::CONNECTED){
-            return variable+": " + (current_state.camera.connected ? "true" : "false");
+            return variable+": " + (camera.connected ? "true" : "false");
         }else if(variable == CameraSystemVars::SOURCE){
-            return variable+": "+current_state.camera.source;
+            return variable+": "+camera.source;
         }else if(variable == CameraSystemVars::CAM_MATRIX || variable == CameraSystemVars::DIST_MATRIX) {
             std::stringstream response;
             response << variable << ": ";
 
             cv::Mat matrix_to_get;
             if(variable == CameraSystemVars::CAM_MATRIX){
-                matrix_to_get = current_state.camera.camera_matrix;
+                matrix_to_get = camera.camera_matrix;
             }else{
-                matrix_to_get = current_state.camera.distortion_matrix;
+                matrix_to_get = camera.distortion_matrix;
             }
 
             response << build_matrix_string(matrix_to_get);
 
             return response.str();
         }else if(variable == CameraSystemVars::MARKER_DICT){
-            return "marker_dictionary: "+std::to_string(current_state.camera.marker_dictionary);
+            return "marker_dictionary: "+std::to_string(camera.marker_dictionary);
         }else if(variable == CameraSystemVars::OPTIONS){
             std::stringstream response;
             response << variable << ": ";
 
-            for(auto const &option : current_state.camera.camera_options){
+            for(auto const &option : camera.camera_options){
                 response << "\n    " << option.first << ": " << std::boolalpha << option.second;
             }
 
+            return response.str();
+        }else if(variable == CameraSystemVars::CAPTURE_BUFFER_SIZE){
+            return variable+": "+std::to_string(camera.capture_buffer_size);
+        }else if(variable == CameraSystemVars::CAPTURE_POLICY){
+            return variable+": "+camera.capture_policy;
+        }else if(variable == CameraSystemVars::PIXEL_FORMAT){
+            return variable+": "+camera.pixel_format;
+        }else if(variable == CameraSystemVars::ROI){
+            return variable+": "+build_roi_string(camera);
+        }else if(variable == CameraSystemVars::ROI_MARGIN){
+            return variable+": "+std::to_string(camera.roi_margin);
+        }else if(variable == CameraSystemVars::BINNING){
+            return variable+": "+std::to_string(camera.binning);
+        }else if(variable == CameraSystemVars::DECIMATION){
+            return variable+": "+std::to_string(camera.decimation);
+        }else if(variable == CameraSystemVars::EXPOSURE_TIME || variable == CameraSystemVars::GAIN ||
+                 variable == CameraSystemVars::FRAME_RATE){
+            std::stringstream response;
+            response << variable << ": ";
+            if(variable == CameraSystemVars::EXPOSURE_TIME){
+                response << camera.exposure_time;
+            }else if(variable == CameraSystemVars::GAIN){
+                if(camera.gain < 0){
+                    response << CameraSystemVars::GAIN_AUTO;
+                }else{
+                    response << camera.gain;
+                }
+            }else{
+                response << camera.frame_rate;
+            }
+            return response.str();
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_MODE){
+            return variable+": "+camera.stream_buffer_mode;
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_COUNT){
+            return variable+": "+std::to_string(camera.stream_buffer_count);
+        }else if(variable == CameraSystemVars::REPLAY_MODE){
+            return variable+": "+camera.replay_mode;
+        }else if(variable == CameraSystemVars::REPLAY_PRELOAD){
+            return variable+": "+(camera.replay_preload ? "true" : "false");
+        }else if(variable == CameraSystemVars::REPLAY_LOOP){
+            return variable+": "+(camera.replay_loop ? "true" : "false");
+        }else if(variable == CameraSystemVars::SYNTHETIC_ROBOTS){
+            return variable+": "+std::to_string(camera.synthetic_robots);
+        }else if(variable == CameraSystemVars::SYNTHETIC_MARKER_SIZE){
+            return variable+": "+std::to_string(camera.synthetic_marker_size);
+        }else if(variable == CameraSystemVars::SYNTHETIC_NOISE || variable == CameraSystemVars::SYNTHETIC_BLUR){
+            std::stringstream response;
+            response << variable << ": ";
+            response << (variable == CameraSystemVars::SYNTHETIC_NOISE ? camera.synthetic_noise : camera.synthetic_blur);
+            return response.str();
+        }else if(variable == CameraSystemVars::DETECT_THREADS){
+            return variable+": "+std::to_string(camera.detect_threads);
+        }else if(variable == CameraSystemVars::DETECT_TILE_SIZE){
+            return variable+": "+std::to_string(camera.detect_tile_size);
+        }else if(variable == CameraSystemVars::DETECT_TILE_OVERLAP){
+            return variable+": "+std::to_string(camera.detect_tile_overlap);
+        }else if(variable == CameraSystemVars::DETECT_PYRAMID_LEVELS){
+            return variable+": "+std::to_string(camera.detect_pyramid_levels);
+        }else if(variable == CameraSystemVars::DISPLAY_RATE){
+            std::stringstream response;
+            response << variable << ": " << camera.display_rate;
+            return response.str();
+        }else if(variable == CameraSystemVars::LATENCY_BUDGET){
+            std::stringstream response;
+            response << variable << ": " << camera.latency_budget;
+            return response.str();
+        }else if(variable == CameraSystemVars::TRACKING_FRAMES){
+            return variable+": "+std::to_string(camera.tracking_frames);
+        }else if(variable == CameraSystemVars::DETECTOR_PRESET){
+            return variable+": "+detector_preset_name(camera);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MIN){
+            return variable+": "+std::to_string(camera.detector_threshold_win_min);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MAX){
+            return variable+": "+std::to_string(camera.detector_threshold_win_max);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_STEP){
+            return variable+": "+std::to_string(camera.detector_threshold_win_step);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_CONSTANT){
+            std::stringstream response;
+            response << variable << ": " << camera.detector_threshold_constant;
+            return response.str();
+        }else if(variable == CameraSystemVars::DETECTOR_CORNER_REFINEMENT){
+            return variable+": "+camera.detector_corner_refinement;
+        }else if(variable == CameraSystemVars::DETECTOR_MIN_PERIMETER_RATE){
+            std::stringstream response;
+            response << variable << ": " << camera.detector_min_perimeter_rate;
+            return response.str();
+        }else if(variable == CameraSystemVars::DETECTOR_MAX_PERIMETER_RATE){
+            std::stringstream response;
+            response << variable << ": " << camera.detector_max_perimeter_rate;
             return response.str();
         }
 
@@ -625,18 +1321,87 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
         }
 
         std::string variable = tokens[2];
-        current_state.camera = CameraSystem{};
+        camera = CameraSystem{};
 
         if(variable == CameraSystemVars::SOURCE){
-            current_state.camera.source = "";
+            camera.source = "";
         }else if(variable == CameraSystemVars::CAM_MATRIX){
-            current_state.camera.camera_matrix = cv::Mat::zeros(current_state.camera.camera_matrix.size(), current_state.camera.camera_matrix.type());;
+            camera.camera_matrix = cv::Mat::zeros(camera.camera_matrix.size(), camera.camera_matrix.type());;
         }else if(variable == CameraSystemVars::DIST_MATRIX){
-            current_state.camera.distortion_matrix = cv::Mat::zeros(current_state.camera.distortion_matrix.size(), current_state.camera.distortion_matrix.type());;
+            camera.distortion_matrix = cv::Mat::zeros(camera.distortion_matrix.size(), camera.distortion_matrix.type());;
         }else if(variable == CameraSystemVars::MARKER_DICT){
-            current_state.camera.marker_dictionary = 0;
+            camera.marker_dictionary = 0;
         }else if(variable == CameraSystemVars::OPTIONS){
-            current_state.camera.camera_options.clear();
+            camera.camera_options.clear();
+        }else if(variable == CameraSystemVars::CAPTURE_BUFFER_SIZE){
+            camera.capture_buffer_size = 0;
+        }else if(variable == CameraSystemVars::CAPTURE_POLICY){
+            camera.capture_policy = CameraSystemVars::CAPTURE_POLICY_DROP_OLDEST;
+        }else if(variable == CameraSystemVars::PIXEL_FORMAT){
+            camera.pixel_format = CameraSystemVars::PIXEL_FORMAT_BGR8;
+        }else if(variable == CameraSystemVars::ROI){
+            camera.roi = cv::Rect();
+            camera.auto_roi = false;
+        }else if(variable == CameraSystemVars::ROI_MARGIN){
+            camera.roi_margin = CameraSystem{}.roi_margin;
+        }else if(variable == CameraSystemVars::BINNING){
+            camera.binning = 1;
+        }else if(variable == CameraSystemVars::DECIMATION){
+            camera.decimation = 1;
+        }else if(variable == CameraSystemVars::EXPOSURE_TIME){
+            camera.exposure_time = 0;
+        }else if(variable == CameraSystemVars::GAIN){
+            camera.gain = CameraSystem{}.gain;
+        }else if(variable == CameraSystemVars::FRAME_RATE){
+            camera.frame_rate = 0;
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_MODE){
+            camera.stream_buffer_mode = CameraSystemVars::STREAM_BUFFER_NEWEST_ONLY;
+        }else if(variable == CameraSystemVars::STREAM_BUFFER_COUNT){
+            camera.stream_buffer_count = 0;
+        }else if(variable == CameraSystemVars::REPLAY_MODE){
+            camera.replay_mode = CameraSystemVars::REPLAY_MODE_FAST;
+        }else if(variable == CameraSystemVars::REPLAY_PRELOAD){
+            camera.replay_preload = false;
+        }else if(variable == CameraSystemVars::REPLAY_LOOP){
+            camera.replay_loop = true;
+        }else if(variable == CameraSystemVars::SYNTHETIC_ROBOTS){
+            camera.synthetic_robots = CameraSystem{}.synthetic_robots;
+        }else if(variable == CameraSystemVars::SYNTHETIC_MARKER_SIZE){
+            camera.synthetic_marker_size = CameraSystem{}.synthetic_marker_size;
+        }else if(variable == CameraSystemVars::SYNTHETIC_NOISE){
+            camera.synthetic_noise = 0;
+        }else if(variable == CameraSystemVars::SYNTHETIC_BLUR){
+            camera.synthetic_blur = 0;
+        }else if(variable == CameraSystemVars::DETECT_THREADS){
+            camera.detect_threads = CameraSystem{}.detect_threads;
+        }else if(variable == CameraSystemVars::DETECT_TILE_SIZE){
+            camera.detect_tile_size = 0;
+        }else if(variable == CameraSystemVars::DETECT_TILE_OVERLAP){
+            camera.detect_tile_overlap = CameraSystem{}.detect_tile_overlap;
+        }else if(variable == CameraSystemVars::DETECT_PYRAMID_LEVELS){
+            camera.detect_pyramid_levels = 0;
+        }else if(variable == CameraSystemVars::DISPLAY_RATE){
+            camera.display_rate = CameraSystem{}.display_rate;
+        }else if(variable == CameraSystemVars::LATENCY_BUDGET){
+            camera.latency_budget = 0;
+        }else if(variable == CameraSystemVars::TRACKING_FRAMES){
+            camera.tracking_frames = 0;
+        }else if(variable == CameraSystemVars::DETECTOR_PRESET){
+            apply_detector_preset(CameraSystemVars::DETECTOR_PRESET_BALANCED, camera);
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MIN){
+            camera.detector_threshold_win_min = CameraSystem{}.detector_threshold_win_min;
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_MAX){
+            camera.detector_threshold_win_max = CameraSystem{}.detector_threshold_win_max;
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_WIN_STEP){
+            camera.detector_threshold_win_step = CameraSystem{}.detector_threshold_win_step;
+        }else if(variable == CameraSystemVars::DETECTOR_THRESHOLD_CONSTANT){
+            camera.detector_threshold_constant = CameraSystem{}.detector_threshold_constant;
+        }else if(variable == CameraSystemVars::DETECTOR_CORNER_REFINEMENT){
+            camera.detector_corner_refinement = CameraSystemVars::CORNER_REFINEMENT_NONE;
+        }else if(variable == CameraSystemVars::DETECTOR_MIN_PERIMETER_RATE){
+            camera.detector_min_perimeter_rate = CameraSystem{}.detector_min_perimeter_rate;
+        }else if(variable == CameraSystemVars::DETECTOR_MAX_PERIMETER_RATE){
+            camera.detector_max_perimeter_rate = CameraSystem{}.detector_max_perimeter_rate;
         }else{
            return "variable '"+variable+"' does not exist";
         }
@@ -647,9 +1412,178 @@ std::string command_handler::camera_system(const std::vector<std::string>& token
     }
 }
 
+std::string command_handler::cameras_system(const std::vector<std::string>& tokens, StateVariables& current_state){
+    if(tokens[0] == LIST_CMD){
+        std::stringstream response;
+        response << "Current cameras:";
+
+        //the default camera is only listed once it has been given a type
+        if(!current_state.camera.type.empty()){
+            response << "\n    " << CameraSystemVars::DEFAULT_CAMERA << ": " << current_state.camera.type << " "
+                     << current_state.camera.source << " (connected: " << std::boolalpha
+                     << current_state.camera.connected;
+            auto status = current_state.camera_status.find(CameraSystemVars::DEFAULT_CAMERA);
+            if(status != current_state.camera_status.end()){
+                response << ", load: " << status->second.load_level;
+            }
+            response << ")";
+        }
+        for(auto const& camera : current_state.cameras){
+            response << "\n    " << camera.first << ": " << camera.second.type << " " << camera.second.source
+                     << " (connected: " << std::boolalpha << camera.second.connected;
+            auto status = current_state.camera_status.find(camera.first);
+            if(status != current_state.camera_status.end()){
+                response << ", load: " << status->second.load_level;
+            }
+            response << ")";
+        }
+
+        return response.str();
+    }else if(tokens[0] == GET_CMD){
+        if(tokens.size() != 3){
+            return "please provide a camera to get the status of\n    ex: get cameras left";
+        }
+
+        std::string camera_to_get = tokens[2];
+        if(current_state.find_camera(camera_to_get) == nullptr){
+            return "camera '"+camera_to_get+"' not found";
+        }
+
+        //only cameras with a running pipeline have a status
+        auto status = current_state.camera_status.find(camera_to_get);
+        if(status == current_state.camera_status.end()){
+            return "camera '"+camera_to_get+"' is not running";
+        }
+
+        std::stringstream response;
+        response << camera_to_get << ":";
+        response << "\n    load_level: " << status->second.load_level;
+        response << "\n    latency: " << status->second.latency << "ms";
+        return response.str();
+    }else if(tokens[0] == DELETE_CMD){
+        if(tokens.size() != 3){
+            return "please provide a camera to delete\n    ex: delete cameras left";
+        }
+
+        std::string camera_to_delete = tokens[2];
+        if(camera_to_delete == CameraSystemVars::DEFAULT_CAMERA){
+            current_state.camera = CameraSystem{};
+            return "camera '"+camera_to_delete+"' has been reset";
+        }
+
+        if(current_state.cameras.erase(camera_to_delete) > 0){
+            return "camera '"+camera_to_delete+"' has been removed";
+        }else{
+            return "camera '"+camera_to_delete+"' does not exist";
+        }
+    }else{
+        return "command '"+tokens[0]+"' not valid for target system '"+tokens[1]+"'";
+    }
+}
+
+std::string command_handler::threads_system(const std::vector<std::string>& tokens, ThreadSystem& threads){
+    //the core lists, by variable name
+    const std::vector<std::pair<const char*, std::vector<int>*>> core_lists = {
+            {ThreadSystemVars::CAPTURE_CORES, &threads.capture_cores},
+            {ThreadSystemVars::DETECT_CORES, &threads.detect_cores},
+            {ThreadSystemVars::PUBLISH_CORES, &threads.publish_cores},
+            {ThreadSystemVars::HOUSEKEEPING_CORES, &threads.housekeeping_cores}};
+    auto find_cores = [&core_lists](const std::string& variable) -> std::vector<int>* {
+        for(const auto& core_list : core_lists){
+            if(variable == core_list.first)
+                return core_list.second;
+        }
+        return nullptr;
+    };
+
+    if(tokens[0] == LIST_CMD){
+        std::stringstream response;
+        response << "Current thread variables:";
+
+        for(const auto& core_list : core_lists){
+            response << "\n    " << core_list.first << ": " << build_cores_string(*core_list.second);
+        }
+        response << "\n    " << ThreadSystemVars::CAPTURE_PRIORITY << ": " << threads.capture_priority;
+
+        return response.str();
+    }else if(tokens[0] == SET_CMD){
+        if(tokens.size() < 3){
+            return "please provide a variable to set\n    ex: set threads capture_cores 2,3";
+        }
+
+        std::string variable = tokens[2];
+
+        if(variable == ThreadSystemVars::CAPTURE_PRIORITY){
+            int priority = threads.capture_priority;
+            std::string response = set_int_variable(tokens, 0, priority);
+            if(priority > ThreadSystemVars::MAX_PRIORITY){
+                return "please provide an integer value of at most "+std::to_string(ThreadSystemVars::MAX_PRIORITY);
+            }
+            threads.capture_priority = priority;
+            return response;
+        }
+
+        std::vector<int>* cores = find_cores(variable);
+        if(cores == nullptr){
+            return "variable '"+variable+"' does not exist";
+        }
+
+        if(tokens.size() != 4){
+            return "please provide a comma separated list of cores for variable '"+variable+"'\n    ex: set threads "+variable+" 2,3";
+        }
+
+        std::vector<int> values_as_int;
+        for(const auto& value : tokenize_values_by_commas(tokens[3])){
+            try{
+                values_as_int.push_back(std::stoi(value));
+            }catch(const std::logic_error& err){
+                return "please provide a comma separated list of integers";
+            }
+            if(values_as_int.back() < 0){
+                return "please provide a comma separated list of non-negative integers";
+            }
+        }
+
+        *cores = values_as_int;
+        return "'"+variable+"' variable set with values "+tokens[3];
+    }else if(tokens[0] == GET_CMD){
+        if(tokens.size() < 3){
+            return "please provide a variable to get\n    ex: get threads capture_cores";
+        }
+
+        std::string variable = tokens[2];
+
+        if(variable == ThreadSystemVars::CAPTURE_PRIORITY){
+            return variable+": "+std::to_string(threads.capture_priority);
+        }else if(std::vector<int>* cores = find_cores(variable)){
+            return variable+": "+build_cores_string(*cores);
+        }
+
+        return "variable '"+variable+"' does not exist";
+    }else if(tokens[0] == DELETE_CMD){
+        if(tokens.size() < 3){
+            return "please provide a variable to delete\n    ex: delete threads capture_cores";
+        }
+
+        std::string variable = tokens[2];
+
+        if(variable == ThreadSystemVars::CAPTURE_PRIORITY){
+            threads.capture_priority = 0;
+        }else if(std::vector<int>* cores = find_cores(variable)){
+            cores->clear();
+        }else{
+            return "variable '"+variable+"' does not exist";
+        }
+
+        return "'"+variable+"' variable has been deleted";
+    }else{
+        return "command '"+tokens[0]+"' not valid for target system '"+tokens[1]+"'";
+    }
+}
+
 std::string command_handler::help_command(){
     std::string response = "current target systems:\n";
-    response += "    robot, state, collector, camera\n\n";
+    response += "    robot, state, collector, camera, camera:<name>, cameras, threads\n\n";
 
     response += "for the 'robot' system you can use the commands:\n";
     response += "    get, set, list, delete\n";
@@ -667,8 +1601,34 @@ std::string command_handler::help_command(){
     response += "for the 'camera' system you can use the commands:\n";
     response += "    get, set, list (current camera variables), delete\n";
     response += "you can modify the following variables:\n";
-    response += "    type, connected, source, camera_matrix, distortion_matrix, marker_dictionary, camera_options\n";
-    response += "ex: 'get camera source' or 'list camera' or 'set camera marker_dictionary 6' or 'delete camera source'\n\n";
+    response += "    type, connected, source, camera_matrix, distortion_matrix, marker_dictionary, camera_options,\n";
+    response += "    capture_buffer_size, capture_policy, pixel_format, roi, roi_margin, binning, decimation,\n";
+    response += "    exposure_time, gain (a value in dB or 'auto'), frame_rate, stream_buffer_mode, stream_buffer_count,\n";
+    response += "    replay_mode, replay_preload, replay_loop, synthetic_robots, synthetic_marker_size, synthetic_noise,\n";
+    response += "    synthetic_blur, detect_threads, detect_tile_size, detect_tile_overlap, display_rate,\n";
+    response += "    latency_budget, tracking_frames, detect_pyramid_levels, detector_preset, detector_threshold_win_min,\n";
+    response += "    detector_threshold_win_max, detector_threshold_win_step, detector_threshold_constant,\n";
+    response += "    detector_corner_refinement, detector_min_perimeter_rate, detector_max_perimeter_rate\n";
+    response += "NOTE: detector_preset sets every detector_* variable at once to 'fast', 'balanced' or 'accurate' settings\n";
+    response += "ex: 'get camera source' or 'list camera' or 'set camera marker_dictionary 6' or 'delete camera source'\n";
+    response += "NOTE: 'camera' is the default camera. Additional cameras are set up the same way with 'camera:<name>'\n";
+    response += "ex: 'set camera:left type spinnaker' or 'get camera:left source'\n\n";
+
+    response += "for the 'cameras' system you can use the commands:\n";
+    response += "    list, get (pipeline status), delete\n";
+    response += "ex: 'list cameras' or 'get cameras left' or 'delete cameras left'\n";
+    response += "NOTE: a camera's load_level shows how much work its pipeline is skipping to stay within its latency_budget\n\n";
+
+    response += "for the 'threads' system you can use the commands:\n";
+    response += "    get, set, list, delete\n";
+    response += "you can modify the following variables:\n";
+    response += "    capture_cores, detect_cores, publish_cores, housekeeping_cores, capture_priority\n";
+    response += "ex: 'set threads capture_cores 2,3' or 'set threads capture_priority 50' or 'delete threads detect_cores'\n";
+    response += "NOTE: an empty core list lets the threads run on any core. capture_priority 0 uses normal scheduling\n\n";
+
+    response += "use 'stop' to stop every camera's pipeline while keeping the cameras connected, 'start' to start them again\n";
+    response += "and 'restart' to restart them, i.e. to apply detect_threads\n";
+    response += "use 'shutdown' to stop every camera and exit the program\n\n";
 
     response += "intended usage for each target system/variable will be clarified if used incorrectly.\n\n";
     return response;
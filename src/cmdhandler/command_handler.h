@@ -5,6 +5,10 @@
 #include <fstream>
 #include <stdio.h>
 #include <filesystem>
+#include <array>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
 #include <spdlog/spdlog.h>
 #include "statevariables.h"
 #include "state.pb.h"
@@ -58,6 +62,116 @@ private:
      */
     static std::string build_matrix_string(const cv::Mat& matrix);
 
+    /** @brief Convert the camera's sensor region settings to a string
+     *
+     * @param camera [in] Camera system to get the region settings from
+     * @return "auto", "full", or the region as a comma separated list (i.e. "x,y,width,height")
+     */
+    static std::string build_roi_string(const CameraSystem& camera);
+
+    /** @brief Build a string for a list of cores
+     *
+     * @param cores [in] Cores to build the string for
+     * @return Comma separated list of the cores, or 'any' if the list is empty
+     */
+    static std::string build_cores_string(const std::vector<int>& cores);
+
+    /** @brief Set every detector setting of a camera from a preset
+     *
+     * @param preset [in] One of CameraSystemVars::DETECTOR_PRESETS
+     * @param camera [out] Camera system to set the detector_* variables of
+     */
+    static void apply_detector_preset(const std::string& preset, CameraSystem& camera);
+
+    /** @brief Get the preset that a camera's detector settings match
+     *
+     * @param camera [in] Camera system to check the detector_* variables of
+     * @return One of CameraSystemVars::DETECTOR_PRESETS, or CameraSystemVars::DETECTOR_PRESET_CUSTOM if the settings
+     *         were changed from all of them
+     */
+    static std::string detector_preset_name(const CameraSystem& camera);
+
+    /** @brief Set an integer camera variable
+     *
+     * This handles 'set camera <variable> <value>' for integer variables with a lower bound
+     *
+     * @param tokens [in] Tokenized user command as vector of strings
+     * @param min_value [in] Smallest valid value for the variable
+     * @param variable [out] Variable to set if the given value is valid
+     * @param applied [out] Set to true if the variable was set. Ignored if null
+     * @return std::string containing response to user command
+     */
+    static std::string set_int_variable(const std::vector<std::string>& tokens, int min_value, int& variable,
+                                        bool* applied = nullptr);
+
+    /** @brief Set a double camera variable
+     *
+     * This handles 'set camera <variable> <value>' for double variables with a lower bound
+     *
+     * @param tokens [in] Tokenized user command as vector of strings
+     * @param min_value [in] Smallest valid value for the variable
+     * @param variable [out] Variable to set if the given value is valid
+     * @param applied [out] Set to true if the variable was set. Ignored if null
+     * @return std::string containing response to user command
+     */
+    static std::string set_double_variable(const std::vector<std::string>& tokens, double min_value, double& variable,
+                                           bool* applied = nullptr);
+
+    /** @brief Set a boolean camera variable from a user command
+     *
+     * @param tokens [in] Tokenized user command as vector of strings. The value is the 4th token
+     * @param variable [out] Variable to set if the value is 'true' or 'false'
+     * @param applied [out] Set to true if the variable was set. Ignored if null
+     * @return std::string containing response to user command
+     */
+    static std::string set_bool_variable(const std::vector<std::string>& tokens, bool& variable,
+                                         bool* applied = nullptr);
+
+    /** @brief Set a camera variable that must be one of a fixed set of values
+     *
+     * This handles 'set camera <variable> <value>' for variables that can only hold one of the given options. The value
+     * is made lowercase before being checked against the options
+     *
+     * @param tokens [in] Tokenized user command as vector of strings
+     * @param options [in] Valid values for the variable
+     * @param variable [out] Variable to set if the given value is valid
+     * @param applied [out] Set to true if the variable was set. Ignored if null
+     * @return std::string containing response to user command
+     */
+    template<std::size_t N>
+    static std::string set_option_variable(const std::vector<std::string>& tokens,
+                                           const std::array<const char*, N>& options, std::string& variable,
+                                           bool* applied = nullptr)
+    {
+        std::string value;
+        if(tokens.size() == 4)
+        {
+            // Make the value lowercase
+            value = tokens[3];
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+        }
+
+        if(tokens.size() != 4 || std::find(options.begin(), options.end(), value) == options.end())
+        {
+            std::stringstream ss;
+            ss << "please provide a value for variable '" << tokens[2] << "'. Valid options are: ";
+            for(const char* option : options)
+            {
+                ss << option << ", ";
+            }
+            ss << "\n ex: set camera " << tokens[2] << " " << options[0];
+
+            return ss.str();
+        }
+
+        variable = value;
+        if(applied != nullptr)
+        {
+            *applied = true;
+        }
+        return "camera " + tokens[2] + " set to '" + value + "'";
+    }
+
     /** @brief Modifies the robot state system
      * 
      * This modifies the state system that handles robots. A robot has a name and a collection of 4 marker int ids.
@@ -99,16 +213,60 @@ private:
     
     /** @brief Modifies the camera state system
      * 
-     * This modifies the state system that handles the camera
+     * This modifies the state system that handles a single camera. It is used for both the default camera ('camera')
+     * and named cameras ('camera:<name>')
      * 
      * Applicable commands: set, get, list, delete
      * 
      * @param tokens [in] Tokenized user command as vector of strings
-     * @param current_state [in] Current program state
+     * @param camera [in] Camera system to modify
+     * @param applied [out] Set to true if a set command was valid and applied to the camera. Ignored if null
      * @return std::string containing response to user command
      * @see CameraSystem
      */
-    static std::string camera_system(const std::vector<std::string>& tokens, StateVariables& current_state);
+    static std::string camera_system(const std::vector<std::string>& tokens, CameraSystem& camera,
+                                     bool* applied = nullptr);
+
+    /** @brief Manages the set of cameras
+     *
+     * This lists all configured cameras, shows the status of their pipelines and removes named cameras
+     *
+     * Applicable commands: list, get, delete
+     *
+     * @param tokens [in] Tokenized user command as vector of strings
+     * @param current_state [in] Current program state
+     * @return std::string containing response to user command
+     * @see Variables::cameras
+     */
+    static std::string cameras_system(const std::vector<std::string>& tokens, StateVariables& current_state);
+
+    /** @brief Modifies the thread placement state system
+     *
+     * This modifies which cores the capture, detect, publish and housekeeping threads may run on, and the real-time
+     * priority of the capture threads
+     *
+     * Applicable commands: set, get, list, delete
+     *
+     * @param tokens [in] Tokenized user command as vector of strings
+     * @param threads [in] Thread system to modify
+     * @return std::string containing response to user command
+     * @see ThreadSystem
+     */
+    static std::string threads_system(const std::vector<std::string>& tokens, ThreadSystem& threads);
+
+    /** @brief Copy a camera system into its protobuf message
+     *
+     * @param camera [in] Camera system to save
+     * @param camera_to_save [out] Protobuf message to fill
+     */
+    static void save_camera_system(const CameraSystem& camera, CameraSys& camera_to_save);
+
+    /** @brief Fill a camera system from its protobuf message
+     *
+     * @param loaded_camera [in] Protobuf message to load from
+     * @param camera [out] Camera system to fill
+     */
+    static void load_camera_system(const CameraSys& loaded_camera, CameraSystem& camera);
     
     /** @brief Get help message
      * 
@@ -8,6 +8,10 @@ constexpr char LIST_CMD[] = "list";
 constexpr char SAVE_CMD[] = "save";
 constexpr char LOAD_CMD[] = "load";
 constexpr char HELP_CMD[] = "help";
+constexpr char SHUTDOWN_CMD[] = "shutdown";
+constexpr char START_CMD[] = "start";
+constexpr char STOP_CMD[] = "stop";
+constexpr char RESTART_CMD[] = "restart";
 
 const std::string TARGET_CMDS[] = {SET_CMD, GET_CMD, DELETE_CMD, LIST_CMD, SAVE_CMD, LOAD_CMD};
 
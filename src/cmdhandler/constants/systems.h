@@ -5,5 +5,9 @@ constexpr char ROBOT_SYS_CMD[] = "robot";
 constexpr char STATE_SYS_CMD[] = "state";
 constexpr char COLLECTOR_SYS_CMD[] = "collector";
 constexpr char CAMERA_SYS_CMD[] = "camera";
+constexpr char CAMERAS_SYS_CMD[] = "cameras";
+constexpr char THREADS_SYS_CMD[] = "threads";
+// Separates the camera system from a camera's name, i.e. "camera:left"
+constexpr char CAMERA_NAME_SEPARATOR = ':';
 
 #endif //MELON_SYSTEMS_H
@@ -1,8 +1,13 @@
 #ifndef MELON_VARIABLES_H
 #define MELON_VARIABLES_H
 
+#include <array>
+
 namespace CameraSystemVars
 {
+    // Name of the camera in Variables::camera. Other cameras are named by the user
+    constexpr char DEFAULT_CAMERA[] = "default";
+
     constexpr char TYPE[] = "type";
     constexpr char CONNECTED[] = "connected";
     constexpr char SOURCE[] = "source";
@@ -10,14 +15,112 @@ namespace CameraSystemVars
     constexpr char DIST_MATRIX[] = "distortion_matrix";
     constexpr char MARKER_DICT[] = "marker_dictionary";
     constexpr char OPTIONS[] = "camera_options";
+    constexpr char CAPTURE_BUFFER_SIZE[] = "capture_buffer_size";
+    constexpr char CAPTURE_POLICY[] = "capture_policy";
+    constexpr char PIXEL_FORMAT[] = "pixel_format";
+    constexpr char ROI[] = "roi";
+    constexpr char ROI_MARGIN[] = "roi_margin";
+    constexpr char BINNING[] = "binning";
+    constexpr char DECIMATION[] = "decimation";
+    constexpr char EXPOSURE_TIME[] = "exposure_time";
+    constexpr char GAIN[] = "gain";
+    constexpr char FRAME_RATE[] = "frame_rate";
+    constexpr char STREAM_BUFFER_MODE[] = "stream_buffer_mode";
+    constexpr char STREAM_BUFFER_COUNT[] = "stream_buffer_count";
+    constexpr char REPLAY_MODE[] = "replay_mode";
+    constexpr char REPLAY_PRELOAD[] = "replay_preload";
+    constexpr char REPLAY_LOOP[] = "replay_loop";
+    constexpr char SYNTHETIC_ROBOTS[] = "synthetic_robots";
+    constexpr char SYNTHETIC_MARKER_SIZE[] = "synthetic_marker_size";
+    constexpr char SYNTHETIC_NOISE[] = "synthetic_noise";
+    constexpr char SYNTHETIC_BLUR[] = "synthetic_blur";
+    constexpr char DETECT_THREADS[] = "detect_threads";
+    constexpr char DETECT_TILE_SIZE[] = "detect_tile_size";
+    constexpr char DETECT_TILE_OVERLAP[] = "detect_tile_overlap";
+    constexpr char DETECT_PYRAMID_LEVELS[] = "detect_pyramid_levels";
+    constexpr char DISPLAY_RATE[] = "display_rate";
+    constexpr char LATENCY_BUDGET[] = "latency_budget";
+    constexpr char TRACKING_FRAMES[] = "tracking_frames";
+    constexpr char DETECTOR_PRESET[] = "detector_preset";
+    constexpr char DETECTOR_THRESHOLD_WIN_MIN[] = "detector_threshold_win_min";
+    constexpr char DETECTOR_THRESHOLD_WIN_MAX[] = "detector_threshold_win_max";
+    constexpr char DETECTOR_THRESHOLD_WIN_STEP[] = "detector_threshold_win_step";
+    constexpr char DETECTOR_THRESHOLD_CONSTANT[] = "detector_threshold_constant";
+    constexpr char DETECTOR_CORNER_REFINEMENT[] = "detector_corner_refinement";
+    constexpr char DETECTOR_MIN_PERIMETER_RATE[] = "detector_min_perimeter_rate";
+    constexpr char DETECTOR_MAX_PERIMETER_RATE[] = "detector_max_perimeter_rate";
 
     constexpr char TYPE_OPENCV[] = "opencv";
     constexpr char TYPE_SPINNAKER[] = "spinnaker";
-    const std::array<const char*, 2> TYPES = {const_cast<char*>(TYPE_OPENCV), const_cast<char*>(TYPE_SPINNAKER)};
+    constexpr char TYPE_REPLAY[] = "replay";
+    constexpr char TYPE_SYNTHETIC[] = "synthetic";
+    const std::array<const char*, 4> TYPES = {const_cast<char*>(TYPE_OPENCV), const_cast<char*>(TYPE_SPINNAKER),
+                                              const_cast<char*>(TYPE_REPLAY), const_cast<char*>(TYPE_SYNTHETIC)};
+    constexpr char CAPTURE_POLICY_DROP_OLDEST[] = "drop_oldest";
+    constexpr char CAPTURE_POLICY_BLOCK[] = "block";
+    const std::array<const char*, 2> CAPTURE_POLICIES = {CAPTURE_POLICY_DROP_OLDEST, CAPTURE_POLICY_BLOCK};
+    constexpr char PIXEL_FORMAT_BGR8[] = "bgr8";
+    constexpr char PIXEL_FORMAT_MONO8[] = "mono8";
+    constexpr char PIXEL_FORMAT_BAYER_RG8[] = "bayerrg8";
+    const std::array<const char*, 3> PIXEL_FORMATS = {PIXEL_FORMAT_BGR8, PIXEL_FORMAT_MONO8, PIXEL_FORMAT_BAYER_RG8};
+    constexpr char ROI_AUTO[] = "auto";
+    constexpr char ROI_FULL[] = "full";
+    // Value of the gain variable for automatic gain
+    constexpr char GAIN_AUTO[] = "auto";
+    constexpr char STREAM_BUFFER_NEWEST_ONLY[] = "newest_only";
+    constexpr char STREAM_BUFFER_NEWEST_FIRST[] = "newest_first";
+    constexpr char STREAM_BUFFER_OLDEST_FIRST[] = "oldest_first";
+    constexpr char STREAM_BUFFER_OLDEST_FIRST_OVERWRITE[] = "oldest_first_overwrite";
+    const std::array<const char*, 4> STREAM_BUFFER_MODES = {STREAM_BUFFER_NEWEST_ONLY, STREAM_BUFFER_NEWEST_FIRST,
+                                                           STREAM_BUFFER_OLDEST_FIRST,
+                                                           STREAM_BUFFER_OLDEST_FIRST_OVERWRITE};
+    constexpr char REPLAY_MODE_FAST[] = "fast";
+    constexpr char REPLAY_MODE_FIXED[] = "fixed";
+    constexpr char REPLAY_MODE_RECORDED[] = "recorded";
+    const std::array<const char*, 3> REPLAY_MODES = {REPLAY_MODE_FAST, REPLAY_MODE_FIXED, REPLAY_MODE_RECORDED};
+    // Load shedding levels, from doing all of the work to doing the least. Each level includes the ones before it
+    constexpr char LOAD_LEVEL_NONE[] = "none";
+    constexpr char LOAD_LEVEL_SKIP_FRAMES[] = "skip_frames";
+    constexpr char LOAD_LEVEL_ROI_ONLY[] = "roi_only";
+    constexpr char LOAD_LEVEL_LOW_RESOLUTION[] = "low_resolution";
+    const std::array<const char*, 4> LOAD_LEVELS = {LOAD_LEVEL_NONE, LOAD_LEVEL_SKIP_FRAMES, LOAD_LEVEL_ROI_ONLY,
+                                                    LOAD_LEVEL_LOW_RESOLUTION};
+    // Detector settings presets, from the quickest to the most thorough
+    constexpr char DETECTOR_PRESET_FAST[] = "fast";
+    constexpr char DETECTOR_PRESET_BALANCED[] = "balanced";
+    constexpr char DETECTOR_PRESET_ACCURATE[] = "accurate";
+    const std::array<const char*, 3> DETECTOR_PRESETS = {DETECTOR_PRESET_FAST, DETECTOR_PRESET_BALANCED,
+                                                         DETECTOR_PRESET_ACCURATE};
+    // Shown as the preset when the detector settings don't match any preset
+    constexpr char DETECTOR_PRESET_CUSTOM[] = "custom";
+    constexpr char CORNER_REFINEMENT_NONE[] = "none";
+    constexpr char CORNER_REFINEMENT_SUBPIX[] = "subpix";
+    constexpr char CORNER_REFINEMENT_CONTOUR[] = "contour";
+    const std::array<const char*, 3> CORNER_REFINEMENTS = {CORNER_REFINEMENT_NONE, CORNER_REFINEMENT_SUBPIX,
+                                                           CORNER_REFINEMENT_CONTOUR};
+    // Smallest window size ArUco thresholds frames with
+    constexpr int MIN_THRESHOLD_WINDOW = 3;
+    // Highest predefined ArUco dictionary, cv::aruco::DICT_APRILTAG_36h11
+    constexpr int MAX_MARKER_DICT = 20;
+    // Most times a frame can be halved for coarse-to-fine detection. Markers get too small to be found beyond this
+    constexpr int MAX_PYRAMID_LEVELS = 3;
     constexpr int CAMERA_MATRIX_ROWS = 3;
     constexpr int DISTORTION_MATRIX_ROWS = 5;
 }
 
+namespace ThreadSystemVars
+{
+    constexpr char CAPTURE_CORES[] = "capture_cores";
+    constexpr char DETECT_CORES[] = "detect_cores";
+    constexpr char PUBLISH_CORES[] = "publish_cores";
+    constexpr char HOUSEKEEPING_CORES[] = "housekeeping_cores";
+    constexpr char CAPTURE_PRIORITY[] = "capture_priority";
+    // Shown for an empty core list
+    constexpr char CORES_ANY[] = "any";
+    // Highest SCHED_FIFO priority on Linux
+    constexpr int MAX_PRIORITY = 99;
+}
+
 namespace StateSystemVars
 {
     constexpr char SAVE_DIR[] = "states/";
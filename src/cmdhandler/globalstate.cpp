@@ -1,31 +1,121 @@
 #include "globalstate.h"
 #include <iostream>
 
-GlobalState::GlobalState()
+/** @brief Find out which subsystems differ between two states
+ *
+ * @param a [in] First state
+ * @param b [in] Second state
+ * @return StateSubsystem flags of the subsystems that differ
+ */
+static unsigned changed_subsystems(const StateVariables& a, const StateVariables& b)
 {
-    m_state.version.store(0);
+    unsigned changes = 0;
+    if(a.robot != b.robot)
+        changes |= StateSubsystem::ROBOT;
+    if(a.collector != b.collector)
+        changes |= StateSubsystem::COLLECTOR;
+    if(a.camera != b.camera || a.cameras != b.cameras)
+        changes |= StateSubsystem::CAMERAS;
+    if(a.shutdown != b.shutdown)
+        changes |= StateSubsystem::SHUTDOWN;
+    if(a.threads != b.threads)
+        changes |= StateSubsystem::THREADS;
+    if(a.camera_status != b.camera_status)
+        changes |= StateSubsystem::STATUS;
+    if(a.pipeline != b.pipeline)
+        changes |= StateSubsystem::PIPELINE;
+    return changes;
 }
 
-void GlobalState::receive(const StateVariables& state)
+GlobalState::GlobalState() : m_snapshot(std::make_shared<const Snapshot>())
+{
+}
+
+std::shared_ptr<const GlobalState::Snapshot> GlobalState::load() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+void GlobalState::publish(const StateVariables& state)
 {
+    // Only writers replace the snapshot, so it can be compared and copied without holding up any readers
+    const std::shared_ptr<const Snapshot> current = load();
+    const unsigned changes = changed_subsystems(current->state, state);
+    if(changes == 0)
+        return;
+
+    auto next = std::make_shared<Snapshot>();
+    next->state = state;
+    const unsigned version = current->state.version.load() + 1;
+    next->state.version.store(version);
+    next->changed_in = current->changed_in;
+    for(std::size_t i = 0; i < SUBSYSTEM_COUNT; ++i)
     {
-        // This lock is within a separate scope than the notify_all function call to ensure that the mutex is
-        // unlocked before notify_all is called
-        std::scoped_lock<std::mutex> lock(m_mutex);
+        if(changes & (1u << i))
+            next->changed_in[i] = version;
+    }
 
-        m_state = state;
-        m_state.version.store(m_state.version.load()+1);
+    {
+        // Waiting readers check the snapshot while holding this lock, so swapping under it means none miss a wakeup
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::move(next)));
+        m_version.store(version, std::memory_order_release);
     }
 
     m_cond_var.notify_all();
 }
 
+void GlobalState::receive(const StateVariables& state)
+{
+    std::scoped_lock<std::mutex> lock(m_write_mutex);
+    // Statuses are only ever changed by the pipelines, the incoming state's are from whenever it was copied
+    StateVariables next = state;
+    next.camera_status = load()->state.camera_status;
+    publish(next);
+}
+
+void GlobalState::report_status(const std::string& camera, const CameraStatus& status)
+{
+    std::scoped_lock<std::mutex> lock(m_write_mutex);
+    const std::shared_ptr<const Snapshot> current = load();
+    auto it = current->state.camera_status.find(camera);
+    if(it != current->state.camera_status.end() && it->second == status)
+        return;
+
+    StateVariables state = current->state;
+    state.camera_status[camera] = status;
+    publish(state);
+}
+
+void GlobalState::clear_status(const std::string& camera)
+{
+    std::scoped_lock<std::mutex> lock(m_write_mutex);
+    const std::shared_ptr<const Snapshot> current = load();
+    if(current->state.camera_status.find(camera) == current->state.camera_status.end())
+        return;
+
+    StateVariables state = current->state;
+    state.camera_status.erase(camera);
+    publish(state);
+}
+
+void GlobalState::request_shutdown()
+{
+    std::scoped_lock<std::mutex> lock(m_write_mutex);
+    StateVariables state = load()->state;
+    state.shutdown = true;
+    publish(state);
+}
+
 bool GlobalState::apply(StateVariables& state)
 {
-    if(m_state.version > state.version)
+    if(m_version.load(std::memory_order_acquire) == state.version)
+        return false;
+
+    const std::shared_ptr<const Snapshot> current = load();
+    if(current->state.version > state.version)
     {
-        std::scoped_lock<std::mutex> lock(m_mutex);
-        state = m_state;
+        state = current->state;
         return true;
     }
     return false;
@@ -33,12 +123,54 @@ bool GlobalState::apply(StateVariables& state)
 
 StateVariables GlobalState::get_state()
 {
-    std::scoped_lock<std::mutex> lock(m_mutex);
-    return m_state;
+    return load()->state;
+}
+
+std::shared_ptr<const StateVariables> GlobalState::snapshot() const
+{
+    std::shared_ptr<const Snapshot> current = load();
+    // Share ownership with the whole snapshot while only exposing its state
+    return std::shared_ptr<const StateVariables>(current, &current->state);
+}
+
+unsigned GlobalState::version() const
+{
+    return m_version.load(std::memory_order_acquire);
+}
+
+bool GlobalState::update(std::shared_ptr<const StateVariables>& state, unsigned subsystems) const
+{
+    // Nothing changed, which is the common case, so don't touch the snapshot itself
+    if(state && state->version == m_version.load(std::memory_order_acquire))
+        return false;
+
+    std::shared_ptr<const Snapshot> current = load();
+    bool changed = !state;
+    for(std::size_t i = 0; i < SUBSYSTEM_COUNT && !changed; ++i)
+        changed = (subsystems & (1u << i)) && current->changed_in[i] > state->version;
+
+    state = std::shared_ptr<const StateVariables>(current, &current->state);
+    return changed;
+}
+
+bool GlobalState::wait_update(std::shared_ptr<const StateVariables>& state, unsigned subsystems,
+                              std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while(!update(state, subsystems))
+    {
+        // Wait for the next snapshot. The snapshot is only replaced while holding the lock, so one can't be missed
+        // between checking the version and waiting
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const unsigned version = state->version;
+        if(!m_cond_var.wait_until(lock, deadline, [&]{ return m_version.load() != version; }))
+            return false;
+    }
+    return true;
 }
 
 void GlobalState::wait(const std::function<bool(const StateVariables&)>& func)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
-    m_cond_var.wait(lock, [=]() { return func(m_state); });
+    m_cond_var.wait(lock, [&]() { return func(load()->state); });
 }
\ No newline at end of file
@@ -2,15 +2,46 @@
 #define MELON_GLOBALSTATE_H
 
 #include "statevariables.h"
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 
+/** @brief Parts of the program state that can be subscribed to for changes
+ *
+ * These are bit flags, so several subsystems can be combined with |
+ *
+ * @see GlobalState::update()
+ */
+namespace StateSubsystem
+{
+    constexpr unsigned ROBOT = 1u << 0;
+    constexpr unsigned COLLECTOR = 1u << 1;
+    // The default camera and all named cameras
+    constexpr unsigned CAMERAS = 1u << 2;
+    constexpr unsigned SHUTDOWN = 1u << 3;
+    constexpr unsigned THREADS = 1u << 4;
+    // Status reported by the camera pipelines, see GlobalState::report_status()
+    constexpr unsigned STATUS = 1u << 5;
+    // Whether the camera pipelines run, see the start, stop and restart commands
+    constexpr unsigned PIPELINE = 1u << 6;
+    constexpr unsigned ALL = ROBOT | COLLECTOR | CAMERAS | SHUTDOWN | THREADS | STATUS | PIPELINE;
+}
+
 /** @brief Global state manager for program
  *
  * This wraps a StateVariables instance so that it is thread-safe and can be used to update thread-local
- * StateVariables instances
+ * StateVariables instances. <br>
+ * The state is kept as an immutable snapshot. Every change publishes a new snapshot (copy-on-write), so readers only
+ * need to load a pointer to the current one instead of copying the whole state under a lock. Each snapshot records
+ * which subsystems changed in which version, so readers can ignore changes they don't care about, see
+ * GlobalState::update(). <br>
+ * A generation counter mirrors the current snapshot's version, so a reader can find out that nothing changed with a
+ * single atomic load. Writers build the next snapshot before taking the lock that readers wait on, so a slow command
+ * never holds up a reader for longer than a pointer swap
  *
  * @see StateVariables
  */
@@ -24,14 +55,37 @@ public:
 
     /** @brief Update the global state
      *
-     * This replaces the current internal global state with the given StateVariables
+     * This replaces the current internal global state with the given StateVariables. If nothing in it differs from
+     * the current state, no new snapshot is published and the version doesn't change
      *
-     * @note The version of the incoming state is ignored
+     * @note The version and camera statuses of the incoming state are ignored, so that a command can't undo a status
+     *       reported while it was running
      *
      * @param state [in] The new program state
      */
     void receive(const StateVariables& state);
 
+    /** @brief Ask every thread to finish up and the program to exit
+     *
+     * This sets StateVariables::shutdown in the global state, the same as the shutdown command
+     */
+    void request_shutdown();
+
+    /** @brief Set the status of a camera's pipeline
+     *
+     * A new snapshot is only published if the status differs from the current one
+     *
+     * @param camera [in] Name of the camera
+     * @param status [in] The camera's status
+     */
+    void report_status(const std::string& camera, const CameraStatus& status);
+
+    /** @brief Remove the status of a camera whose pipeline stopped
+     *
+     * @param camera [in] Name of the camera
+     */
+    void clear_status(const std::string& camera);
+
     /** @brief Apply the global state to a thread-local state if necessary
      *
      * This applies the global state to the given thread-local state if the global state has a newer version number
@@ -47,6 +101,42 @@ public:
      */
     StateVariables get_state();
 
+    /** @brief Get the current snapshot of the global state
+     *
+     * This doesn't copy the state or take the state's lock. The snapshot never changes, so it can be read from any
+     * thread for as long as it's held
+     *
+     * @return The current snapshot
+     */
+    std::shared_ptr<const StateVariables> snapshot() const;
+
+    /** @brief Get the version of the current snapshot
+     *
+     * This is a single atomic load, so it's cheap enough to call as often as needed to check for changes
+     *
+     * @return Version of the current snapshot, see StateVariables::version
+     */
+    unsigned version() const;
+
+    /** @brief Move a snapshot to the current one, and check if any of the given subsystems changed on the way
+     *
+     * @param state [in, out] Snapshot to update. Null is replaced with the current snapshot
+     * @param subsystems [in] StateSubsystem flags of the subsystems to check
+     * @return True if any of the subsystems changed since the given snapshot (or it was null), false otherwise. The
+     *         snapshot is moved to the current one either way
+     */
+    bool update(std::shared_ptr<const StateVariables>& state, unsigned subsystems) const;
+
+    /** @brief Wait until any of the given subsystems change
+     *
+     * @param state [in, out] Snapshot to update, see GlobalState::update()
+     * @param subsystems [in] StateSubsystem flags of the subsystems to wait for
+     * @param timeout [in] Maximum amount of time to wait
+     * @return True if any of the subsystems changed, false if the timeout was reached
+     */
+    bool wait_update(std::shared_ptr<const StateVariables>& state, unsigned subsystems,
+                     std::chrono::milliseconds timeout);
+
     /** @brief Wait until given callback function returns true
      *
      * This blocks the thread that this function is called within until the callback function returns true.
@@ -63,7 +153,41 @@ public:
      */
     void wait(const std::function<bool(const StateVariables&)>& func);
 private:
-    StateVariables m_state;
+    // Amount of StateSubsystem flags
+    static constexpr std::size_t SUBSYSTEM_COUNT = 7;
+
+    /** @brief A published version of the state
+     *
+     */
+    struct Snapshot
+    {
+        StateVariables state;
+        // Version each subsystem last changed in, indexed by the bit of its StateSubsystem flag
+        std::array<unsigned, SUBSYSTEM_COUNT> changed_in {};
+    };
+
+    /** @brief Publish a new snapshot if the state differs from the current one
+     *
+     * @note m_write_mutex must be held
+     *
+     * @param state [in] The new program state
+     */
+    void publish(const StateVariables& state);
+
+    /** @brief Get the current snapshot
+     *
+     * @return The current snapshot
+     */
+    std::shared_ptr<const Snapshot> load() const;
+
+    // Current snapshot. Only accessed through std::atomic_load/std::atomic_store, and only replaced while holding
+    // both mutexes
+    std::shared_ptr<const Snapshot> m_snapshot;
+    // Version of m_snapshot, stored after the snapshot itself
+    std::atomic<unsigned> m_version {0};
+    // Serializes writers while they build the next snapshot
+    std::mutex m_write_mutex;
+    // Held only to swap in the next snapshot, and by readers waiting for one
     std::mutex m_mutex;
     std::condition_variable m_cond_var;
 };
@@ -2,12 +2,14 @@
 #define MELON_STATEVARIABLES_H
 
 #include <unordered_map>
+#include <map>
 #include <opencv2/core/mat.hpp>
 #include <vector>
 #include <string>
 #include <atomic>
 #include <asio.hpp>
 #include <asio/ip/udp.hpp>
+#include "constants/variables.h"
 
 /** @brief Robot system state
  *
@@ -15,6 +17,9 @@
 struct RobotSystem
 {
     std::unordered_map<std::string, std::vector<int>> robots;
+
+    bool operator==(const RobotSystem& other) const { return robots == other.robots; }
+    bool operator!=(const RobotSystem& other) const { return !(*this == other); }
 };
 
 /** @brief Collector system state
@@ -23,6 +28,9 @@ struct RobotSystem
 struct CollectorSystem
 {
     std::unordered_map<std::string, asio::ip::udp::endpoint> collectors;
+
+    bool operator==(const CollectorSystem& other) const { return collectors == other.collectors; }
+    bool operator!=(const CollectorSystem& other) const { return !(*this == other); }
 };
 
 /** @brief camera system state
@@ -37,6 +45,170 @@ struct CameraSystem
     cv::Mat distortion_matrix;
     int marker_dictionary = 0;
     std::unordered_map<std::string, bool> camera_options;
+    // Size of the asynchronous capture thread's frame ring. 0 reads frames synchronously without a capture thread
+    int capture_buffer_size = 0;
+    // What the capture thread does when its frame ring is full. One of CameraSystemVars::CAPTURE_POLICIES
+    std::string capture_policy = CameraSystemVars::CAPTURE_POLICY_DROP_OLDEST;
+    // Pixel format the camera delivers frames in. One of CameraSystemVars::PIXEL_FORMATS
+    std::string pixel_format = CameraSystemVars::PIXEL_FORMAT_BGR8;
+    // Sensor region to read out, in pixels after binning/decimation. An empty rect reads out the full sensor
+    cv::Rect roi;
+    // Shrink the sensor region to the detected arena (within roi, if it's set)
+    bool auto_roi = false;
+    // Pixels added around the detected arena when auto_roi is enabled
+    int roi_margin = 50;
+    int binning = 1;
+    int decimation = 1;
+    // Exposure time in microseconds. 0 uses automatic exposure
+    double exposure_time = 0;
+    // Gain in dB. Negative uses automatic gain, see CameraSystemVars::GAIN_AUTO
+    double gain = -1;
+    // Acquisition frame rate limit in frames per second. 0 acquires as fast as possible
+    double frame_rate = 0;
+    // How the camera's driver hands out buffered frames. One of CameraSystemVars::STREAM_BUFFER_MODES
+    std::string stream_buffer_mode = CameraSystemVars::STREAM_BUFFER_NEWEST_ONLY;
+    // Amount of buffers the camera's driver uses. 0 lets the driver decide
+    int stream_buffer_count = 0;
+    // How fast recorded footage is replayed. One of CameraSystemVars::REPLAY_MODES. The fixed mode uses frame_rate
+    std::string replay_mode = CameraSystemVars::REPLAY_MODE_FAST;
+    // Decode all recorded frames into memory when connecting instead of decoding them while replaying
+    bool replay_preload = false;
+    // Start over once the end of the recorded footage is reached
+    bool replay_loop = true;
+    // Amount of moving robot markers rendered by a synthetic camera
+    int synthetic_robots = 10;
+    // Side length of the rendered robot markers, in pixels of the arena image
+    int synthetic_marker_size = 40;
+    // Standard deviation of the noise added to rendered frames, in gray levels
+    double synthetic_noise = 0;
+    // Standard deviation of the gaussian blur applied to rendered frames, in pixels. 0 doesn't blur
+    double synthetic_blur = 0;
+    // Amount of threads detecting markers in the camera's frames. Only applied when the camera's pipeline is started
+    int detect_threads = 2;
+    // Side length of the tiles that frames are split into for detection, in pixels. 0 detects on the whole frame
+    int detect_tile_size = 0;
+    // Amount of pixels detection tiles overlap by. Markers larger than this may be missed when tiling
+    int detect_tile_overlap = 100;
+    // Amount of times frames are halved in size to find marker candidates on, before only the windows around the
+    // candidates are searched at full resolution. 0 searches frames at full resolution only
+    int detect_pyramid_levels = 0;
+    // Display frames drawn per second. 0 never draws or shows the camera's video (headless)
+    double display_rate = 15;
+    // Longest a frame should take from capture to publishing, in milliseconds. The pipeline sheds load when it falls
+    // behind this. 0 never sheds load
+    double latency_budget = 0;
+    // Frames searched only around where the known markers are predicted to be, between two searches of the whole
+    // frame. 0 searches every frame as a whole
+    int tracking_frames = 0;
+    // Smallest and largest window sizes frames are thresholded with to find marker candidates, in pixels, and the step
+    // between the window sizes. Each window size is another pass over the frame, but finds markers of other sizes and
+    // under other lighting
+    int detector_threshold_win_min = 3;
+    int detector_threshold_win_max = 23;
+    int detector_threshold_win_step = 10;
+    // Gray levels a pixel has to be darker than the mean of the window around it to count as part of a marker
+    double detector_threshold_constant = 7;
+    // How marker corners are refined after the markers are decoded. One of CameraSystemVars::CORNER_REFINEMENTS
+    std::string detector_corner_refinement = CameraSystemVars::CORNER_REFINEMENT_NONE;
+    // Smallest and largest marker perimeters looked for, as a fraction of the frame's largest side
+    double detector_min_perimeter_rate = 0.03;
+    double detector_max_perimeter_rate = 4.0;
+
+    /** @brief Compare every variable of two camera systems
+     *
+     * The matrices are compared by identity rather than value, since commands only ever replace them as a whole
+     *
+     * @note New variables must be added here, otherwise changing them isn't passed on to the cameras
+     */
+    bool operator==(const CameraSystem& other) const
+    {
+        return type == other.type && connected == other.connected && source == other.source &&
+               camera_matrix.data == other.camera_matrix.data &&
+               distortion_matrix.data == other.distortion_matrix.data &&
+               marker_dictionary == other.marker_dictionary && camera_options == other.camera_options &&
+               capture_buffer_size == other.capture_buffer_size && capture_policy == other.capture_policy &&
+               pixel_format == other.pixel_format && roi == other.roi && auto_roi == other.auto_roi &&
+               roi_margin == other.roi_margin && binning == other.binning && decimation == other.decimation &&
+               exposure_time == other.exposure_time && gain == other.gain && frame_rate == other.frame_rate &&
+               stream_buffer_mode == other.stream_buffer_mode && stream_buffer_count == other.stream_buffer_count &&
+               replay_mode == other.replay_mode && replay_preload == other.replay_preload &&
+               replay_loop == other.replay_loop && synthetic_robots == other.synthetic_robots &&
+               synthetic_marker_size == other.synthetic_marker_size && synthetic_noise == other.synthetic_noise &&
+               synthetic_blur == other.synthetic_blur && detect_threads == other.detect_threads &&
+               detect_tile_size == other.detect_tile_size && detect_tile_overlap == other.detect_tile_overlap &&
+               detect_pyramid_levels == other.detect_pyramid_levels &&
+               display_rate == other.display_rate && latency_budget == other.latency_budget &&
+               tracking_frames == other.tracking_frames &&
+               detector_threshold_win_min == other.detector_threshold_win_min &&
+               detector_threshold_win_max == other.detector_threshold_win_max &&
+               detector_threshold_win_step == other.detector_threshold_win_step &&
+               detector_threshold_constant == other.detector_threshold_constant &&
+               detector_corner_refinement == other.detector_corner_refinement &&
+               detector_min_perimeter_rate == other.detector_min_perimeter_rate &&
+               detector_max_perimeter_rate == other.detector_max_perimeter_rate;
+    }
+    bool operator!=(const CameraSystem& other) const { return !(*this == other); }
+};
+
+/** @brief Status of a camera's pipeline
+ *
+ * This is reported by the pipeline rather than set by commands, see GlobalState::report_status()
+ */
+struct CameraStatus
+{
+    // Active load shedding level. One of CameraSystemVars::LOAD_LEVELS
+    std::string load_level = CameraSystemVars::LOAD_LEVEL_NONE;
+    // Mean time from capture to publishing of recent frames, in milliseconds
+    double latency = 0;
+
+    bool operator==(const CameraStatus& other) const
+    {
+        return load_level == other.load_level && latency == other.latency;
+    }
+    bool operator!=(const CameraStatus& other) const { return !(*this == other); }
+};
+
+/** @brief Thread placement state
+ *
+ * @see ThreadPlacement
+ */
+struct ThreadSystem
+{
+    // Cores that each kind of thread may run on. Empty lets the threads run on any core
+    std::vector<int> capture_cores;
+    std::vector<int> detect_cores;
+    std::vector<int> publish_cores;
+    // Command handling, camera management, display and log flushing
+    std::vector<int> housekeeping_cores;
+    // SCHED_FIFO priority of the capture threads, up to ThreadSystemVars::MAX_PRIORITY. 0 uses normal scheduling
+    int capture_priority = 0;
+
+    bool operator==(const ThreadSystem& other) const
+    {
+        return capture_cores == other.capture_cores && detect_cores == other.detect_cores &&
+               publish_cores == other.publish_cores && housekeeping_cores == other.housekeeping_cores &&
+               capture_priority == other.capture_priority;
+    }
+    bool operator!=(const ThreadSystem& other) const { return !(*this == other); }
+};
+
+/** @brief Lifecycle of the camera pipelines
+ *
+ * This isn't saved with the state, it's only changed by the start, stop and restart commands
+ */
+struct PipelineSystem
+{
+    // Should the cameras' pipelines be running. Stopped pipelines keep their cameras connected, so that starting them
+    // again is quick
+    bool running = true;
+    // Counted up by the restart command. Every pipeline is restarted whenever this changes
+    unsigned restarts = 0;
+
+    bool operator==(const PipelineSystem& other) const
+    {
+        return running == other.running && restarts == other.restarts;
+    }
+    bool operator!=(const PipelineSystem& other) const { return !(*this == other); }
 };
 
 /** @brief Container class for state variables
@@ -52,7 +224,46 @@ class Variables
 public:
     RobotSystem robot;
     CollectorSystem collector;
+    // The default camera, named CameraSystemVars::DEFAULT_CAMERA
     CameraSystem camera;
+    // Additional cameras, by name
+    std::map<std::string, CameraSystem> cameras;
+    ThreadSystem threads;
+    PipelineSystem pipeline;
+    // Status of each running camera pipeline, by camera name. Not saved with the state
+    std::map<std::string, CameraStatus> camera_status;
+    // Set by the shutdown command or a signal. Every thread finishes up once it sees this and the program exits
+    bool shutdown = false;
+
+    /** @brief Find a camera by name
+     *
+     * @param name [in] Name of the camera, CameraSystemVars::DEFAULT_CAMERA for the default camera
+     * @return Pointer to the camera system, or nullptr if there is no camera with the given name
+     */
+    const CameraSystem* find_camera(const std::string& name) const
+    {
+        if(name == CameraSystemVars::DEFAULT_CAMERA)
+            return &camera;
+        auto it = cameras.find(name);
+        return it != cameras.end() ? &it->second : nullptr;
+    }
+
+    /** @brief Get the names of all cameras that have been given a type
+     *
+     * @return Camera names, including CameraSystemVars::DEFAULT_CAMERA if the default camera has a type
+     */
+    std::vector<std::string> camera_names() const
+    {
+        std::vector<std::string> names;
+        if(!camera.type.empty())
+            names.emplace_back(CameraSystemVars::DEFAULT_CAMERA);
+        for(const auto& pair : cameras)
+        {
+            if(!pair.second.type.empty())
+                names.push_back(pair.first);
+        }
+        return names;
+    }
 protected:
     Variables() = default;
 };
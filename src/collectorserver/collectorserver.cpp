@@ -1,49 +1,194 @@
 #include "collectorserver.h"
+#include "../pipeline/threadplacement.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <sstream>
 
-CollectorServer::CollectorServer(const StateVariables& state) : m_socket(m_service), m_message_count(0)
+// Most messages waiting to be sent. Once there are more, the oldest are dropped
+constexpr std::size_t MAX_QUEUED_MESSAGES = 8;
+
+CollectorServer::CollectorServer(const StateVariables& state) :
+        m_work(asio::make_work_guard(m_io_context)),
+        m_socket(m_io_context),
+        m_message_count(0)
 {
     m_socket.open(asio::ip::udp::v4());
+    // Handlers run in the order they were posted, so the collectors are set before any message is sent
     update_state(state);
+    m_thread = std::thread(&CollectorServer::thread_func, this);
 }
 
 CollectorServer::~CollectorServer()
 {
-    if(m_socket.is_open())
-        m_socket.close();
+    // Cancel whatever is still being sent, then let the thread run out of work
+    asio::post(m_io_context, [this](){
+        m_queue.clear();
+        asio::error_code error;
+        m_socket.close(error);
+    });
+    m_work.reset();
+    m_thread.join();
 }
 
 void CollectorServer::send(const std::string& data)
+{
+    send_message("\"" + data + "\"");
+}
+
+void CollectorServer::send(const std::vector<Detections>& detections)
+{
+    // Capture times are on the steady clock, which means nothing to collectors. Convert them to the system clock (in
+    // nanoseconds since the Unix epoch) using how long ago each frame was captured
+    const auto steady_now = std::chrono::steady_clock::now();
+    const auto system_now = std::chrono::system_clock::now();
+
+    // Assemble the data as a list of cameras, each with the markers that it detected
+    std::stringstream ss;
+    ss << "[";
+    for(std::size_t i = 0; i < detections.size(); ++i)
+    {
+        const Detections& camera = detections[i];
+        const auto age = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_now - camera.timestamp);
+        const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                (system_now - age).time_since_epoch()).count();
+        ss << (i > 0 ? ", " : "") << "{\"camera\": \"" << camera.camera << "\", \"timestamp\": " << timestamp
+           << ", \"device_timestamp\": " << camera.device_timestamp
+           << ", \"age_us\": " << std::chrono::duration_cast<std::chrono::microseconds>(age).count()
+           << ", \"markers\": [";
+        for(std::size_t j = 0; j < camera.markers.size(); ++j)
+        {
+            const Marker& marker = camera.markers[j];
+            ss << (j > 0 ? ", " : "") << "{\"id\": " << marker.id << ", \"corners\": [";
+            for(std::size_t k = 0; k < marker.corners.size(); ++k)
+                ss << (k > 0 ? ", " : "") << "[" << marker.corners[k].x << ", " << marker.corners[k].y << "]";
+            ss << "]}";
+        }
+        ss << "]}";
+    }
+    ss << "]";
+
+    send_message(ss.str());
+}
+
+void CollectorServer::send_message(const std::string& data)
 {
     // Assemble the message
     std::stringstream ss;
-    ss << "{\"num\": \"" << m_message_count++ << "\", \"data\": \"" << data << "\"}";
-    std::string message = ss.str();
-    spdlog::info("Sending message to endpoints. Message: {}", message);
+    ss << "{\"num\": \"" << m_message_count++ << "\", \"data\": " << data << "}";
+    auto message = std::make_shared<const std::string>(ss.str());
 
-    // Send the message to each collector
-    for(auto& endpoint : m_endpoints)
+    asio::post(m_io_context, [this, message](){ queue_message(message); });
+}
+
+void CollectorServer::queue_message(std::shared_ptr<const std::string> message)
+{
+    if(m_queue.size() >= MAX_QUEUED_MESSAGES)
     {
-        std::stringstream ss;
-        ss << "Sending message to " << endpoint;
-        spdlog::info(ss.str());
-        asio::error_code error;
-        m_socket.send_to(asio::buffer(message), endpoint, 0, error);
-        if(error)
-            spdlog::error("Error sending message to '{}':\n{}", endpoint.address().to_string(), error.message());
+        // The front message may be partway through being sent, so drop the one after it
+        m_queue.erase(m_queue.begin() + (m_sending ? 1 : 0));
+        if(m_dropped_messages++ % 100 == 0)
+            spdlog::warn("Collectors can't keep up, dropped {} messages so far", m_dropped_messages);
     }
+    m_queue.push_back(std::move(message));
 
-    spdlog::info("Message sent to all endpoints");
+    if(!m_sending)
+    {
+        m_sending = true;
+        send_next(0);
+    }
+}
+
+void CollectorServer::send_next(std::size_t collector)
+{
+    // Move on to the next message once this one has been sent to every collector. The collectors may have changed in
+    // the meantime, in which case the rest of them get the message
+    if(collector >= m_collectors.size())
+    {
+        if(!m_queue.empty())
+            m_queue.pop_front();
+        if(m_queue.empty() || !m_socket.is_open())
+        {
+            m_sending = false;
+            return;
+        }
+        collector = 0;
+        if(m_collectors.empty())
+        {
+            m_queue.clear();
+            m_sending = false;
+            return;
+        }
+    }
+
+    // The handler keeps the message alive until it has been sent
+    std::shared_ptr<const std::string> message = m_queue.front();
+    m_socket.async_send_to(asio::buffer(*message), m_collectors[collector].endpoint,
+                           [this, message, collector](const asio::error_code& error, std::size_t){
+        if(error == asio::error::operation_aborted)
+        {
+            m_sending = false;
+            return;
+        }
+
+        // The collectors may have been replaced while sending
+        if(collector < m_collectors.size())
+        {
+            Collector& target = m_collectors[collector];
+            if(error && !target.failing)
+            {
+                spdlog::error("Error sending message to '{}':\n{}", target.endpoint.address().to_string(),
+                              error.message());
+            }
+            else if(!error && target.failing)
+            {
+                spdlog::info("Sending messages to '{}' again", target.endpoint.address().to_string());
+            }
+            target.failing = static_cast<bool>(error);
+        }
+        send_next(collector + 1);
+    });
+}
+
+void CollectorServer::thread_func()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::PUBLISH);
+    try
+    {
+        m_io_context.run();
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in collector server thread: \n{}", e.what());
+    }
 }
 
 void CollectorServer::update_state(const StateVariables& state)
 {
-    // Reset and refill the collectors
-    m_endpoints.clear();
-    m_endpoints.reserve(state.collector.collectors.size());
+    // Reset and refill the collectors on the server's thread, since that's where they're used
+    std::vector<Collector> collectors;
+    collectors.reserve(state.collector.collectors.size());
     for(auto& pair: state.collector.collectors)
     {
-        m_endpoints.push_back(pair.second);
+        collectors.push_back({pair.second});
     }
-}
\ No newline at end of file
+
+    asio::post(m_io_context, [this, collectors = std::move(collectors)]() mutable {
+        // Log collectors as they're added and removed rather than for every message, which would be many times a second
+        auto contains = [](const std::vector<Collector>& list, const asio::ip::udp::endpoint& endpoint){
+            return std::any_of(list.begin(), list.end(), [&](const Collector& c){ return c.endpoint == endpoint; });
+        };
+        for(const Collector& collector : collectors)
+        {
+            if(!contains(m_collectors, collector.endpoint))
+                spdlog::debug("Sending messages to {}:{}", collector.endpoint.address().to_string(),
+                              collector.endpoint.port());
+        }
+        for(const Collector& collector : m_collectors)
+        {
+            if(!contains(collectors, collector.endpoint))
+                spdlog::debug("Stopped sending messages to {}:{}", collector.endpoint.address().to_string(),
+                              collector.endpoint.port());
+        }
+        m_collectors = std::move(collectors);
+    });
+}
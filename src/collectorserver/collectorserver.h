@@ -2,24 +2,37 @@
 #define MELON_COLLECTORSERVER_H
 
 #include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../cmdhandler/statevariables.h"
+#include "../detectors/detections.h"
 
 /** @brief Server for sending camera data to collectors
  *
  * This is a server for sending data processed from the camera to end-users specified within the collectors system. <br>
  * Collectors are given through the command handler system; each collector is a target ip address and port number
- * that data should be sent to
+ * that data should be sent to. <br>
+ * Messages are only assembled by the calling thread. They are then handed to the server's own thread, which runs an
+ * io_context and sends them asynchronously, one at a time, from a short send queue. So sending never waits on the
+ * network, and a slow or unreachable collector can't hold up the pipeline. If the queue fills up the oldest messages
+ * are dropped, since newer detections make them worthless anyways
  *
  * @see command_handler
  */
 class CollectorServer : public UpdateableState
 {
 public:
-    /** @brief Create new server instance
+    /** @brief Create new server instance and start its thread
      *
      * @param state [in] State to receive configuration from
      */
     CollectorServer(const StateVariables& state);
+    CollectorServer(const CollectorServer& other) = delete;
     ~CollectorServer();
 
     // Send the given data to all collectors
@@ -31,12 +44,71 @@ public:
      */
     void send(const std::string& data);
 
+    /** @brief Send detections to collectors
+     *
+     * This sends the fused detections of all cameras as a single message to all of the endpoints within the collector
+     * system. Each camera's detections carry the time their frame was captured (nanoseconds since the Unix epoch),
+     * the camera's own timestamp for the frame, and how long ago the frame was captured when the message was sent
+     *
+     * @param detections [in] Detections of each camera
+     * @see DetectionFusion
+     */
+    void send(const std::vector<Detections>& detections);
+
     void update_state(const StateVariables& state) override;
 private:
-    asio::io_service m_service;
+    /** @brief A collector that messages are sent to
+     *
+     */
+    struct Collector
+    {
+        asio::ip::udp::endpoint endpoint;
+        // Did the last send to the collector fail. Errors are only logged when this changes, not for every message
+        bool failing = false;
+    };
+
+    /** @brief Hand a message to the server's thread to be sent to all collectors
+     *
+     * @param data [in] JSON value for the message's "data" field
+     */
+    void send_message(const std::string& data);
+
+    /** @brief Add a message to the send queue and start sending if nothing is being sent
+     *
+     * @note Only called on the server's thread
+     *
+     * @param message [in] Message to add
+     */
+    void queue_message(std::shared_ptr<const std::string> message);
+
+    /** @brief Send the message at the front of the queue to a collector
+     *
+     * Once the message has been sent to the last collector, it's taken off the queue and the next one is started
+     *
+     * @note Only called on the server's thread
+     *
+     * @param collector [in] Index of the collector to send to
+     */
+    void send_next(std::size_t collector);
+
+    /** @brief Callback function for the server's thread
+     *
+     */
+    void thread_func();
+
+    asio::io_context m_io_context;
+    // Keeps the io_context running while there is nothing to send
+    asio::executor_work_guard<asio::io_context::executor_type> m_work;
     asio::ip::udp::socket m_socket;
-    std::vector<asio::ip::udp::endpoint> m_endpoints;
     std::atomic_uint m_message_count;
+
+    // Only accessed on the server's thread
+    std::vector<Collector> m_collectors;
+    std::deque<std::shared_ptr<const std::string>> m_queue;
+    bool m_sending = false;
+    std::uint64_t m_dropped_messages = 0;
+
+    std::thread m_thread;
 };
 
 
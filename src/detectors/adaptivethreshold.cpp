@@ -0,0 +1,215 @@
+#include "adaptivethreshold.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MELON_THRESHOLD_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MELON_THRESHOLD_NEON
+#include <arm_neon.h>
+#endif
+
+/** @brief One output row of a single window size
+ *
+ * The four integral image pointers point at the corners of the window around the row's first pixel, so the window
+ * around pixel x sums to bottom_right[x] - top_right[x] - bottom_left[x] + top_left[x]
+ */
+struct ThresholdRow
+{
+    const std::int32_t* top_left;
+    const std::int32_t* top_right;
+    const std::int32_t* bottom_left;
+    const std::int32_t* bottom_right;
+    const std::uint8_t* src;
+    std::uint8_t* dst;
+    // 1 / the amount of pixels in a window
+    float scale;
+    // Pixels this much brighter than the mean, or more, are 0
+    int delta;
+};
+
+/** @brief Threshold part of a row one pixel at a time
+ *
+ * The mean is rounded to the nearest integer like cv::boxFilter() does for 8 bit images. Windows have an odd amount
+ * of pixels, so the mean is never exactly halfway between two integers and the float product rounds the same way as
+ * OpenCV's double one
+ *
+ * @param row [in] Row to threshold
+ * @param begin [in] First pixel to threshold
+ * @param end [in] One past the last pixel to threshold
+ */
+static void threshold_row_scalar(const ThresholdRow& row, int begin, int end)
+{
+    for(int x = begin; x < end; ++x)
+    {
+        const std::int32_t sum = row.bottom_right[x] - row.top_right[x] - row.bottom_left[x] + row.top_left[x];
+        const int mean = cvRound(static_cast<float>(sum) * row.scale);
+        row.dst[x] = row.src[x] + row.delta > mean ? 0 : 255;
+    }
+}
+
+#ifdef MELON_THRESHOLD_AVX2
+/** @brief Threshold as much of a row as possible 8 pixels at a time
+ *
+ * @param row [in] Row to threshold
+ * @param width [in] Amount of pixels in the row
+ * @return Amount of pixels thresholded. The rest are left for threshold_row_scalar()
+ */
+__attribute__((target("avx2")))
+static int threshold_row_avx2(const ThresholdRow& row, int width)
+{
+    const __m256 scale = _mm256_set1_ps(row.scale);
+    const __m256i delta = _mm256_set1_epi32(row.delta);
+    const __m256i white = _mm256_set1_epi32(255);
+    int x = 0;
+    for(; x + 8 <= width; x += 8)
+    {
+        const __m256i sum = _mm256_sub_epi32(
+                _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row.bottom_right + x)),
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row.top_left + x))),
+                _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row.top_right + x)),
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row.bottom_left + x))));
+        // Rounds to nearest like cvRound(), since the rounding mode is left at its default
+        const __m256i mean = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(sum), scale));
+        const __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row.src + x)));
+
+        const __m256i bright = _mm256_cmpgt_epi32(_mm256_add_epi32(pixels, delta), mean);
+        const __m256i result = _mm256_andnot_si256(bright, white);
+        const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(row.dst + x), _mm_packus_epi16(words, words));
+    }
+    return x;
+}
+
+/** @brief Can this CPU run threshold_row_avx2()
+ *
+ * @return True if the CPU supports AVX2
+ */
+static bool has_avx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+#ifdef MELON_THRESHOLD_NEON
+/** @brief Threshold as much of a row as possible 8 pixels at a time
+ *
+ * @param row [in] Row to threshold
+ * @param width [in] Amount of pixels in the row
+ * @return Amount of pixels thresholded. The rest are left for threshold_row_scalar()
+ */
+static int threshold_row_neon(const ThresholdRow& row, int width)
+{
+    const float32x4_t scale = vdupq_n_f32(row.scale);
+    const int32x4_t delta = vdupq_n_s32(row.delta);
+    const uint32x4_t white = vdupq_n_u32(255);
+    int x = 0;
+    for(; x + 8 <= width; x += 8)
+    {
+        const uint16x8_t pixels = vmovl_u8(vld1_u8(row.src + x));
+        uint16x4_t halves[2];
+        for(int half = 0; half < 2; ++half)
+        {
+            const int i = x + half * 4;
+            const int32x4_t sum = vsubq_s32(vaddq_s32(vld1q_s32(row.bottom_right + i), vld1q_s32(row.top_left + i)),
+                                            vaddq_s32(vld1q_s32(row.top_right + i), vld1q_s32(row.bottom_left + i)));
+            // Rounds to nearest like cvRound()
+            const int32x4_t mean = vcvtnq_s32_f32(vmulq_f32(vcvtq_f32_s32(sum), scale));
+            const int32x4_t values = vreinterpretq_s32_u32(
+                    vmovl_u16(half == 0 ? vget_low_u16(pixels) : vget_high_u16(pixels)));
+
+            const uint32x4_t bright = vcgtq_s32(vaddq_s32(values, delta), mean);
+            halves[half] = vmovn_u32(vbicq_u32(white, bright));
+        }
+        vst1_u8(row.dst + x, vmovn_u16(vcombine_u16(halves[0], halves[1])));
+    }
+    return x;
+}
+#endif
+
+bool is_threshold_vectorized()
+{
+#if defined(MELON_THRESHOLD_AVX2)
+    return has_avx2();
+#elif defined(MELON_THRESHOLD_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void adaptive_threshold(const cv::Mat& gray, const std::vector<int>& window_sizes, double constant,
+                        std::vector<cv::Mat>& thresholds, ThresholdKernel kernel)
+{
+    CV_Assert(gray.type() == CV_8UC1);
+    thresholds.resize(window_sizes.size());
+    if(window_sizes.empty())
+        return;
+
+    // Pad the image by the largest window's radius so that every window lies within it. The padding replicates the
+    // border the same way cv::adaptiveThreshold() does, treating an ROI as a whole image
+    thread_local cv::Mat padded, integral;
+    const int radius = *std::max_element(window_sizes.begin(), window_sizes.end()) / 2;
+    cv::copyMakeBorder(gray, padded, radius, radius, radius, radius, cv::BORDER_REPLICATE | cv::BORDER_ISOLATED);
+
+    // The integral image is 32 bit, so it would overflow for images of about 8 megapixels or more. Those are split
+    // into strips of rows whose integral images fit, each one with the padding rows above and below it so that its
+    // windows lie within it
+    const std::int64_t max_padded_rows =
+            std::numeric_limits<std::int32_t>::max() / (255 * static_cast<std::int64_t>(padded.cols));
+    CV_Assert(max_padded_rows > 2 * radius);
+    const int strip_rows = static_cast<int>(std::min<std::int64_t>(max_padded_rows - 2 * radius, gray.rows));
+
+    // Same rounding of the constant as cv::adaptiveThreshold() for cv::THRESH_BINARY_INV
+    const int delta = cvFloor(constant);
+    for(auto& threshold : thresholds)
+        threshold.create(gray.size(), CV_8UC1);
+    const bool vectorized = kernel == ThresholdKernel::FASTEST && is_threshold_vectorized();
+
+    for(int strip = 0; strip < gray.rows; strip += strip_rows)
+    {
+        const int rows = std::min(strip_rows, gray.rows - strip);
+        cv::integral(padded.rowRange(strip, strip + rows + 2 * radius), integral, CV_32S);
+
+        // Every window size is done for a row before moving to the next one, so the rows of the integral image are
+        // still in the cache for the next window size
+        for(int y = strip; y < strip + rows; ++y)
+        {
+            for(std::size_t i = 0; i < window_sizes.size(); ++i)
+            {
+                // Row and column of the strip's integral image at the window's top left corner around pixel (0, y),
+                // and one past its bottom right corner
+                const int window_radius = window_sizes[i] / 2;
+                const int top = y - strip + radius - window_radius;
+                const int bottom = y - strip + radius + window_radius + 1;
+                const int left = radius - window_radius;
+                const int right = radius + window_radius + 1;
+
+                ThresholdRow row;
+                row.top_left = integral.ptr<std::int32_t>(top) + left;
+                row.top_right = integral.ptr<std::int32_t>(top) + right;
+                row.bottom_left = integral.ptr<std::int32_t>(bottom) + left;
+                row.bottom_right = integral.ptr<std::int32_t>(bottom) + right;
+                row.src = gray.ptr<std::uint8_t>(y);
+                row.dst = thresholds[i].ptr<std::uint8_t>(y);
+                row.scale = 1.0f / static_cast<float>(window_sizes[i] * window_sizes[i]);
+                row.delta = delta;
+
+                int done = 0;
+#if defined(MELON_THRESHOLD_AVX2)
+                if(vectorized)
+                    done = threshold_row_avx2(row, gray.cols);
+#elif defined(MELON_THRESHOLD_NEON)
+                if(vectorized)
+                    done = threshold_row_neon(row, gray.cols);
+#endif
+                threshold_row_scalar(row, done, gray.cols);
+            }
+        }
+    }
+}
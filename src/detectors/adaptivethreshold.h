@@ -0,0 +1,47 @@
+#ifndef MELON_ADAPTIVETHRESHOLD_H
+#define MELON_ADAPTIVETHRESHOLD_H
+
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+/** @brief Ways adaptive_threshold() can threshold each row
+ *
+ */
+enum class ThresholdKernel
+{
+    // 8 pixels at a time with AVX2 or NEON where the CPU has it, one at a time otherwise
+    FASTEST,
+    // One pixel at a time on every CPU, for checking and timing the vectorized rows against
+    SCALAR
+};
+
+/** @brief Does ThresholdKernel::FASTEST threshold rows with AVX2 or NEON on this CPU
+ *
+ * @return True if rows are vectorized, false if they're thresholded one pixel at a time anyway
+ */
+bool is_threshold_vectorized();
+
+/** @brief Threshold a grayscale image against its local mean, for several window sizes at once
+ *
+ * This gives the same result as calling cv::adaptiveThreshold() with cv::ADAPTIVE_THRESH_MEAN_C and
+ * cv::THRESH_BINARY_INV once per window size, the way ArUco's candidate search does: a pixel is 255 if it's darker
+ * than the mean of the window around it minus the constant, 0 otherwise. Borders are replicated. <br>
+ * Instead of box filtering the image once per window size, the integral image is computed once and every window size
+ * is thresholded in the same pass over it, 8 pixels at a time with AVX2 or NEON where the CPU has it and one at a time
+ * otherwise. <br>
+ * The integral image is 32 bit, so images of about 8 megapixels or more are done in strips of rows that it doesn't
+ * overflow for. <br>
+ * The padded and integral images are kept per thread and reused, so thresholding frames of the same size doesn't
+ * allocate
+ *
+ * @param gray [in] Single channel, 8 bit image
+ * @param window_sizes [in] Side lengths of the windows. Must be odd and at least 3
+ * @param constant [in] Amount subtracted from the mean, see cv::adaptiveThreshold()
+ * @param thresholds [out] One thresholded image per window size. Their memory is reused if they already have the
+ *                         right size
+ * @param kernel [in] How to threshold each row. Every kernel gives the same result
+ */
+void adaptive_threshold(const cv::Mat& gray, const std::vector<int>& window_sizes, double constant,
+                        std::vector<cv::Mat>& thresholds, ThresholdKernel kernel = ThresholdKernel::FASTEST);
+
+#endif //MELON_ADAPTIVETHRESHOLD_H
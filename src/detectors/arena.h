@@ -2,6 +2,11 @@
 #define MELON_ARENA_H
 
 #include "marker.h"
+#include <array>
+
+// The arena's corners are marked with the first ids of the marker dictionary, robots use the ones after them
+constexpr int ARENA_MARKER_COUNT = 4;
+
 struct Arena
 {
     std::array<Marker, 4> corners;
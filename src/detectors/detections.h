@@ -0,0 +1,27 @@
+#ifndef MELON_DETECTIONS_H
+#define MELON_DETECTIONS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "marker.h"
+
+/** @brief Markers detected in a single frame from a single camera
+ *
+ */
+struct Detections
+{
+    /// Name of the camera the frame came from
+    std::string camera;
+    /// When the frame was captured, see Frame::timestamp
+    std::chrono::steady_clock::time_point timestamp;
+    /// The camera's own timestamp for the frame, see Frame::device_timestamp
+    std::int64_t device_timestamp = 0;
+    /// Sequence number of the frame within its camera's pipeline, see Frame::sequence
+    std::uint64_t sequence = 0;
+    /// Markers detected in the frame
+    std::vector<Marker> markers;
+};
+
+#endif //MELON_DETECTIONS_H
\ No newline at end of file
@@ -1,42 +1,393 @@
 #include "markerdetector.h"
 #include "../camera/cameracalib.h"
 #include "marker.h"
+#include "adaptivethreshold.h"
+#include "arena.h"
+#include "../cmdhandler/statevariables.h"
+#include "../pipeline/workstealingpool.h"
+#include "../cmdhandler/constants/variables.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
 
-MarkerDetector::MarkerDetector(CameraCalib calib) : m_calib(calib)
+// Space searched around each coarse candidate at full resolution, in marker sizes
+constexpr double PYRAMID_WINDOW_MARGIN = 0.25;
+// Smallest space searched around each coarse candidate, in pixels of the coarse image, since the candidate's corners
+// are only known to within a coarse pixel or so
+constexpr double PYRAMID_MIN_MARGIN = 4.0;
+// Windows covering more of an image than this are searched as a whole image instead
+constexpr double MAX_PYRAMID_COVERAGE = 0.5;
+
+MarkerDetector::MarkerDetector(CameraCalib calib, int dictionary, cv::Ptr<cv::aruco::DetectorParameters> parameters,
+                               Tiling tiling, int pyramid_levels, const std::vector<int>& marker_ids) :
+        m_calib(calib),
+        m_dictionary(cv::aruco::getPredefinedDictionary(dictionary)),
+        m_parameters(parameters ? std::move(parameters) : cv::aruco::DetectorParameters::create()),
+        m_tiling(tiling),
+        m_pyramid_levels(std::clamp(pyramid_levels, 0, CameraSystemVars::MAX_PYRAMID_LEVELS))
 {
+    // Build a dictionary of only the given markers' codes. Decoding compares a candidate to every code in the
+    // dictionary, so this is a lot less work for a few robots in a large dictionary, and candidates that look like
+    // any other marker never match
+    if(!marker_ids.empty())
+    {
+        cv::Mat codes;
+        for(int id : marker_ids)
+        {
+            if(id < 0 || id >= m_dictionary->bytesList.rows)
+            {
+                spdlog::warn("Marker id {} isn't in the marker dictionary", id);
+                continue;
+            }
+            codes.push_back(m_dictionary->bytesList.row(id));
+            m_marker_ids.push_back(id);
+        }
+        if(!m_marker_ids.empty())
+        {
+            m_dictionary = cv::makePtr<cv::aruco::Dictionary>(codes, m_dictionary->markerSize,
+                                                              m_dictionary->maxCorrectionBits);
+        }
+    }
+
+    // A tile has to be able to hold a whole marker, so it can't be smaller than the overlap. A size of 0 turns tiling
+    // off, so it's left alone
+    if(m_tiling.size > 0)
+        m_tiling.size = std::max(m_tiling.size, m_tiling.overlap);
 }
 
-std::vector<Marker> MarkerDetector::detect(cv::Mat& frame, bool draw)
+bool MarkerDetector::is_tiled(cv::Size size) const
 {
-    // Detect the markers
-    std::vector<std::vector<cv::Point2f>> corners;
+    return m_tiling.pool != nullptr && m_tiling.size > 0 &&
+           (size.width > m_tiling.size + m_tiling.overlap || size.height > m_tiling.size + m_tiling.overlap);
+}
+
+bool MarkerDetector::is_calibrated() const
+{
+    return !m_calib.matrix.empty();
+}
+
+std::vector<int> MarkerDetector::restricted_ids(const RobotSystem& robots)
+{
+    if(robots.robots.empty())
+        return {};
+
     std::vector<int> ids;
-    cv::aruco::detectMarkers(frame, m_dictionary, corners, ids, m_parameters);
+    for(int id = 0; id < ARENA_MARKER_COUNT; ++id)
+        ids.push_back(id);
+    for(const auto& robot : robots.robots)
+        ids.insert(ids.end(), robot.second.begin(), robot.second.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
 
-    // Get the marker rotation and translation vectors
-    std::vector<cv::Vec3d> rvecs, tvecs;
-    // TODO: Replace -1 with user-defined marker length
-    cv::aruco::estimatePoseSingleMarkers(corners, -1, m_calib.matrix, m_calib.dist_coeffs, rvecs, tvecs);
+void MarkerDetector::detect_markers(const cv::Mat& image, std::vector<std::vector<cv::Point2f>>& corners,
+                                    std::vector<int>& ids) const
+{
+    cv::aruco::detectMarkers(image, m_dictionary, corners, ids, m_parameters);
+    if(!m_marker_ids.empty())
+    {
+        for(auto& id : ids)
+            id = m_marker_ids[id];
+    }
+}
 
-    // Draw the markers if required
-    if(draw)
+void MarkerDetector::find(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners,
+                          std::vector<int>& ids) const
+{
+    if(m_pyramid_levels > 0)
+        find_pyramid(gray, corners, ids);
+    else if(is_tiled(gray.size()))
+        find_tiled(gray, corners, ids);
+    else
+        detect_markers(gray, corners, ids);
+}
+
+/** @brief Get the center of a marker
+ *
+ * @param corners [in] Corners of the marker
+ * @return Average of the corners
+ */
+static cv::Point2f marker_center(const std::vector<cv::Point2f>& corners)
+{
+    cv::Point2f center;
+    for(const auto& corner : corners)
+        center += corner;
+    return center / static_cast<float>(corners.size());
+}
+
+void MarkerDetector::find_tiled(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners,
+                                std::vector<int>& ids) const
+{
+    // Lay out the tiles. Each one reaches into the next by the overlap
+    std::vector<cv::Rect> tiles;
+    const cv::Rect image(0, 0, gray.cols, gray.rows);
+    for(int y = 0; y < gray.rows; y += m_tiling.size)
+    {
+        for(int x = 0; x < gray.cols; x += m_tiling.size)
+            tiles.push_back(cv::Rect(x, y, m_tiling.size + m_tiling.overlap, m_tiling.size + m_tiling.overlap) & image);
+    }
+
+    // Search every tile. Each task only writes to its own tile's results
+    std::vector<std::vector<std::vector<cv::Point2f>>> tile_corners(tiles.size());
+    std::vector<std::vector<int>> tile_ids(tiles.size());
+    m_tiling.pool->run(tiles.size(), [&](std::size_t i)
+    {
+        detect_markers(gray(tiles[i]), tile_corners[i], tile_ids[i]);
+        const cv::Point2f tile_offset(tiles[i].tl());
+        for(auto& marker_corners : tile_corners[i])
+        {
+            for(auto& corner : marker_corners)
+                corner += tile_offset;
+        }
+    });
+
+    // Gather the markers of all tiles, dropping the ones that were already found in an earlier tile. Markers with the
+    // same id can only be the same marker if their centers are closer than half a side length
+    corners.clear();
+    ids.clear();
+    for(std::size_t tile = 0; tile < tiles.size(); ++tile)
+    {
+        for(std::size_t i = 0; i < tile_ids[tile].size(); ++i)
+        {
+            const std::vector<cv::Point2f>& candidate = tile_corners[tile][i];
+            const cv::Point2f center = marker_center(candidate);
+            const double half_side = cv::arcLength(candidate, true) / 8.0;
+
+            bool duplicate = false;
+            for(std::size_t j = 0; j < ids.size() && !duplicate; ++j)
+                duplicate = ids[j] == tile_ids[tile][i] && cv::norm(marker_center(corners[j]) - center) < half_side;
+
+            if(!duplicate)
+            {
+                corners.push_back(candidate);
+                ids.push_back(tile_ids[tile][i]);
+            }
+        }
+    }
+}
+
+void MarkerDetector::find_candidates(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& candidates) const
+{
+    // Same window sizes as ArUco, which only uses odd ones
+    std::vector<int> window_sizes;
+    for(int size = m_parameters->adaptiveThreshWinSizeMin; size <= m_parameters->adaptiveThreshWinSizeMax;
+        size += std::max(m_parameters->adaptiveThreshWinSizeStep, 1))
+    {
+        window_sizes.push_back(std::max(size | 1, 3));
+    }
+    // The thresholded images are kept per thread so that their memory is reused between frames
+    thread_local std::vector<cv::Mat> thresholds;
+    adaptive_threshold(gray, window_sizes, m_parameters->adaptiveThreshConstant, thresholds);
+
+    // Keep the contours that are convex quads of the right size, away from the border, like ArUco does
+    const int max_side = std::max(gray.cols, gray.rows);
+    const auto min_perimeter = static_cast<std::size_t>(m_parameters->minMarkerPerimeterRate * max_side);
+    const auto max_perimeter = static_cast<std::size_t>(m_parameters->maxMarkerPerimeterRate * max_side);
+    const int border = m_parameters->minDistanceToBorder;
+    candidates.clear();
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> quad;
+    for(auto& threshold : thresholds)
+    {
+        // findContours() is allowed to change the thresholded image, which isn't needed afterwards
+        cv::findContours(threshold, contours, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
+        for(const auto& contour : contours)
+        {
+            if(contour.size() < min_perimeter || contour.size() > max_perimeter)
+                continue;
+            cv::approxPolyDP(contour, quad, contour.size() * m_parameters->polygonalApproxAccuracyRate, true);
+            if(quad.size() != 4 || !cv::isContourConvex(quad))
+                continue;
+
+            // Corners too close together mean a degenerate quad
+            const double min_distance = contour.size() * m_parameters->minCornerDistanceRate;
+            bool degenerate = false;
+            for(std::size_t i = 0; i < 4 && !degenerate; ++i)
+                degenerate = cv::norm(quad[i] - quad[(i + 1) % 4]) < min_distance;
+            if(degenerate)
+                continue;
+
+            const bool near_border = std::any_of(quad.begin(), quad.end(), [&](const cv::Point& corner)
+            {
+                return corner.x < border || corner.y < border ||
+                       corner.x >= gray.cols - border || corner.y >= gray.rows - border;
+            });
+            if(near_border)
+                continue;
+
+            candidates.emplace_back(quad.begin(), quad.end());
+        }
+    }
+}
+
+void MarkerDetector::find_pyramid(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners,
+                                  std::vector<int>& ids) const
+{
+    // Find the candidates on the coarse level
+    const double scale = 1 << m_pyramid_levels;
+    cv::Mat coarse;
+    cv::resize(gray, coarse, cv::Size(), 1.0 / scale, 1.0 / scale, cv::INTER_AREA);
+    std::vector<std::vector<cv::Point2f>> candidates;
+    find_candidates(coarse, candidates);
+
+    // Put a window around each candidate at full resolution
+    const cv::Rect image(0, 0, gray.cols, gray.rows);
+    std::vector<cv::Rect> windows;
+    windows.reserve(candidates.size());
+    for(const auto& candidate : candidates)
+    {
+        const cv::Rect2f bounds = cv::boundingRect(candidate);
+        const double margin = std::max(std::max(bounds.width, bounds.height) * PYRAMID_WINDOW_MARGIN,
+                                       PYRAMID_MIN_MARGIN) * scale;
+        cv::Rect window(cv::Point(cvFloor(bounds.x * scale - margin), cvFloor(bounds.y * scale - margin)),
+                        cv::Point(cvCeil(bounds.br().x * scale + margin), cvCeil(bounds.br().y * scale + margin)));
+        window &= image;
+        if(!window.empty())
+            windows.push_back(window);
+    }
+    merge_regions(windows);
+
+    int area = 0;
+    for(const auto& window : windows)
+        area += window.area();
+    if(area > MAX_PYRAMID_COVERAGE * image.area())
+    {
+        detect_markers(gray, corners, ids);
+        return;
+    }
+
+    // Refine and decode only within the windows
+    find_windows(gray, windows, corners, ids);
+}
+
+void MarkerDetector::find_windows(const cv::Mat& gray, const std::vector<cv::Rect>& windows,
+                                  std::vector<std::vector<cv::Point2f>>& corners, std::vector<int>& ids) const
+{
+    // Each window only writes to its own results
+    std::vector<std::vector<std::vector<cv::Point2f>>> window_corners(windows.size());
+    std::vector<std::vector<int>> window_ids(windows.size());
+    const auto search = [&](std::size_t i)
     {
-        cv::aruco::drawDetectedMarkers(frame, corners, ids);
-        cv::aruco::drawAxis(frame, m_calib.matrix, m_calib.dist_coeffs, rvecs, tvecs, 1.0);
+        detect_markers(gray(windows[i]), window_corners[i], window_ids[i]);
+        const cv::Point2f window_offset(windows[i].tl());
+        for(auto& marker_corners : window_corners[i])
+        {
+            for(auto& corner : marker_corners)
+                corner += window_offset;
+        }
+    };
+    if(m_tiling.pool != nullptr && windows.size() > 1)
+    {
+        m_tiling.pool->run(windows.size(), search);
+    }
+    else
+    {
+        for(std::size_t i = 0; i < windows.size(); ++i)
+            search(i);
+    }
+
+    // The windows don't overlap, so every marker was only found once
+    corners.clear();
+    ids.clear();
+    for(std::size_t i = 0; i < windows.size(); ++i)
+    {
+        corners.insert(corners.end(), window_corners[i].begin(), window_corners[i].end());
+        ids.insert(ids.end(), window_ids[i].begin(), window_ids[i].end());
     }
+}
+
+void MarkerDetector::merge_regions(std::vector<cv::Rect>& regions)
+{
+    // A merged region can overlap regions that didn't overlap either of its parts, so start over after every merge
+    for(bool merged = true; merged;)
+    {
+        merged = false;
+        for(std::size_t i = 0; i < regions.size() && !merged; ++i)
+        {
+            for(std::size_t j = i + 1; j < regions.size() && !merged; ++j)
+            {
+                if((regions[i] & regions[j]).empty())
+                    continue;
+                regions[i] |= regions[j];
+                regions.erase(regions.begin() + j);
+                merged = true;
+            }
+        }
+    }
+}
+
+std::vector<Marker> MarkerDetector::estimate(const std::vector<std::vector<cv::Point2f>>& corners,
+                                             const std::vector<int>& ids, cv::Point offset) const
+{
+    // Get the marker rotation and translation vectors. This needs the camera calibration, so skip it if there isn't
+    // one yet. Poses are estimated from the corners within the image, since that's what the calibration describes
+    // when the whole sensor is read out
+    std::vector<cv::Vec3d> rvecs, tvecs;
+    const bool calibrated = is_calibrated() && !ids.empty();
+    // TODO: Replace 1.0 with user-defined marker length
+    if(calibrated)
+        cv::aruco::estimatePoseSingleMarkers(corners, 1.0, m_calib.matrix, m_calib.dist_coeffs, rvecs, tvecs);
 
     // Wrap the marker data into Marker struct instances
-    std::vector<Marker> markers(ids.size());
-    for(int i = 0; i < ids.size(); ++i)
+    const cv::Point2f sensor_offset(offset);
+    std::vector<Marker> markers;
+    markers.reserve(ids.size());
+    for(std::size_t i = 0; i < ids.size(); ++i)
     {
         Marker m;
         m.id = ids[i];
         m.corners = corners[i];
-        m.rvec = rvecs[i];
-        m.tvec = tvecs[i];
+        // Give the corners in sensor coordinates so that they don't depend on the camera's current sensor region
+        for(auto& corner : m.corners)
+            corner += sensor_offset;
+        if(calibrated)
+        {
+            m.rvec = rvecs[i];
+            m.tvec = tvecs[i];
+        }
 
         markers.push_back(m);
     }
 
+    return markers;
+}
+
+void MarkerDetector::draw(cv::Mat& output, const std::vector<Marker>& markers, cv::Point offset) const
+{
+    // Markers are in sensor coordinates, so move them back into the image
+    const cv::Point2f image_offset(offset);
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int> ids;
+    corners.reserve(markers.size());
+    ids.reserve(markers.size());
+    for(const auto& marker : markers)
+    {
+        corners.push_back(marker.corners);
+        for(auto& corner : corners.back())
+            corner -= image_offset;
+        ids.push_back(marker.id);
+    }
+
+    cv::aruco::drawDetectedMarkers(output, corners, ids);
+    if(is_calibrated())
+    {
+        for(const auto& marker : markers)
+            cv::aruco::drawAxis(output, m_calib.matrix, m_calib.dist_coeffs, marker.rvec, marker.tvec, 1.0);
+    }
+}
+
+std::vector<Marker> MarkerDetector::detect(const Frame& frame, cv::Mat* output)
+{
+    // Detect the markers. ArUco detection only needs intensity, so give it the grayscale plane
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int> ids;
+    find(frame.gray(m_gray), corners, ids);
+
+    std::vector<Marker> markers = estimate(corners, ids, frame.offset);
+
+    // Draw the markers if required
+    if(output != nullptr)
+        draw(*output, markers, frame.offset);
+
     return markers;
 }
\ No newline at end of file
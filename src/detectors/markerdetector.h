@@ -5,18 +5,192 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/aruco.hpp>
 #include "../camera/cameracalib.h"
+#include "../camera/frame.h"
 
 class Marker;
+class WorkStealingPool;
+struct RobotSystem;
+
+/** @brief Detects ArUco markers and estimates their poses
+ *
+ * Detection is split into finding the markers (MarkerDetector::find()) and estimating their poses
+ * (MarkerDetector::estimate()) so that the steps can run in separate pipeline stages. Both are const and can be called
+ * from several threads at once. MarkerDetector::detect() does every step at once for single threaded use. <br>
+ * Large frames can be split into tiles that are searched in parallel, see MarkerDetector::Tiling. They can also be
+ * searched coarse-to-fine: candidates are found on a downscaled image, and only the windows around them are searched
+ * at full resolution to refine the corners and decode the markers
+ */
 class MarkerDetector
 {
 public:
-    MarkerDetector(CameraCalib calib);
-    std::vector<Marker> detect(cv::Mat& frame, bool draw = false);
+    /** @brief How to split images into tiles for detection
+     *
+     * Every tile is extended into its neighbours by the overlap, so a marker that is no larger than the overlap is
+     * always completely within at least one tile. Markers found in more than one tile are only kept once
+     */
+    struct Tiling
+    {
+        /// Side length of the tiles in pixels, not counting the overlap. 0 doesn't split images into tiles
+        int size = 0;
+        /// Amount of pixels each tile overlaps the next one by. Should be larger than the largest marker
+        int overlap = 0;
+        /// Pool that the tiles are searched on. Images aren't split into tiles if this is null
+        WorkStealingPool* pool = nullptr;
+    };
+
+    /** @brief Create a new detector
+     *
+     * @param calib [in] Calibration of the camera that frames will come from. Poses aren't estimated if it's empty
+     * @param dictionary [in] Predefined ArUco dictionary of the markers, see cv::aruco::PREDEFINED_DICTIONARY_NAME
+     * @param parameters [in] ArUco's detection parameters, also used for the candidate search of pyramid detection.
+     *                        ArUco's defaults are used if it's null
+     * @param tiling [in] How to split images into tiles. The pool must outlive the detector
+     * @param pyramid_levels [in] Amount of times images are halved in size to find candidates on, at most
+     *                            CameraSystemVars::MAX_PYRAMID_LEVELS. 0 searches images at full resolution only
+     * @param marker_ids [in] Ids of the only markers to look for, see MarkerDetector::restricted_ids(). If empty,
+     *                        every marker in the dictionary is looked for
+     */
+    MarkerDetector(CameraCalib calib, int dictionary, cv::Ptr<cv::aruco::DetectorParameters> parameters = nullptr,
+                   Tiling tiling = {}, int pyramid_levels = 0, const std::vector<int>& marker_ids = {});
+
+    /** @brief Get the ids of the markers that can be in the arena
+     *
+     * These are the arena's corner markers and every robot's markers. Restricting a detector to these means candidates
+     * are only compared against their codes, so decoding each candidate is quicker and a candidate that happens to
+     * look like some other marker is rejected right away
+     *
+     * @param robots [in] Robots and their marker ids
+     * @return Sorted ids without duplicates, or empty if there are no robots so that nothing is restricted
+     */
+    static std::vector<int> restricted_ids(const RobotSystem& robots);
+
+    /** @brief Are images of a size split into tiles by MarkerDetector::find()
+     *
+     * @param size [in] Size of the image
+     * @return True if tiling is enabled and the image is larger than a single tile
+     */
+    bool is_tiled(cv::Size size) const;
+
+    /** @brief Find the markers within a grayscale image
+     *
+     * If tiling is enabled and the image is larger than a single tile, the tiles are searched in parallel on the
+     * tiling pool and markers found in the overlaps are de-duplicated. With pyramid levels, the image is searched
+     * coarse-to-fine instead
+     *
+     * @param gray [in] Single channel, 8 bit image
+     * @param corners [out] Corners of each marker that was found, in image coordinates
+     * @param ids [out] Id of each marker that was found
+     */
+    void find(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners, std::vector<int>& ids) const;
+
+    /** @brief Estimate the poses of found markers
+     *
+     * @param corners [in] Corners of each marker, in image coordinates
+     * @param ids [in] Id of each marker
+     * @param offset [in] Position of the image on the sensor, see Frame::offset
+     * @return Markers with their corners in sensor coordinates, and their poses if the detector has a calibration
+     */
+    std::vector<Marker> estimate(const std::vector<std::vector<cv::Point2f>>& corners, const std::vector<int>& ids,
+                                 cv::Point offset) const;
+
+    /** @brief Draw markers onto an image
+     *
+     * @param output [in, out] BGR image to draw onto
+     * @param markers [in] Markers to draw, see MarkerDetector::estimate()
+     * @param offset [in] Position of the image on the sensor, see Frame::offset
+     */
+    void draw(cv::Mat& output, const std::vector<Marker>& markers, cv::Point offset) const;
+
+    /** @brief Merge overlapping regions of an image until none overlap
+     *
+     * @param regions [in, out] Regions to merge
+     */
+    static void merge_regions(std::vector<cv::Rect>& regions);
+
+    /** @brief Detect markers within a frame
+     *
+     * Detection is done on the frame's grayscale plane (see Frame::gray()), so frames captured as Mono8 are never
+     * converted. Marker corners are given in sensor coordinates, i.e. with Frame::offset added
+     *
+     * @note Not thread safe, the grayscale conversion buffer is reused between calls
+     *
+     * @param frame [in] Frame to detect markers in
+     * @param output [in, out] BGR image to draw the detected markers onto. Nothing is drawn if this is null
+     * @return Detected markers
+     */
+    std::vector<Marker> detect(const Frame& frame, cv::Mat* output = nullptr);
 private:
+    // Is there a calibration to estimate poses with
+    bool is_calibrated() const;
+
+    /** @brief Run ArUco's detection on an image
+     *
+     * This is the only place that calls cv::aruco::detectMarkers(). The ids are given as ids of the full dictionary,
+     * even if the detector is restricted
+     *
+     * @param image [in] Single channel, 8 bit image
+     * @param corners [out] Corners of each marker that was found, in image coordinates
+     * @param ids [out] Id of each marker that was found
+     */
+    void detect_markers(const cv::Mat& image, std::vector<std::vector<cv::Point2f>>& corners,
+                        std::vector<int>& ids) const;
+
+    /** @brief Find the markers within a grayscale image by splitting it into tiles
+     *
+     * @param gray [in] Single channel, 8 bit image
+     * @param corners [out] Corners of each marker that was found, in image coordinates
+     * @param ids [out] Id of each marker that was found
+     */
+    void find_tiled(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners, std::vector<int>& ids) const;
+
+    /** @brief Find the quads within a grayscale image that could be markers, without decoding them
+     *
+     * This is the first half of ArUco's detection with the same parameters: the image is thresholded for every window
+     * size (see adaptive_threshold(), which does every size in a single pass) and the contours that are convex quads
+     * of the right size are kept. Quads found at several window sizes are found more than once
+     *
+     * @param gray [in] Single channel, 8 bit image
+     * @param candidates [out] Corners of each candidate, in image coordinates
+     */
+    void find_candidates(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& candidates) const;
+
+    /** @brief Find the markers within a grayscale image, coarse-to-fine
+     *
+     * Candidates are found on the image downscaled by the pyramid levels (see MarkerDetector::find_candidates()), but
+     * not decoded, since markers may be too small to decode at that size. Then only the windows around the candidates
+     * are searched at full resolution. If the windows would cover most of the image, the whole image is searched
+     * instead
+     *
+     * @param gray [in] Single channel, 8 bit image
+     * @param corners [out] Corners of each marker that was found, in image coordinates
+     * @param ids [out] Id of each marker that was found
+     */
+    void find_pyramid(const cv::Mat& gray, std::vector<std::vector<cv::Point2f>>& corners,
+                      std::vector<int>& ids) const;
+
+    /** @brief Find the markers within several windows of a grayscale image
+     *
+     * The windows are searched in parallel on the tiling pool if there is one
+     *
+     * @param gray [in] Single channel, 8 bit image
+     * @param windows [in] Windows to search. Must not overlap
+     * @param corners [out] Corners of each marker that was found, in image coordinates
+     * @param ids [out] Id of each marker that was found
+     */
+    void find_windows(const cv::Mat& gray, const std::vector<cv::Rect>& windows,
+                      std::vector<std::vector<cv::Point2f>>& corners, std::vector<int>& ids) const;
+
     CameraCalib m_calib;
+    // Only holds the codes of the ids being looked for if the detector is restricted
     cv::Ptr<cv::aruco::Dictionary> m_dictionary;
+    // Id within the full dictionary of each marker in m_dictionary. Empty if the detector isn't restricted
+    std::vector<int> m_marker_ids;
     cv::Ptr<cv::aruco::DetectorParameters> m_parameters;
+    Tiling m_tiling;
+    int m_pyramid_levels;
+    // Grayscale conversions of frames, reused between frames
+    cv::Mat m_gray;
 };
 
 
-#endif //MELON_MARKERDETECTOR_H
+#endif //MELON_MARKERDETECTOR_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "markertracker.h"
+#include "markerdetector.h"
+#include <algorithm>
+#include <cmath>
+
+// Space searched around each predicted marker, in marker sizes
+constexpr double WINDOW_MARGIN = 0.5;
+// Smallest space searched around each predicted marker, in pixels, so that small markers can still be found
+constexpr double MIN_WINDOW_MARGIN = 16.0;
+// Extra space searched in the direction of movement, as a fraction of the predicted movement, for markers that speed
+// up or turn
+constexpr double VELOCITY_SLACK = 0.5;
+// Windows covering more of a frame than this are searched as a whole frame instead
+constexpr double MAX_WINDOW_COVERAGE = 0.5;
+// Furthest a marker can be from where a track predicted it, in marker sizes, to continue that track
+constexpr double MAX_MATCH_DISTANCE = 1.0;
+
+/** @brief Get the center of a marker
+ *
+ * @param corners [in] Corners of the marker
+ * @return Average of the corners
+ */
+static cv::Point2f marker_center(const std::vector<cv::Point2f>& corners)
+{
+    cv::Point2f center;
+    for(const auto& corner : corners)
+        center += corner;
+    return center / static_cast<float>(corners.size());
+}
+
+/** @brief Get the time between two points in seconds
+ *
+ * @param from [in] Earlier point in time
+ * @param to [in] Later point in time
+ * @return Seconds from the first point to the second
+ */
+static float seconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<float>(to - from).count();
+}
+
+void MarkerTracker::plan(const Frame& frame, int tracked_frames, std::vector<cv::Rect>& windows)
+{
+    windows.clear();
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if(tracked_frames <= 0 || m_tracks.empty() || m_lost || m_tracked_frames >= tracked_frames)
+    {
+        m_tracked_frames = 0;
+        m_lost = false;
+        return;
+    }
+
+    const cv::Rect image(cv::Point(), frame.image.size());
+    const cv::Point2f offset(frame.offset);
+    for(const auto& track : m_tracks)
+    {
+        // Move the marker along at the speed it was last going
+        const cv::Point2f movement = track.velocity * std::max(seconds(track.seen, frame.timestamp), 0.0f);
+        cv::Point2f min = track.corners[0], max = track.corners[0];
+        for(const auto& corner : track.corners)
+        {
+            min = cv::Point2f(std::min(min.x, corner.x), std::min(min.y, corner.y));
+            max = cv::Point2f(std::max(max.x, corner.x), std::max(max.y, corner.y));
+        }
+        min += movement;
+        max += movement;
+
+        const double size = std::max(max.x - min.x, max.y - min.y);
+        const auto margin = static_cast<float>(std::max(size * WINDOW_MARGIN, MIN_WINDOW_MARGIN) +
+                                               cv::norm(movement) * VELOCITY_SLACK);
+        cv::Rect window(cv::Point(min - offset - cv::Point2f(margin, margin)),
+                        cv::Point(max - offset + cv::Point2f(margin, margin)));
+        window &= image;
+        // A marker predicted to be outside of the frame can't be found in it, so make sure the whole frame is searched
+        // next
+        if(window.empty())
+        {
+            m_lost = true;
+            continue;
+        }
+        windows.push_back(window);
+    }
+
+    // Don't search anything twice
+    MarkerDetector::merge_regions(windows);
+
+    int area = 0;
+    for(const auto& window : windows)
+        area += window.area();
+    if(windows.empty() || area > MAX_WINDOW_COVERAGE * image.area())
+    {
+        windows.clear();
+        m_tracked_frames = 0;
+        m_lost = false;
+        return;
+    }
+    ++m_tracked_frames;
+}
+
+void MarkerTracker::update(const std::vector<Marker>& markers, std::chrono::steady_clock::time_point timestamp,
+                           bool full_scan)
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+
+    // Continue the track that predicted each marker the closest. Ids can repeat when there are more robots than
+    // markers in the dictionary, so the id alone isn't enough
+    std::vector<bool> continued(m_tracks.size(), false);
+    std::vector<Track> tracks;
+    tracks.reserve(markers.size());
+    for(const auto& marker : markers)
+    {
+        if(marker.corners.empty())
+            continue;
+        Track track {marker.id, marker.corners, marker_center(marker.corners), cv::Point2f(), timestamp};
+        const double size = cv::arcLength(marker.corners, true) / 4.0;
+
+        double best_distance = std::max(size * MAX_MATCH_DISTANCE, MIN_WINDOW_MARGIN);
+        std::size_t best = m_tracks.size();
+        for(std::size_t i = 0; i < m_tracks.size(); ++i)
+        {
+            if(continued[i] || m_tracks[i].id != marker.id)
+                continue;
+            const float elapsed = seconds(m_tracks[i].seen, timestamp);
+            const double distance = cv::norm(m_tracks[i].center + m_tracks[i].velocity * elapsed - track.center);
+            if(distance < best_distance)
+            {
+                best_distance = distance;
+                best = i;
+            }
+        }
+        if(best < m_tracks.size())
+        {
+            continued[best] = true;
+            const float elapsed = seconds(m_tracks[best].seen, timestamp);
+            if(elapsed > 0)
+                track.velocity = (track.center - m_tracks[best].center) / elapsed;
+        }
+        tracks.push_back(std::move(track));
+    }
+
+    // A search of the whole frame finds every marker there is, so forget the ones it didn't find. A marker missing
+    // from its window may just have moved out of it, so keep looking for it, searching the whole next frame
+    if(!full_scan)
+    {
+        for(std::size_t i = 0; i < m_tracks.size(); ++i)
+        {
+            if(continued[i])
+                continue;
+            m_lost = true;
+            m_tracks[i].velocity = cv::Point2f();
+            tracks.push_back(std::move(m_tracks[i]));
+        }
+    }
+    m_tracks = std::move(tracks);
+}
@@ -0,0 +1,68 @@
+#ifndef MELON_MARKERTRACKER_H
+#define MELON_MARKERTRACKER_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/types.hpp>
+#include "../camera/frame.h"
+#include "marker.h"
+
+/** @brief Predicts where the known markers are so that only small windows of a frame have to be searched
+ *
+ * Robots only move a few pixels between frames, so searching the whole frame every time is mostly wasted. The tracker
+ * remembers where each marker was last found and how fast it was moving, and MarkerTracker::plan() gives windows
+ * around where the markers should be in a new frame. Every so often, and whenever a marker wasn't found in its window,
+ * the whole frame is searched again so that new markers are picked up and lost ones are found again. <br>
+ * Frames are planned by the capture stage before the results of the frames ahead of them are known, so predictions
+ * are made for the frame's timestamp from however old the last results are. <br>
+ * Everything is thread safe
+ */
+class MarkerTracker
+{
+public:
+    /** @brief Decide which parts of a frame to search
+     *
+     * @param frame [in] Frame that will be searched
+     * @param tracked_frames [in] Frames searched only in windows between two searches of the whole frame. 0 always
+     *                            searches the whole frame
+     * @param windows [out] Windows to search in image coordinates, or empty to search the whole frame
+     */
+    void plan(const Frame& frame, int tracked_frames, std::vector<cv::Rect>& windows);
+
+    /** @brief Remember the markers found in a frame
+     *
+     * Frames must be given in the order they were captured
+     *
+     * @param markers [in] Markers found in the frame, in sensor coordinates
+     * @param timestamp [in] When the frame was captured, see Frame::timestamp
+     * @param full_scan [in] True if the whole frame was searched, false if only the windows from
+     *                       MarkerTracker::plan() were
+     */
+    void update(const std::vector<Marker>& markers, std::chrono::steady_clock::time_point timestamp, bool full_scan);
+
+private:
+    /** @brief Last known position and motion of a marker
+     *
+     */
+    struct Track
+    {
+        int id;
+        // Corners in sensor coordinates
+        std::vector<cv::Point2f> corners;
+        cv::Point2f center;
+        // Movement in pixels per second
+        cv::Point2f velocity;
+        // When the marker was last found
+        std::chrono::steady_clock::time_point seen;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Track> m_tracks;
+    // Frames planned with windows since the last search of the whole frame
+    int m_tracked_frames {0};
+    // A marker wasn't found in its window, so the next frame should be searched as a whole
+    bool m_lost {false};
+};
+
+#endif //MELON_MARKERTRACKER_H
@@ -1,11 +1,17 @@
 #ifndef MELON_ROBOTDATA_H
 #define MELON_ROBOTDATA_H
 
+#include <chrono>
+#include <cstdint>
 #include <opencv2/core/matx.hpp>
 struct RobotData
 {
     cv::Vec3d position;
     cv::Vec3d orientation;
+    /// When the frame the robot was found in was captured, see Frame::timestamp
+    std::chrono::steady_clock::time_point timestamp;
+    /// The camera's own timestamp for the frame, see Frame::device_timestamp
+    std::int64_t device_timestamp = 0;
 };
 
 #endif //MELON_ROBOTDATA_H
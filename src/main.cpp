@@ -11,13 +11,30 @@
 #include <chrono>
 #include <iomanip>
 #include <filesystem>
+#include <map>
+#include <algorithm>
+#include <csignal>
 #include <opencv2/opencv.hpp>
 
 #include "cmdhandler/server.h"
-#include "camera/camerawrapper.h"
 #include "collectorserver/collectorserver.h"
+#include "pipeline/cameraworker.h"
+#include "pipeline/detectionfusion.h"
+#include "pipeline/displayboard.h"
+#include "pipeline/threadplacement.h"
+#include "pipeline/workstealingpool.h"
 
 const std::string LOG_DIR = "logs/";
+// How long the fusion stage waits for slower cameras before sending the detections it has
+constexpr std::chrono::milliseconds FUSION_MAX_WAIT(50);
+// Furthest apart two cameras' frames can be captured to be fused together, about half a frame at 30fps
+constexpr std::chrono::milliseconds FUSION_TOLERANCE(15);
+// Longest the camera manager waits for a camera change before checking for a shutdown again
+constexpr std::chrono::milliseconds MANAGER_WAIT(100);
+// How long the display thread waits for new frames before handling window events anyways
+constexpr std::chrono::milliseconds DISPLAY_WAIT(50);
+// How often the camera manager flushes the logs to disk
+constexpr std::chrono::seconds LOG_FLUSH_INTERVAL(1);
 
 /** @brief Callback function for the thread that the command handler runs in
  *
@@ -27,11 +44,38 @@ const std::string LOG_DIR = "logs/";
  */
 void command_thread_func(int argc, char** argv, std::shared_ptr<GlobalState> state);
 
-/** @brief Callback function for the thread that the camera runs in
+/** @brief Callback function for the thread that manages the cameras
  *
- * @param state Shared pointer to the global state
+ * This starts and stops a CameraWorker for each camera in the state and hands state changes to the workers. It never
+ * touches OpenCV's GUI, see display_thread_func() <br>
+ * When the pipelines are stopped or restarted (see PipelineSystem), the workers' cameras are kept connected and handed
+ * to the next worker for the same camera, so that the pipelines come back without reconnecting the cameras <br>
+ * It also reports the workers' status to the global state, applies the thread placement and flushes the logs, so that
+ * no thread outside of the housekeeping cores does any disk writes
+ *
+ * @param state [in] Shared pointer to the global state
+ * @param fusion [in] Fusion stage that the workers submit to
+ * @param tile_pool [in] Pool that the workers search detection tiles on
+ * @param display [in] Board that the workers post display frames to
+ */
+void camera_manager_thread_func(std::shared_ptr<GlobalState> state, std::shared_ptr<DetectionFusion> fusion,
+                                std::shared_ptr<WorkStealingPool> tile_pool, std::shared_ptr<DisplayBoard> display);
+
+/** @brief Callback function for the thread that shows the cameras' video
+ *
+ * All windows are handled from this thread since OpenCV's GUI functions aren't thread safe. Windows are only opened
+ * once a camera posts a display frame, so with every camera's display rate at 0 the GUI is never touched (headless)
+ *
+ * @param display [in] Board to take display frames from
+ */
+void display_thread_func(std::shared_ptr<DisplayBoard> display);
+
+/** @brief Callback function for the thread that sends detections to the collectors
+ *
+ * @param state [in] Shared pointer to the global state
+ * @param fusion [in] Fusion stage to take detections from
  */
-void camera_thread_func(std::shared_ptr<GlobalState> state);
+void publish_thread_func(std::shared_ptr<GlobalState> state, std::shared_ptr<DetectionFusion> fusion);
 
 int main(int argc, char** argv)
 {
@@ -63,21 +107,32 @@ int main(int argc, char** argv)
         spdlog::register_logger(logger);
         spdlog::set_default_logger(logger);
         spdlog::set_level(spdlog::level::debug);
-        spdlog::flush_every(std::chrono::seconds(1));
+        // Flushed by the camera manager rather than spdlog's own flusher thread, so that it runs on the housekeeping
+        // cores, see ThreadSystem
     }
     std::shared_ptr<GlobalState> state = std::make_shared<GlobalState>();
 
+    std::shared_ptr<DetectionFusion> fusion = std::make_shared<DetectionFusion>(FUSION_MAX_WAIT, FUSION_TOLERANCE);
+    // One thread per core, shared by every camera so that several tiled cameras don't oversubscribe the cores
+    std::shared_ptr<WorkStealingPool> tile_pool = std::make_shared<WorkStealingPool>(0);
+    std::shared_ptr<DisplayBoard> display = std::make_shared<DisplayBoard>();
+
     std::thread command_thread(command_thread_func, argc, argv, state);
-    std::thread camera_thread(camera_thread_func, state);
+    std::thread publish_thread(publish_thread_func, state, fusion);
+    std::thread camera_manager_thread(camera_manager_thread_func, state, fusion, tile_pool, display);
+    std::thread display_thread(display_thread_func, display);
 
     command_thread.join();
-    camera_thread.join();
+    camera_manager_thread.join();
+    publish_thread.join();
+    display_thread.join();
 
     return 0;
 }
 
 void command_thread_func(int argc, char** argv, std::shared_ptr<GlobalState> state)
 {
+    auto placement = ThreadPlacement::enter(ThreadRole::HOUSEKEEPING);
     try{
         // Make sure that the user has specified a port for the server to run on
         if (argc != 2){
@@ -88,69 +143,250 @@ void command_thread_func(int argc, char** argv, std::shared_ptr<GlobalState> sta
         // Start the server
         asio::io_context io_context;
         server s(io_context, std::atoi(argv[1]), state);
-        io_context.run();
+
+        // Shut down on SIGINT/SIGTERM the same as with the shutdown command
+        asio::signal_set signals(io_context, SIGINT, SIGTERM);
+        signals.async_wait([state](const asio::error_code& ec, int signal_number){
+            if(!ec){
+                spdlog::info("Received signal {}, shutting down", signal_number);
+                state->request_shutdown();
+            }
+        });
+
+        // Stop the server once a shutdown was requested
+        std::thread stop_thread([&io_context, state](){
+            state->wait([](const StateVariables& current){ return current.shutdown; });
+            io_context.stop();
+        });
+
+        try{
+            io_context.run();
+        }
+        catch (std::exception& e){
+            // Take the rest of the program down as well, otherwise nothing could stop it anymore
+            state->request_shutdown();
+            stop_thread.join();
+            throw;
+        }
+        stop_thread.join();
     }
     catch (std::exception& e){
         spdlog::critical("Exception in command handler thread: \n{}", e.what());
     }
 }
 
-void camera_thread_func(std::shared_ptr<GlobalState> state)
+/** @brief Check if a camera should have a worker running
+ *
+ * @param camera [in] Camera system to check
+ * @return True if the camera is connected and has the necessary properties present
+ */
+static bool camera_ready(const CameraSystem& camera)
 {
-    // Wait for camera to be connected and necessary properties present
-    state->wait([](const StateVariables& state)
-                {
-                    return state.camera.connected && !state.camera.type.empty() && !state.camera.source.empty();
-                });
+    return camera.connected && !camera.type.empty() && !camera.source.empty();
+}
 
-    StateVariables local_variables = state->get_state();
+void camera_manager_thread_func(std::shared_ptr<GlobalState> state, std::shared_ptr<DetectionFusion> fusion,
+                                std::shared_ptr<WorkStealingPool> tile_pool, std::shared_ptr<DisplayBoard> display)
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::HOUSEKEEPING);
+    std::shared_ptr<const StateVariables> local_state;
+    std::map<std::string, std::unique_ptr<CameraWorker>> workers;
+    // Connected cameras of stopped pipelines, waiting for their pipeline to be started again
+    std::map<std::string, std::unique_ptr<CameraWrapper>> parked;
+    auto last_flush = std::chrono::steady_clock::now();
 
     try
     {
-        CameraWrapper camera(local_variables);
-
-        CollectorServer server(local_variables);
-
-        bool loop = true;
-        cv::Mat frame;
-        // Main frame-grabber loop
-        while (loop)
+        while(!local_state || !local_state->shutdown)
         {
-            // Apply any changes to state variables
-            if(state->apply(local_variables))
+            // Start, stop and update the workers whenever the cameras change, or the robots their detectors look for
+            std::shared_ptr<const StateVariables> previous_state = local_state;
+            if(state->wait_update(local_state, StateSubsystem::CAMERAS | StateSubsystem::SHUTDOWN |
+                                               StateSubsystem::THREADS | StateSubsystem::PIPELINE |
+                                               StateSubsystem::ROBOT, MANAGER_WAIT))
             {
-                if(!local_variables.camera.connected)
+                // Move the threads before starting any new workers, so that they start out on the right cores
+                if(!previous_state || previous_state->threads != local_state->threads)
+                    ThreadPlacement::configure(local_state->threads);
+
+                std::vector<std::string> ready_cameras;
+                for(const auto& name : local_state->camera_names())
+                {
+                    if(camera_ready(*local_state->find_camera(name)))
+                        ready_cameras.push_back(name);
+                }
+
+                // Cameras of stopped pipelines that were removed or disconnected in the meantime aren't needed anymore
+                for(auto it = parked.begin(); it != parked.end();)
                 {
-                    // Wait for camera to be connected and necessary properties present
-                    state->wait([](const StateVariables& state)
-                                {
-                                    return state.camera.connected && !state.camera.type.empty() && !state.camera.source.empty();
-                                });
-                    // Update the local variables
-                    state->apply(local_variables);
+                    if(std::find(ready_cameras.begin(), ready_cameras.end(), it->first) == ready_cameras.end())
+                        it = parked.erase(it);
+                    else
+                        ++it;
                 }
 
-                // Update the server and camera with the new state variables
-                server.update_state(local_variables);
-                camera.update_state(local_variables);
+                // Stop every pipeline when they're stopped or restarted, but keep their cameras connected
+                const bool running = local_state->pipeline.running;
+                const bool restart = previous_state &&
+                                     previous_state->pipeline.restarts != local_state->pipeline.restarts;
+                if((!running || restart) && !workers.empty())
+                {
+                    const auto stop_start = std::chrono::steady_clock::now();
+                    for(auto& pair : workers)
+                    {
+                        spdlog::info("Stopping camera '{}' pipeline", pair.first);
+                        std::unique_ptr<CameraWrapper> camera = pair.second->release_camera();
+                        if(camera)
+                            parked[pair.first] = std::move(camera);
+                        display->remove(pair.first);
+                        state->clear_status(pair.first);
+                    }
+                    workers.clear();
+                    spdlog::info("Stopped the camera pipelines in {:.1f}ms", std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - stop_start).count());
+                }
+
+                const bool robots_changed = previous_state && previous_state->robot != local_state->robot;
+
+                // Stop workers for cameras that were removed or disconnected
+                for(auto it = workers.begin(); it != workers.end();)
+                {
+                    if(std::find(ready_cameras.begin(), ready_cameras.end(), it->first) == ready_cameras.end())
+                    {
+                        spdlog::info("Stopping camera '{}'", it->first);
+                        display->remove(it->first);
+                        state->clear_status(it->first);
+                        it = workers.erase(it);
+                    }
+                    else
+                    {
+                        // Only bother the workers whose camera actually changed, or all of them when the robots did
+                        const CameraSystem* camera = local_state->find_camera(it->first);
+                        const CameraSystem* previous = previous_state ? previous_state->find_camera(it->first) : nullptr;
+                        if(previous == nullptr || *previous != *camera || robots_changed)
+                            it->second->update_state(local_state);
+                        // Close the window of a camera that went headless
+                        if(camera->display_rate == 0)
+                            display->remove(it->first);
+                        ++it;
+                    }
+                }
+
+                // Start workers for new cameras, giving them the camera of their stopped pipeline if there is one
+                const std::vector<std::string> running_cameras = running ? ready_cameras : std::vector<std::string>();
+                for(const auto& name : running_cameras)
+                {
+                    if(workers.find(name) == workers.end())
+                    {
+                        std::unique_ptr<CameraWrapper> camera;
+                        auto it = parked.find(name);
+                        if(it != parked.end())
+                        {
+                            spdlog::info("Starting camera '{}' pipeline", name);
+                            camera = std::move(it->second);
+                            parked.erase(it);
+                        }
+                        else
+                        {
+                            spdlog::info("Starting camera '{}'", name);
+                        }
+                        workers[name] = std::make_unique<CameraWorker>(name, local_state, *fusion, *tile_pool, *display,
+                                                                       std::move(camera));
+                    }
+                }
+
+                fusion->set_cameras(running_cameras);
             }
 
-            if(camera->get_frame(frame))
+            // Pass the workers' load shedding levels on to the command handler
+            for(const auto& pair : workers)
+                state->report_status(pair.first, pair.second->get_status());
+
+            const auto now = std::chrono::steady_clock::now();
+            if(now - last_flush >= LOG_FLUSH_INTERVAL)
             {
-                cv::resize(frame, frame, cv::Size(1280, 720));
-                cv::imshow("camera", frame);
+                spdlog::default_logger()->flush();
+                last_flush = now;
             }
+        }
+    }
+    catch (std::exception& e)
+    {
+        spdlog::critical("Exception in camera manager thread: \n{}", e.what());
+    }
 
-            // TODO: Actually generate/get data
-            std::string data = "data";
-            server.send(data);
+    workers.clear();
+    parked.clear();
+    fusion->close();
+    display->close();
+}
 
-            if(cv::waitKey(1) == 27)
-                loop = false;
+void display_thread_func(std::shared_ptr<DisplayBoard> display)
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::HOUSEKEEPING);
+    try
+    {
+        std::vector<std::pair<std::string, cv::Mat>> frames;
+        std::vector<std::string> removed;
+        std::vector<std::string> windows;
+        while(!display->is_closed())
+        {
+            if(display->take(frames, removed, DISPLAY_WAIT))
+            {
+                for(const auto& name : removed)
+                {
+                    auto it = std::find(windows.begin(), windows.end(), name);
+                    if(it != windows.end())
+                    {
+                        cv::destroyWindow(name);
+                        windows.erase(it);
+                    }
+                }
+                for(const auto& pair : frames)
+                {
+                    if(std::find(windows.begin(), windows.end(), pair.first) == windows.end())
+                        windows.push_back(pair.first);
+                    cv::imshow(pair.first, pair.second);
+                }
+            }
+
+            // Windows only redraw and respond while their events are handled
+            if(!windows.empty())
+                cv::waitKey(1);
         }
+
+        if(!windows.empty())
+            cv::destroyAllWindows();
     }
     catch (std::exception& e)
     {
-        spdlog::critical("Exception in camera thread: \n{}", e.what());
+        spdlog::critical("Exception in display thread: \n{}", e.what());
     }
-}
\ No newline at end of file
+}
+
+void publish_thread_func(std::shared_ptr<GlobalState> state, std::shared_ptr<DetectionFusion> fusion)
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::PUBLISH);
+    try
+    {
+        std::shared_ptr<const StateVariables> local_state = state->snapshot();
+        CollectorServer server(*local_state);
+
+        std::vector<Detections> detections;
+        while(true)
+        {
+            // Apply any changes to the collectors
+            if(state->update(local_state, StateSubsystem::COLLECTOR))
+                server.update_state(*local_state);
+
+            if(fusion->pop(detections, std::chrono::milliseconds(100)))
+                server.send(detections);
+            else if(fusion->is_closed())
+                break;
+        }
+    }
+    catch (std::exception& e)
+    {
+        spdlog::critical("Exception in publish thread: \n{}", e.what());
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef MELON_BOUNDEDQUEUE_H
+#define MELON_BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/** @brief Fixed-capacity queue connecting two pipeline stages
+ *
+ * Pushing to a full queue blocks until the consuming stage has taken an item out, so a slow stage holds back the
+ * stages before it instead of letting items pile up (backpressure). The storage is allocated once when the queue is
+ * created, so passing items through the queue doesn't allocate. <br>
+ * Any number of threads may push and pop
+ *
+ * @tparam T Type of the items. Must be default constructible and movable
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+    /** @brief Create a new queue
+     *
+     * @param capacity [in] Maximum amount of items the queue can hold. At least 1
+     */
+    explicit BoundedQueue(std::size_t capacity) : m_items(capacity > 0 ? capacity : 1) {}
+    BoundedQueue(const BoundedQueue& other) = delete;
+
+    /** @brief Add an item to the queue, waiting for space if the queue is full
+     *
+     * @param item [in, out] Item to add. It is only moved from if it was added
+     * @return True if the item was added, false if the queue was closed
+     */
+    bool push(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]{ return m_closed || m_count < m_items.size(); });
+        if(m_closed)
+            return false;
+        add(item);
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /** @brief Add an item to the queue if there is space, without waiting
+     *
+     * @param item [in, out] Item to add. It is only moved from if it was added
+     * @return True if the item was added, false if the queue was full or closed
+     */
+    bool try_push(T& item)
+    {
+        {
+            std::scoped_lock<std::mutex> lock(m_mutex);
+            if(m_closed || m_count == m_items.size())
+                return false;
+            add(item);
+        }
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /** @brief Take the oldest item out of the queue, waiting for one if the queue is empty
+     *
+     * @param item [out] Item that was taken out of the queue
+     * @return True if an item was taken, false if the queue was closed and is empty
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]{ return m_closed || m_count > 0; });
+        if(m_count == 0)
+            return false;
+        item = std::move(m_items[m_head]);
+        // Don't let the empty slot keep anything alive, i.e. a camera buffer
+        m_items[m_head] = T();
+        m_head = (m_head + 1) % m_items.size();
+        --m_count;
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    /** @brief Close the queue
+     *
+     * This wakes up every thread waiting on the queue and makes any further pushes fail. Items that are already in the
+     * queue can still be taken out
+     */
+    void close()
+    {
+        {
+            std::scoped_lock<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+    /** @brief Throw away every item in the queue
+     *
+     * This releases whatever the items keep alive, i.e. camera buffers, right away instead of when the queue is
+     * destroyed
+     */
+    void clear()
+    {
+        {
+            std::scoped_lock<std::mutex> lock(m_mutex);
+            for(auto& item : m_items)
+                item = T();
+            m_head = 0;
+            m_count = 0;
+        }
+        m_not_full.notify_all();
+    }
+
+    /** @brief Get the amount of items in the queue
+     *
+     * @return Amount of items. May already be out of date when it's returned if other threads use the queue
+     */
+    std::size_t size()
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        return m_count;
+    }
+
+    /** @brief Get the maximum amount of items the queue can hold
+     *
+     * @return Capacity of the queue
+     */
+    std::size_t capacity() const { return m_items.size(); }
+
+    /** @brief Has the queue been closed
+     *
+     * @return True if BoundedQueue::close() has been called
+     */
+    bool is_closed()
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+private:
+    // Add an item behind the newest one. m_mutex must be held and the queue must not be full
+    void add(T& item)
+    {
+        m_items[(m_head + m_count) % m_items.size()] = std::move(item);
+        ++m_count;
+    }
+
+    std::vector<T> m_items;
+    std::size_t m_head = 0;
+    std::size_t m_count = 0;
+    bool m_closed = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+};
+
+#endif //MELON_BOUNDEDQUEUE_H
\ No newline at end of file
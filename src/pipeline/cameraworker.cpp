@@ -0,0 +1,614 @@
+#include "cameraworker.h"
+#include "threadplacement.h"
+#include "../detectors/arena.h"
+#include <spdlog/spdlog.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <map>
+
+// Amount of frames each queue between two stages can hold
+constexpr std::size_t STAGE_QUEUE_DEPTH = 2;
+// Size that display frames are scaled to
+const cv::Size DISPLAY_SIZE(1280, 720);
+// How often throughput and accuracy are logged
+constexpr std::chrono::seconds STATS_INTERVAL(5);
+// Furthest a detected marker's corners can be from the ground truth, on average, to count as the same marker
+constexpr double MAX_CORNER_ERROR = 20.0;
+// Frames searched only around the markers while shedding load before a whole frame is searched again, unless the
+// camera tracks its markers anyways, see CameraSystem::tracking_frames
+constexpr int SHED_TRACKING_FRAMES = 15;
+
+/** @brief Throughput and accuracy of a worker since the last time they were logged
+ *
+ */
+struct WorkerStats
+{
+    std::uint64_t frames = 0;
+    // Totals of the frames' latencies in milliseconds: until they were preprocessed, detected and published
+    double preprocess_latency = 0;
+    double detect_latency = 0;
+    double latency = 0;
+    // Markers in the ground truth, how many of them were detected, and the total of their average corner errors
+    std::uint64_t truth_markers = 0;
+    std::uint64_t matched_markers = 0;
+    double corner_error = 0;
+};
+
+/** @brief Compare detected markers to the markers known to be in the frame
+ *
+ * @param truth [in] Markers known to be in the frame
+ * @param markers [in] Detected markers
+ * @param stats [in, out] Statistics to add the results to
+ */
+static void score_detections(const std::vector<MarkerTruth>& truth, const std::vector<Marker>& markers,
+                             WorkerStats& stats)
+{
+    for(const auto& expected : truth)
+    {
+        // Ids can repeat when there are more robots than markers in the dictionary, so take the closest match
+        double best_error = MAX_CORNER_ERROR;
+        for(const auto& marker : markers)
+        {
+            if(marker.id != expected.id || marker.corners.size() != expected.corners.size())
+                continue;
+            double error = 0;
+            for(std::size_t i = 0; i < expected.corners.size(); ++i)
+                error += cv::norm(marker.corners[i] - expected.corners[i]);
+            best_error = std::min(best_error, error / expected.corners.size());
+        }
+
+        ++stats.truth_markers;
+        if(best_error < MAX_CORNER_ERROR)
+        {
+            ++stats.matched_markers;
+            stats.corner_error += best_error;
+        }
+    }
+}
+
+/** @brief Get the time between two points in milliseconds
+ *
+ * @param from [in] Earlier point in time
+ * @param to [in] Later point in time
+ * @return Milliseconds from the first point to the second
+ */
+static double milliseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+/** @brief Get the name of a load shedding level
+ *
+ * @param level [in] Load shedding level
+ * @return One of CameraSystemVars::LOAD_LEVELS
+ */
+static const char* level_name(LoadShedder::Level level)
+{
+    return CameraSystemVars::LOAD_LEVELS[static_cast<std::size_t>(level)];
+}
+
+/** @brief Get the amount of detect stage threads a camera should have
+ *
+ * @param name [in] Name of the camera within the program state
+ * @param state [in] Current program state
+ * @return Amount of threads, at least 1
+ */
+static int detect_thread_count(const std::string& name, const StateVariables& state)
+{
+    const CameraSystem* camera_system = state.find_camera(name);
+    return camera_system ? std::max(camera_system->detect_threads, 1) : 1;
+}
+
+/** @brief Check if anything a camera's detector is created from has changed
+ *
+ * @param before [in] Camera system the detector was created from
+ * @param after [in] Current camera system
+ * @return True if the detector has to be recreated
+ */
+static bool detector_changed(const CameraSystem& before, const CameraSystem& after)
+{
+    return before.marker_dictionary != after.marker_dictionary ||
+           before.camera_matrix.data != after.camera_matrix.data ||
+           before.detect_tile_size != after.detect_tile_size ||
+           before.detect_tile_overlap != after.detect_tile_overlap ||
+           before.detect_pyramid_levels != after.detect_pyramid_levels ||
+           before.detector_threshold_win_min != after.detector_threshold_win_min ||
+           before.detector_threshold_win_max != after.detector_threshold_win_max ||
+           before.detector_threshold_win_step != after.detector_threshold_win_step ||
+           before.detector_threshold_constant != after.detector_threshold_constant ||
+           before.detector_corner_refinement != after.detector_corner_refinement ||
+           before.detector_min_perimeter_rate != after.detector_min_perimeter_rate ||
+           before.detector_max_perimeter_rate != after.detector_max_perimeter_rate;
+}
+
+/** @brief Create a detector for a camera
+ *
+ * @param calib [in] Calibration of the camera
+ * @param camera_system [in] The camera's system
+ * @param robots [in] Robots whose markers are the only ones looked for, along with the arena's
+ * @param tile_pool [in] Pool for tiled detection
+ * @return The new detector
+ */
+static std::shared_ptr<const MarkerDetector> make_detector(const CameraCalib& calib, const CameraSystem& camera_system,
+                                                           const RobotSystem& robots, WorkStealingPool& tile_pool)
+{
+    auto parameters = cv::aruco::DetectorParameters::create();
+    parameters->adaptiveThreshWinSizeMin = camera_system.detector_threshold_win_min;
+    // ArUco asserts that the largest window isn't smaller than the smallest one
+    parameters->adaptiveThreshWinSizeMax = std::max(camera_system.detector_threshold_win_max,
+                                                    camera_system.detector_threshold_win_min);
+    parameters->adaptiveThreshWinSizeStep = camera_system.detector_threshold_win_step;
+    parameters->adaptiveThreshConstant = camera_system.detector_threshold_constant;
+    parameters->minMarkerPerimeterRate = camera_system.detector_min_perimeter_rate;
+    parameters->maxMarkerPerimeterRate = camera_system.detector_max_perimeter_rate;
+    if(camera_system.detector_corner_refinement == CameraSystemVars::CORNER_REFINEMENT_SUBPIX)
+        parameters->cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
+    else if(camera_system.detector_corner_refinement == CameraSystemVars::CORNER_REFINEMENT_CONTOUR)
+        parameters->cornerRefinementMethod = cv::aruco::CORNER_REFINE_CONTOUR;
+    else
+        parameters->cornerRefinementMethod = cv::aruco::CORNER_REFINE_NONE;
+
+    MarkerDetector::Tiling tiling;
+    tiling.size = camera_system.detect_tile_size;
+    tiling.overlap = camera_system.detect_tile_overlap;
+    tiling.pool = &tile_pool;
+    return std::make_shared<const MarkerDetector>(calib, camera_system.marker_dictionary, parameters, tiling,
+                                                  camera_system.detect_pyramid_levels,
+                                                  MarkerDetector::restricted_ids(robots));
+}
+
+CameraWorker::CameraWorker(std::string name, std::shared_ptr<const StateVariables> state, DetectionFusion& fusion,
+                           WorkStealingPool& tile_pool, DisplayBoard& display, std::unique_ptr<CameraWrapper> camera) :
+        m_name(std::move(name)),
+        m_fusion(fusion),
+        m_tile_pool(tile_pool),
+        m_display(display),
+        m_detect_threads(detect_thread_count(m_name, *state)),
+        m_camera(std::move(camera)),
+        m_preprocess_queue(STAGE_QUEUE_DEPTH),
+        m_detect_queue(STAGE_QUEUE_DEPTH),
+        m_pose_queue(STAGE_QUEUE_DEPTH),
+        m_display_queue(1)
+{
+    m_detect_running = m_detect_threads;
+    m_threads.emplace_back(&CameraWorker::capture_stage, this, std::move(state));
+    m_threads.emplace_back(&CameraWorker::preprocess_stage, this);
+    for(int i = 0; i < m_detect_threads; ++i)
+        m_threads.emplace_back(&CameraWorker::detect_stage, this);
+    m_threads.emplace_back(&CameraWorker::pose_stage, this);
+    m_threads.emplace_back(&CameraWorker::display_stage, this);
+}
+
+CameraWorker::~CameraWorker()
+{
+    join();
+}
+
+const std::string& CameraWorker::get_name() const { return m_name; }
+bool CameraWorker::is_running() const { return m_running; }
+
+CameraStatus CameraWorker::get_status() const
+{
+    CameraStatus status;
+    status.load_level = level_name(m_shedder.level());
+    status.latency = m_latency;
+    return status;
+}
+
+void CameraWorker::update_state(const StateVariables& state)
+{
+    update_state(std::make_shared<const StateVariables>(state));
+}
+
+void CameraWorker::update_state(std::shared_ptr<const StateVariables> state)
+{
+    std::scoped_lock<std::mutex> lock(m_state_mutex);
+    m_pending_state = std::move(state);
+}
+
+std::unique_ptr<CameraWrapper> CameraWorker::release_camera()
+{
+    join();
+    m_preprocess_queue.clear();
+    m_detect_queue.clear();
+    m_pose_queue.clear();
+    m_display_queue.clear();
+    if(!m_camera || m_camera_failed)
+        return nullptr;
+
+    // Nothing reads the camera until it's given to the next worker, so don't keep filling the capture thread's ring
+    (*m_camera)->stop_capture();
+    return std::move(m_camera);
+}
+
+void CameraWorker::stop()
+{
+    m_running = false;
+    m_preprocess_queue.close();
+    m_detect_queue.close();
+    m_pose_queue.close();
+    m_display_queue.close();
+}
+
+void CameraWorker::join()
+{
+    stop();
+    for(auto& thread : m_threads)
+    {
+        if(thread.joinable())
+            thread.join();
+    }
+}
+
+void CameraWorker::capture_stage(std::shared_ptr<const StateVariables> state)
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::CAPTURE);
+    try
+    {
+        // A camera handed over from an earlier worker is already connected and only needs the current state
+        if(m_camera)
+            m_camera->update_state(*state);
+        else
+            m_camera = std::make_unique<CameraWrapper>(m_name, *state);
+        CameraWrapper& camera = *m_camera;
+        const CameraSystem* camera_system = state->find_camera(m_name);
+        auto detector = make_detector(camera->get_camera_calib(), *camera_system, state->robot, m_tile_pool);
+        // Copies of the camera and robot systems as the detector was created from
+        CameraSystem detector_system = *camera_system;
+        RobotSystem detector_robots = state->robot;
+        m_display_rate = camera_system->display_rate;
+        m_shedder.set_budget(camera_system->latency_budget);
+
+        std::uint64_t sequence = 0;
+        // Frames taken from the camera while skipping frames
+        std::uint64_t skip_counter = 0;
+        std::vector<cv::Point2f> roi_points;
+        auto stats_start = std::chrono::steady_clock::now();
+        std::uint64_t stats_allocations = 0;
+        while(m_running)
+        {
+            // Apply any state changes handed over by the manager
+            std::shared_ptr<const StateVariables> pending;
+            {
+                std::scoped_lock<std::mutex> lock(m_state_mutex);
+                pending = std::move(m_pending_state);
+            }
+            if(pending)
+            {
+                state = std::move(pending);
+                camera.update_state(*state);
+                camera_system = state->find_camera(m_name);
+                m_display_rate = camera_system->display_rate;
+                m_shedder.set_budget(camera_system->latency_budget);
+                // The detector holds a copy of the calibration and its settings, so it has to be recreated when any of
+                // them change, including the robots whose markers it looks for. Frames already in the pipeline keep using
+                // the detector they were captured with
+                if(detector_robots != state->robot || detector_changed(detector_system, *camera_system))
+                {
+                    detector_system = *camera_system;
+                    detector_robots = state->robot;
+                    detector = make_detector(camera->get_camera_calib(), detector_system, detector_robots,
+                                             m_tile_pool);
+                }
+            }
+
+            // Keep the sensor region on the arena corners that were found in the last processed frames
+            bool fit_roi = false;
+            {
+                std::scoped_lock<std::mutex> lock(m_roi_mutex);
+                if(m_roi_pending)
+                {
+                    roi_points.swap(m_roi_points);
+                    m_roi_pending = false;
+                    fit_roi = true;
+                }
+            }
+            if(fit_roi)
+                camera->fit_roi(roi_points);
+
+            // Frame buffers should only be allocated while the camera is starting up, see FramePool
+            const auto now = std::chrono::steady_clock::now();
+            if(now - stats_start >= STATS_INTERVAL)
+            {
+                const std::uint64_t allocations = camera->frame_allocations() + m_gray_pool.allocations();
+                if(allocations > stats_allocations)
+                    spdlog::info("Camera '{}' allocated {} frame buffers", m_name, allocations - stats_allocations);
+                stats_allocations = allocations;
+                stats_start = now;
+            }
+
+            if(!camera->is_connected())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+
+            Job job;
+            if(!camera->get_frame(job.frame))
+            {
+                // Don't spin if the camera is failing to produce frames (i.e. the end of a video file was reached),
+                // the capture thread may be running with real-time priority
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Shed as much work as the pose stage asks for. Skipped frames don't get a sequence number, so the pose
+            // stage doesn't wait for them
+            const LoadShedder::Level level = m_shedder.level();
+            if(level >= LoadShedder::Level::SKIP_FRAMES && skip_counter++ % 2 == 1)
+                continue;
+            // Only search around where the markers should be, if the camera tracks them or has to shed load
+            int tracking_frames = camera_system->tracking_frames;
+            if(tracking_frames == 0 && level >= LoadShedder::Level::ROI_ONLY)
+                tracking_frames = SHED_TRACKING_FRAMES;
+            m_tracker.plan(job.frame, tracking_frames, job.regions);
+            job.downscale = level >= LoadShedder::Level::LOW_RESOLUTION;
+
+            job.frame.sequence = sequence++;
+            job.detector = detector;
+
+            // Waits while the rest of the pipeline is behind
+            if(!m_preprocess_queue.push(job))
+                break;
+        }
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in camera '{}' capture stage: \n{}", m_name, e.what());
+        m_camera_failed = true;
+        stop();
+    }
+
+    m_preprocess_queue.close();
+}
+
+void CameraWorker::preprocess_stage()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::DETECT);
+    try
+    {
+        Job job;
+        while(m_preprocess_queue.pop(job))
+        {
+            // Mono frames are detected on directly, everything else is converted into a pooled buffer
+            if(job.frame.format == PixelFormat::MONO8)
+            {
+                job.gray = job.frame;
+            }
+            else
+            {
+                // Buffers are held by the detect queue and the detect threads, and one is being converted into
+                m_gray_pool.acquire(job.gray, job.frame.image.size(), CV_8UC1,
+                                    STAGE_QUEUE_DEPTH + m_detect_threads + 1);
+                uchar* const data = job.gray.image.data;
+                job.frame.gray(job.gray.image);
+                if(job.gray.image.data != data)
+                    job.gray.owner.reset();
+                job.gray.format = PixelFormat::MONO8;
+            }
+
+            job.preprocessed = std::chrono::steady_clock::now();
+            if(!m_detect_queue.push(job))
+                break;
+        }
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in camera '{}' preprocess stage: \n{}", m_name, e.what());
+        stop();
+    }
+
+    m_detect_queue.close();
+}
+
+void CameraWorker::detect_stage()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::DETECT);
+    try
+    {
+        Job job;
+        // Results of a single region, the downscaled image and the region covering the whole frame, reused between
+        // frames
+        std::vector<std::vector<cv::Point2f>> region_corners;
+        std::vector<int> region_ids;
+        cv::Mat downscaled;
+        std::vector<cv::Rect> whole_frame(1);
+        while(m_detect_queue.pop(job))
+        {
+            if(job.regions.empty() && !job.downscale)
+            {
+                job.detector->find(job.gray.image, job.corners, job.ids);
+            }
+            else
+            {
+                // Search each region on its own and move what was found back into image coordinates. The job's
+                // regions stay empty for a whole frame, since that's how the pose stage tells it was a full scan
+                whole_frame[0] = cv::Rect(cv::Point(), job.gray.image.size());
+                const std::vector<cv::Rect>& regions = job.regions.empty() ? whole_frame : job.regions;
+                job.corners.clear();
+                job.ids.clear();
+                for(const auto& region : regions)
+                {
+                    cv::Mat search = job.gray.image(region);
+                    float scale = 1;
+                    float shift = 0;
+                    if(job.downscale)
+                    {
+                        cv::resize(search, downscaled, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+                        search = downscaled;
+                        // Each downscaled pixel covers two pixels, so its center lies between theirs
+                        scale = 2;
+                        shift = 0.5f;
+                    }
+
+                    job.detector->find(search, region_corners, region_ids);
+                    for(auto& marker : region_corners)
+                    {
+                        for(auto& corner : marker)
+                            corner = corner * scale + cv::Point2f(region.x + shift, region.y + shift);
+                    }
+                    job.corners.insert(job.corners.end(), region_corners.begin(), region_corners.end());
+                    job.ids.insert(job.ids.end(), region_ids.begin(), region_ids.end());
+                }
+            }
+            // The grayscale plane isn't needed anymore, so give its buffer back early
+            job.gray.release();
+            job.detected = std::chrono::steady_clock::now();
+
+            if(!m_pose_queue.push(job))
+                break;
+        }
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in camera '{}' detect stage: \n{}", m_name, e.what());
+        stop();
+    }
+
+    if(--m_detect_running == 0)
+        m_pose_queue.close();
+}
+
+void CameraWorker::pose_stage()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::DETECT);
+    try
+    {
+        // The detect threads can finish frames out of order, so frames wait here until it's their turn
+        std::map<std::uint64_t, Job> waiting;
+        std::uint64_t next_sequence = 0;
+        WorkerStats stats;
+        auto stats_start = std::chrono::steady_clock::now();
+        auto next_display = stats_start;
+        // Last known corners of each arena corner marker, so that a corner that is missed for a few frames doesn't
+        // get cut off by the sensor region
+        std::array<std::vector<cv::Point2f>, ARENA_MARKER_COUNT> arena_corners;
+
+        Job job;
+        while(m_pose_queue.pop(job))
+        {
+            const std::uint64_t sequence = job.frame.sequence;
+            waiting.emplace(sequence, std::move(job));
+
+            for(auto it = waiting.find(next_sequence); it != waiting.end(); it = waiting.find(++next_sequence))
+            {
+                Job& next = it->second;
+
+                Detections detections;
+                detections.camera = m_name;
+                detections.timestamp = next.frame.timestamp;
+                detections.device_timestamp = next.frame.device_timestamp;
+                detections.sequence = next.frame.sequence;
+                detections.markers = next.detector->estimate(next.corners, next.ids, next.frame.offset);
+                m_tracker.update(detections.markers, next.frame.timestamp, next.regions.empty());
+                const auto now = std::chrono::steady_clock::now();
+
+                // Let the shedder know how far behind the pipeline is
+                const double latency = milliseconds(next.frame.timestamp, now);
+                const double queue_fill =
+                        static_cast<double>(m_preprocess_queue.size() + m_detect_queue.size() + m_pose_queue.size()) /
+                        (m_preprocess_queue.capacity() + m_detect_queue.capacity() + m_pose_queue.capacity());
+                if(m_shedder.record(latency, queue_fill, now))
+                {
+                    spdlog::warn("Camera '{}' changed to load level '{}' at {:.1f}ms latency", m_name,
+                                 level_name(m_shedder.level()), latency);
+                }
+
+                ++stats.frames;
+                stats.preprocess_latency += milliseconds(next.frame.timestamp, next.preprocessed);
+                stats.detect_latency += milliseconds(next.frame.timestamp, next.detected);
+                stats.latency += latency;
+                if(next.frame.ground_truth)
+                    score_detections(*next.frame.ground_truth, detections.markers, stats);
+                if(now - stats_start >= STATS_INTERVAL)
+                {
+                    const double seconds = std::chrono::duration<double>(now - stats_start).count();
+                    m_latency = stats.latency / stats.frames;
+                    spdlog::info("Camera '{}': {:.1f} fps, {:.1f}ms latency (preprocessed after {:.1f}ms, detected "
+                                 "after {:.1f}ms), load level '{}'", m_name, stats.frames / seconds,
+                                 stats.latency / stats.frames, stats.preprocess_latency / stats.frames,
+                                 stats.detect_latency / stats.frames, level_name(m_shedder.level()));
+                    if(stats.truth_markers > 0)
+                    {
+                        spdlog::info("Camera '{}': detected {}/{} known markers ({:.1f}%), mean corner error {:.2f}px",
+                                     m_name, stats.matched_markers, stats.truth_markers,
+                                     100.0 * stats.matched_markers / stats.truth_markers,
+                                     stats.matched_markers > 0 ? stats.corner_error / stats.matched_markers : 0.0);
+                    }
+                    stats = WorkerStats();
+                    stats_start = now;
+                }
+
+                // Hand the arena's corners to the capture stage for the camera's sensor region. Robots don't count, or the
+                // region would follow them around the arena. If no corner was found at all, the arena was lost and an
+                // empty set of points lets the camera go back to its full region
+                bool found_corner = false;
+                for(const auto& marker : detections.markers)
+                {
+                    if(marker.id >= 0 && marker.id < ARENA_MARKER_COUNT)
+                    {
+                        arena_corners[marker.id] = marker.corners;
+                        found_corner = true;
+                    }
+                }
+                {
+                    std::scoped_lock<std::mutex> lock(m_roi_mutex);
+                    m_roi_points.clear();
+                    if(found_corner)
+                    {
+                        for(const auto& corners : arena_corners)
+                            m_roi_points.insert(m_roi_points.end(), corners.begin(), corners.end());
+                    }
+                    m_roi_pending = true;
+                }
+
+                // Only draw a display frame if it's time for one and the last one was shown, since the BGR conversion
+                // isn't free
+                const double display_rate = m_display_rate;
+                if(display_rate > 0 && now >= next_display && m_display.wants_frame(m_name))
+                {
+                    next_display = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(1.0 / display_rate));
+                    DisplayJob display{std::move(next.frame), next.detector, detections.markers};
+                    m_display_queue.try_push(display);
+                }
+
+                waiting.erase(it);
+                m_fusion.submit(std::move(detections));
+            }
+        }
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in camera '{}' pose stage: \n{}", m_name, e.what());
+        stop();
+    }
+
+    m_display_queue.close();
+}
+
+void CameraWorker::display_stage()
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::HOUSEKEEPING);
+    try
+    {
+        DisplayJob job;
+        cv::Mat bgr_frame, draw_frame, display_frame;
+        while(m_display_queue.pop(job))
+        {
+            // Draw onto a copy so that the frame itself isn't changed. The copy and the scaled display frame reuse
+            // their memory from the last time
+            job.frame.bgr(bgr_frame).copyTo(draw_frame);
+            job.detector->draw(draw_frame, job.markers, job.frame.offset);
+            cv::resize(draw_frame, display_frame, DISPLAY_SIZE);
+            job = DisplayJob();
+
+            m_display.post(m_name, display_frame);
+        }
+    }
+    catch(std::exception& e)
+    {
+        spdlog::critical("Exception in camera '{}' display stage: \n{}", m_name, e.what());
+        stop();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#ifndef MELON_CAMERAWORKER_H
+#define MELON_CAMERAWORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+#include "../cmdhandler/statevariables.h"
+#include "../camera/camerawrapper.h"
+#include "../camera/framepool.h"
+#include "../detectors/markerdetector.h"
+#include "../detectors/markertracker.h"
+#include "../detectors/marker.h"
+#include "boundedqueue.h"
+#include "detectionfusion.h"
+#include "displayboard.h"
+#include "loadshedder.h"
+#include "workstealingpool.h"
+
+/** @brief Capture and detection pipeline for a single camera
+ *
+ * Each worker owns one camera, its calibration and its own MarkerDetector. Frames go through a chain of stages, each
+ * running on its own thread(s) and connected by bounded queues:
+ * - Capture: takes frames from the camera, numbers them and applies state changes. With CameraSystem::tracking_frames,
+ *   a MarkerTracker picks the windows of each frame that are searched
+ * - Preprocess: converts frames to grayscale
+ * - Detect: finds the markers, on CameraSystem::detect_threads threads. Large frames can additionally be split into
+ *   tiles that are searched on a pool shared by all workers
+ * - Pose: puts the frames back in order, estimates the marker poses and submits them to the DetectionFusion, which
+ *   hands them to the publishing thread
+ * - Display: draws the markers for display and posts them to the DisplayBoard, at most CameraSystem::display_rate
+ *   times per second and only when the last display frame was taken
+ *
+ * So detection of one frame overlaps capturing the next one and publishing the previous one. A full queue blocks the
+ * stage before it, so a slow stage makes capture fall behind, which leaves it to the camera's capture policy to drop or
+ * hold frames. <br>
+ * With a CameraSystem::latency_budget, a LoadShedder watches the latency and the queues and makes the stages skip work
+ * when they can't keep up, see CameraWorker::get_status(). <br>
+ * Workers don't share anything besides the DetectionFusion they submit to, so several cameras can be processed in
+ * parallel. The camera is only ever touched by the capture stage; state changes given through
+ * CameraWorker::update_state() are handed to that thread and applied before the next frame. <br>
+ * CameraWorker::release_camera() stops the pipeline but keeps the camera connected, so that a new worker can pick it up
+ * again without reconnecting it
+ */
+class CameraWorker : public UpdateableState
+{
+public:
+    /** @brief Create a new worker and start its threads
+     *
+     * @param name [in] Name of the camera within the program state
+     * @param state [in] Snapshot of the current program state
+     * @param fusion [in] Fusion stage that detections are submitted to. Must outlive the worker
+     * @param tile_pool [in] Pool for tiled detection. Must outlive the worker
+     * @param display [in] Board that display frames are posted to. Must outlive the worker
+     * @param camera [in] Connected camera to use, see CameraWorker::release_camera(). If null, the camera is created
+     *                    and connected by the capture stage
+     */
+    CameraWorker(std::string name, std::shared_ptr<const StateVariables> state, DetectionFusion& fusion,
+                 WorkStealingPool& tile_pool, DisplayBoard& display, std::unique_ptr<CameraWrapper> camera = nullptr);
+    CameraWorker(const CameraWorker& other) = delete;
+    ~CameraWorker();
+
+    /** @brief Get the name of the worker's camera
+     *
+     * @return Name of the camera within the program state
+     */
+    const std::string& get_name() const;
+
+    /** @brief Are the worker's threads still running
+     *
+     * @return False if the worker's pipeline stopped because of an error
+     */
+    bool is_running() const;
+
+    /** @brief Get the status of the worker's pipeline
+     *
+     * @return Load shedding level and recent latency
+     */
+    CameraStatus get_status() const;
+
+    /** @brief Hand a new program state to the worker's capture stage
+     *
+     * @param state [in] State to update from
+     */
+    void update_state(const StateVariables& state) override;
+
+    /** @brief Hand a new snapshot of the program state to the worker's capture stage
+     *
+     * Same as CameraWorker::update_state(const StateVariables&), but without copying the state
+     *
+     * @param state [in] Snapshot to update from, see GlobalState::snapshot()
+     */
+    void update_state(std::shared_ptr<const StateVariables> state);
+
+    /** @brief Stop the pipeline and take the camera out of the worker
+     *
+     * This waits for every stage to finish and throws away the frames still in the queues, so that all of the camera's
+     * buffers are given back to it. The camera's capture thread is stopped, but the camera stays connected. The worker
+     * can't be started again afterwards
+     *
+     * @return The camera, or null if it was never created or the capture stage failed
+     */
+    std::unique_ptr<CameraWrapper> release_camera();
+
+private:
+    /** @brief A frame on its way through the stages
+     *
+     */
+    struct Job
+    {
+        Frame frame;
+        // Grayscale plane of the frame. Shares the frame's buffer if it's already grayscale
+        Frame gray;
+        // Detector as it was configured when the frame was captured
+        std::shared_ptr<const MarkerDetector> detector;
+        // Regions of the frame to search, in image coordinates. Empty searches the whole frame
+        std::vector<cv::Rect> regions;
+        // Search at half resolution
+        bool downscale = false;
+        std::vector<std::vector<cv::Point2f>> corners;
+        std::vector<int> ids;
+        // When the preprocess and detect stages were done with the frame
+        std::chrono::steady_clock::time_point preprocessed;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    /** @brief A processed frame waiting to be drawn for display
+     *
+     */
+    struct DisplayJob
+    {
+        Frame frame;
+        std::shared_ptr<const MarkerDetector> detector;
+        std::vector<Marker> markers;
+    };
+
+    /** @brief Callback function for the capture stage's thread
+     *
+     * @param state [in] Snapshot of the program state to create the camera from
+     */
+    void capture_stage(std::shared_ptr<const StateVariables> state);
+
+    /** @brief Callback function for the preprocess stage's thread
+     *
+     */
+    void preprocess_stage();
+
+    /** @brief Callback function for the detect stage's threads
+     *
+     */
+    void detect_stage();
+
+    /** @brief Callback function for the pose stage's thread
+     *
+     */
+    void pose_stage();
+
+    /** @brief Callback function for the display stage's thread
+     *
+     */
+    void display_stage();
+
+    /** @brief Stop every stage
+     *
+     * This closes all of the queues so that no stage stays blocked. Frames still in the queues are thrown away
+     */
+    void stop();
+
+    /** @brief Stop every stage and wait for their threads to finish
+     *
+     */
+    void join();
+
+    const std::string m_name;
+    DetectionFusion& m_fusion;
+    WorkStealingPool& m_tile_pool;
+    DisplayBoard& m_display;
+    const int m_detect_threads;
+
+    // Created by the capture stage unless one was given. Declared before the queues so that it outlives the frames
+    // in them
+    std::unique_ptr<CameraWrapper> m_camera;
+    // Set when the capture stage failed, since the camera may be broken then
+    std::atomic_bool m_camera_failed {false};
+
+    // State waiting to be applied by the capture stage
+    std::mutex m_state_mutex;
+    std::shared_ptr<const StateVariables> m_pending_state;
+
+    // Arena corner marker corners of the last processed frames, waiting to be given to the camera by the capture stage
+    std::mutex m_roi_mutex;
+    std::vector<cv::Point2f> m_roi_points;
+    bool m_roi_pending {false};
+
+    // Display frames per second, see CameraSystem::display_rate. Set by the capture stage
+    std::atomic<double> m_display_rate {0};
+
+    // Budget set by the capture stage, latencies recorded by the pose stage
+    LoadShedder m_shedder;
+    // Mean latency of the frames in the last statistics interval, in milliseconds
+    std::atomic<double> m_latency {0};
+
+    // Planned by the capture stage, given the results by the pose stage
+    MarkerTracker m_tracker;
+
+    // Buffers for the grayscale conversions of the preprocess stage
+    FramePool m_gray_pool;
+
+    BoundedQueue<Job> m_preprocess_queue;
+    BoundedQueue<Job> m_detect_queue;
+    BoundedQueue<Job> m_pose_queue;
+    BoundedQueue<DisplayJob> m_display_queue;
+    // Detect stage threads that haven't finished yet. The last one closes the pose queue
+    std::atomic_int m_detect_running {0};
+
+    std::atomic_bool m_running {true};
+    std::vector<std::thread> m_threads;
+};
+
+#endif //MELON_CAMERAWORKER_H
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "detectionfusion.h"
+#include <algorithm>
+
+DetectionFusion::DetectionFusion(std::chrono::milliseconds max_wait, std::chrono::milliseconds tolerance) :
+        m_max_wait(max_wait),
+        m_tolerance(tolerance)
+{
+}
+
+void DetectionFusion::set_cameras(const std::vector<std::string>& cameras)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_cameras = cameras;
+        // Don't keep detections from cameras that were removed
+        for(auto it = m_group.begin(); it != m_group.end();)
+        {
+            if(std::find(m_cameras.begin(), m_cameras.end(), it->first) == m_cameras.end())
+                it = m_group.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    m_cond_var.notify_all();
+}
+
+void DetectionFusion::submit(Detections detections)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if(!m_group.empty())
+        {
+            // The group is already out, or about to be, so these can't be fused with anything anymore
+            if(detections.timestamp < m_group_timestamp - m_tolerance)
+                return;
+            // Captured after everything in the group, so no more detections for the group are coming from this camera
+            if(detections.timestamp > m_group_timestamp + m_tolerance)
+                complete_group();
+        }
+        if(m_group.empty())
+        {
+            m_group_start = std::chrono::steady_clock::now();
+            m_group_timestamp = detections.timestamp;
+        }
+        std::string camera = detections.camera;
+        m_group[camera] = std::move(detections);
+    }
+
+    m_cond_var.notify_all();
+}
+
+bool DetectionFusion::pop(std::vector<Detections>& fused, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_closed && m_completed.empty() && !group_ready())
+    {
+        // Wake up when the current group times out, if that comes before the caller's deadline
+        auto wake = deadline;
+        if(!m_group.empty())
+            wake = std::min(wake, m_group_start + m_max_wait);
+        if(m_cond_var.wait_until(lock, wake) == std::cv_status::timeout && std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+
+    if(m_closed)
+        return false;
+    if(m_completed.empty())
+    {
+        if(!group_ready())
+            return false;
+        complete_group();
+    }
+
+    fused = std::move(m_completed.front());
+    m_completed.pop_front();
+    return true;
+}
+
+void DetectionFusion::complete_group()
+{
+    std::vector<Detections> fused;
+    fused.reserve(m_group.size());
+    for(auto& pair : m_group)
+        fused.push_back(std::move(pair.second));
+    m_group.clear();
+
+    std::sort(fused.begin(), fused.end(),
+              [](const Detections& a, const Detections& b) { return a.camera < b.camera; });
+    m_completed.push_back(std::move(fused));
+}
+
+void DetectionFusion::close()
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+
+    m_cond_var.notify_all();
+}
+
+bool DetectionFusion::is_closed()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    return m_closed;
+}
+
+bool DetectionFusion::group_ready() const
+{
+    if(m_group.empty())
+        return false;
+    if(m_group.size() >= m_cameras.size())
+        return true;
+    return std::chrono::steady_clock::now() - m_group_start >= m_max_wait;
+}
\ No newline at end of file
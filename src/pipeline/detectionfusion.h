@@ -0,0 +1,96 @@
+#ifndef MELON_DETECTIONFUSION_H
+#define MELON_DETECTIONFUSION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../detectors/detections.h"
+
+/** @brief Groups the detections of several cameras into a single output
+ *
+ * Each camera's worker submits its detections as soon as a frame is processed. Detections are grouped by when their
+ * frames were captured (Detections::timestamp), not by when they arrive: a group holds the detections captured within
+ * the tolerance of its first detections. It is handed out through DetectionFusion::pop() as one fused output once
+ * every camera has submitted, once the first detections have waited for the maximum wait time, or as soon as
+ * detections captured after the tolerance arrive, which start the next group. <br>
+ * If a camera submits again within the same group, its older detections are replaced so that a fast camera can't hold
+ * up the group with stale data. Detections captured before the current group are too late to be fused and are dropped
+ */
+class DetectionFusion
+{
+public:
+    /** @brief Create a new instance
+     *
+     * @param max_wait [in] Maximum amount of time to wait for slower cameras before a group is handed out anyways
+     * @param tolerance [in] Furthest apart the capture times of detections in the same group can be
+     */
+    DetectionFusion(std::chrono::milliseconds max_wait, std::chrono::milliseconds tolerance);
+    DetectionFusion(const DetectionFusion& other) = delete;
+
+    /** @brief Set the cameras that each group should wait for
+     *
+     * @param cameras [in] Names of the cameras
+     */
+    void set_cameras(const std::vector<std::string>& cameras);
+
+    /** @brief Add the detections from a camera to the current group
+     *
+     * @param detections [in] Detections to add
+     */
+    void submit(Detections detections);
+
+    /** @brief Take the next complete group, waiting for one if necessary
+     *
+     * @param fused [out] Detections of each camera in the group, sorted by camera name
+     * @param timeout [in] Maximum amount of time to wait
+     * @return True if a group was taken, false if the timeout was reached or the fusion was closed
+     */
+    bool pop(std::vector<Detections>& fused, std::chrono::milliseconds timeout);
+
+    /** @brief Close the fusion
+     *
+     * This wakes up any thread that is waiting in DetectionFusion::pop()
+     */
+    void close();
+
+    /** @brief Has the fusion been closed
+     *
+     * @return True if DetectionFusion::close() has been called
+     */
+    bool is_closed();
+
+private:
+    /** @brief Is the current group ready to be handed out
+     *
+     * @note m_mutex must be held
+     *
+     * @return True if every camera has submitted or the group has waited for the maximum wait time
+     */
+    bool group_ready() const;
+
+    /** @brief Hand out the current group as is, and start a new one
+     *
+     * @note m_mutex must be held
+     */
+    void complete_group();
+
+    const std::chrono::milliseconds m_max_wait;
+    const std::chrono::milliseconds m_tolerance;
+    std::vector<std::string> m_cameras;
+    std::unordered_map<std::string, Detections> m_group;
+    // When the current group's first detections arrived, and when their frame was captured
+    std::chrono::steady_clock::time_point m_group_start;
+    std::chrono::steady_clock::time_point m_group_timestamp;
+    // Groups that were completed by newer detections arriving, oldest first
+    std::deque<std::vector<Detections>> m_completed;
+    bool m_closed {false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond_var;
+};
+
+#endif //MELON_DETECTIONFUSION_H
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "displayboard.h"
+#include <algorithm>
+
+bool DisplayBoard::wants_frame(const std::string& camera)
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    auto it = m_slots.find(camera);
+    return !m_closed && (it == m_slots.end() || !it->second.fresh);
+}
+
+void DisplayBoard::post(const std::string& camera, cv::Mat& frame)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        Slot& slot = m_slots[camera];
+        cv::swap(slot.frame, frame);
+        slot.fresh = true;
+        // A camera that was removed and came back shouldn't have its new window destroyed
+        m_removed.erase(std::remove(m_removed.begin(), m_removed.end(), camera), m_removed.end());
+    }
+
+    m_cond_var.notify_all();
+}
+
+void DisplayBoard::remove(const std::string& camera)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if(m_slots.erase(camera) == 0)
+            return;
+        m_removed.push_back(camera);
+    }
+
+    m_cond_var.notify_all();
+}
+
+bool DisplayBoard::has_news() const
+{
+    if(!m_removed.empty())
+        return true;
+    return std::any_of(m_slots.begin(), m_slots.end(), [](const auto& pair){ return pair.second.fresh; });
+}
+
+bool DisplayBoard::take(std::vector<std::pair<std::string, cv::Mat>>& frames, std::vector<std::string>& removed,
+                        std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(!m_cond_var.wait_for(lock, timeout, [this]{ return m_closed || has_news(); }) || m_closed)
+        return false;
+
+    frames.clear();
+    for(auto& pair : m_slots)
+    {
+        if(pair.second.fresh)
+        {
+            frames.emplace_back(pair.first, pair.second.frame);
+            pair.second.fresh = false;
+        }
+    }
+    removed.swap(m_removed);
+    m_removed.clear();
+    return true;
+}
+
+void DisplayBoard::close()
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+
+    m_cond_var.notify_all();
+}
+
+bool DisplayBoard::is_closed()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    return m_closed;
+}
\ No newline at end of file
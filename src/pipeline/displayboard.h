@@ -0,0 +1,96 @@
+#ifndef MELON_DISPLAYBOARD_H
+#define MELON_DISPLAYBOARD_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+
+/** @brief Hands display frames from the camera workers to the display thread
+ *
+ * Every camera has a single slot holding its latest display frame. Workers only draw a new frame once the display
+ * thread has taken the last one (see DisplayBoard::wants_frame()), so a slow or missing display never holds up
+ * processing. Nothing here touches OpenCV's GUI, that is left to whichever thread takes the frames
+ */
+class DisplayBoard
+{
+public:
+    DisplayBoard() = default;
+    DisplayBoard(const DisplayBoard& other) = delete;
+
+    /** @brief Has the last frame posted by a camera been taken
+     *
+     * @param camera [in] Name of the camera
+     * @return True if the camera should post a new frame
+     */
+    bool wants_frame(const std::string& camera);
+
+    /** @brief Post a new display frame for a camera
+     *
+     * The frame is swapped into the camera's slot, so the caller gets back the frame it posted before this one. That
+     * frame has already been taken and can be drawn into again
+     *
+     * @param camera [in] Name of the camera
+     * @param frame [in, out] Frame to post
+     */
+    void post(const std::string& camera, cv::Mat& frame);
+
+    /** @brief Remove a camera's slot, i.e. when its worker has been stopped
+     *
+     * @param camera [in] Name of the camera
+     */
+    void remove(const std::string& camera);
+
+    /** @brief Take every new frame, waiting for one if there are none
+     *
+     * @param frames [out] New frames by camera name
+     * @param removed [out] Cameras removed since the last call
+     * @param timeout [in] Maximum amount of time to wait
+     * @return True if there were new frames or removed cameras, false if the timeout was reached or the board was
+     *         closed
+     */
+    bool take(std::vector<std::pair<std::string, cv::Mat>>& frames, std::vector<std::string>& removed,
+              std::chrono::milliseconds timeout);
+
+    /** @brief Close the board
+     *
+     * This wakes up any thread that is waiting in DisplayBoard::take()
+     */
+    void close();
+
+    /** @brief Has the board been closed
+     *
+     * @return True if DisplayBoard::close() has been called
+     */
+    bool is_closed();
+
+private:
+    /** @brief Latest display frame of a camera
+     *
+     */
+    struct Slot
+    {
+        cv::Mat frame;
+        // Has the frame been posted but not taken yet
+        bool fresh = false;
+    };
+
+    /** @brief Is there anything for DisplayBoard::take() to hand out
+     *
+     * @note m_mutex must be held
+     */
+    bool has_news() const;
+
+    std::map<std::string, Slot> m_slots;
+    std::vector<std::string> m_removed;
+    bool m_closed {false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond_var;
+};
+
+#endif //MELON_DISPLAYBOARD_H
\ No newline at end of file
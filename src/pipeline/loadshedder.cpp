@@ -0,0 +1,63 @@
+#include "loadshedder.h"
+
+// Weight of each new frame in the smoothed latency and queue fill
+constexpr double SMOOTHING = 0.1;
+// The pipeline is comfortably within the budget below this fraction of it
+constexpr double CALM_FRACTION = 0.5;
+// Queues fuller than this count as backed up, emptier than the calm fill as keeping up
+constexpr double BACKED_UP_FILL = 0.75;
+constexpr double CALM_FILL = 0.25;
+// How long a change has to take effect before moving up another level
+constexpr std::chrono::milliseconds ESCALATE_HOLD(500);
+// How long the pipeline has to be calm before moving down a level
+constexpr std::chrono::seconds RECOVER_HOLD(3);
+
+void LoadShedder::set_budget(double budget) { m_budget = budget; }
+
+LoadShedder::Level LoadShedder::level() const { return m_level; }
+
+bool LoadShedder::record(double latency, double queue_fill, std::chrono::steady_clock::time_point now)
+{
+    if(!m_recorded)
+    {
+        m_latency = latency;
+        m_queue_fill = queue_fill;
+        m_last_change = now;
+        m_calm_since = now;
+        m_recorded = true;
+    }
+    else
+    {
+        m_latency += SMOOTHING * (latency - m_latency);
+        m_queue_fill += SMOOTHING * (queue_fill - m_queue_fill);
+    }
+
+    const Level level = m_level;
+    const double budget = m_budget;
+    if(budget <= 0)
+    {
+        m_level = Level::NONE;
+        return level != Level::NONE;
+    }
+
+    // Full queues mean the latency is about to grow, so don't wait for it once it's getting close
+    const bool overloaded = m_latency > budget ||
+                            (m_queue_fill > BACKED_UP_FILL && m_latency > budget * CALM_FRACTION);
+    const bool calm = m_latency < budget * CALM_FRACTION && m_queue_fill < CALM_FILL;
+    if(!calm)
+        m_calm_since = now;
+
+    Level next = level;
+    if(overloaded && level != Level::LOW_RESOLUTION && now - m_last_change >= ESCALATE_HOLD)
+        next = static_cast<Level>(static_cast<int>(level) + 1);
+    else if(calm && level != Level::NONE && now - m_calm_since >= RECOVER_HOLD && now - m_last_change >= RECOVER_HOLD)
+        next = static_cast<Level>(static_cast<int>(level) - 1);
+
+    if(next == level)
+        return false;
+
+    m_level = next;
+    m_last_change = now;
+    m_calm_since = now;
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef MELON_LOADSHEDDER_H
+#define MELON_LOADSHEDDER_H
+
+#include <atomic>
+#include <chrono>
+
+/** @brief Decides how much work a camera's pipeline skips to stay within its latency budget
+ *
+ * The pose stage records the latency of every frame and how full the queues between the stages were. Once the
+ * latency stays above the budget, or the queues stay full while the latency gets close to it, the shedder moves up a
+ * level. Once the latency stays well below the budget with empty queues, it moves back down. Each change waits for the
+ * previous one to take effect first, so the level doesn't flap between two of them. <br>
+ * The levels, each including the ones before it:
+ * - LoadShedder::Level::SKIP_FRAMES: only every other frame is processed
+ * - LoadShedder::Level::ROI_ONLY: only windows around where the markers are predicted to be are searched, with a
+ *   full search every so often to pick up new markers, see MarkerTracker
+ * - LoadShedder::Level::LOW_RESOLUTION: frames are searched at half resolution
+ *
+ * The budget and level can be used from any thread, LoadShedder::record() is only called by the pose stage
+ */
+class LoadShedder
+{
+public:
+    /** @brief How much work is skipped, in the same order as CameraSystemVars::LOAD_LEVELS
+     *
+     */
+    enum class Level
+    {
+        NONE,
+        SKIP_FRAMES,
+        ROI_ONLY,
+        LOW_RESOLUTION
+    };
+
+    /** @brief Set the latency budget
+     *
+     * @param budget [in] Longest a frame should take from capture to publishing, in milliseconds. 0 never sheds load
+     */
+    void set_budget(double budget);
+
+    /** @brief Record a processed frame and move to another level if necessary
+     *
+     * @param latency [in] Time from capture to publishing of the frame, in milliseconds
+     * @param queue_fill [in] How full the queues between the stages were, from 0 (empty) to 1 (full)
+     * @param now [in] Current time
+     * @return True if the level changed
+     */
+    bool record(double latency, double queue_fill, std::chrono::steady_clock::time_point now);
+
+    /** @brief Get the current level
+     *
+     * @return Current level
+     */
+    Level level() const;
+
+private:
+    std::atomic<double> m_budget {0};
+    std::atomic<Level> m_level {Level::NONE};
+
+    // Smoothed latency and queue fill of the recorded frames. Only used by the pose stage
+    double m_latency = 0;
+    double m_queue_fill = 0;
+    bool m_recorded = false;
+    // When the level last changed, and since when the pipeline has been comfortably within the budget
+    std::chrono::steady_clock::time_point m_last_change;
+    std::chrono::steady_clock::time_point m_calm_since;
+};
+
+#endif //MELON_LOADSHEDDER_H
@@ -0,0 +1,182 @@
+#include "threadplacement.h"
+#include <map>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+using NativeThread = pthread_t;
+#else
+using NativeThread = int;
+#endif
+
+/** @brief A registered thread
+ *
+ */
+struct RegisteredThread
+{
+    ThreadRole role;
+    NativeThread handle;
+};
+
+// Registered threads by id, and the configuration they're placed by. Only accessed while holding registry_mutex
+static std::mutex registry_mutex;
+static std::map<std::uint64_t, RegisteredThread> registry;
+static std::uint64_t next_id = 0;
+static ThreadSystem configuration;
+
+/** @brief Get the name of a role for log messages
+ *
+ * @param role [in] Role of a thread
+ * @return Name of the role
+ */
+static const char* role_name(ThreadRole role)
+{
+    switch(role)
+    {
+        case ThreadRole::CAPTURE:
+            return "capture";
+        case ThreadRole::DETECT:
+            return "detect";
+        case ThreadRole::PUBLISH:
+            return "publish";
+        case ThreadRole::HOUSEKEEPING:
+            return "housekeeping";
+    }
+    return "unknown";
+}
+
+#ifdef __linux__
+/** @brief Get the cores that threads may run on when they aren't pinned
+ *
+ * This is whatever the process was started with, so restrictions from i.e. taskset or cgroups are kept
+ *
+ * @note registry_mutex must be held
+ *
+ * @return Set of cores
+ */
+static const cpu_set_t& default_cores()
+{
+    static cpu_set_t cores;
+    static bool initialized = false;
+    if(!initialized)
+    {
+        CPU_ZERO(&cores);
+        sched_getaffinity(0, sizeof(cores), &cores);
+        initialized = true;
+    }
+    return cores;
+}
+
+/** @brief Place a thread according to the configuration
+ *
+ * @note registry_mutex must be held
+ *
+ * @param thread [in] Thread to place
+ * @param threads [in] Configuration to place it by
+ */
+static void place(const RegisteredThread& thread, const ThreadSystem& threads)
+{
+    const std::vector<int>* cores = nullptr;
+    switch(thread.role)
+    {
+        case ThreadRole::CAPTURE:
+            cores = &threads.capture_cores;
+            break;
+        case ThreadRole::DETECT:
+            cores = &threads.detect_cores;
+            break;
+        case ThreadRole::PUBLISH:
+            cores = &threads.publish_cores;
+            break;
+        case ThreadRole::HOUSEKEEPING:
+            cores = &threads.housekeeping_cores;
+            break;
+    }
+
+    cpu_set_t set = default_cores();
+    if(!cores->empty())
+    {
+        CPU_ZERO(&set);
+        for(int core : *cores)
+        {
+            if(core >= 0 && core < CPU_SETSIZE)
+                CPU_SET(core, &set);
+        }
+    }
+
+    int error = pthread_setaffinity_np(thread.handle, sizeof(set), &set);
+    if(error != 0)
+        spdlog::warn("Unable to set the cores of a {} thread: {}", role_name(thread.role), std::strerror(error));
+
+    // Only capture threads get real-time priority, so that a busy detection can't delay reading out the sensor
+    if(thread.role == ThreadRole::CAPTURE)
+    {
+        sched_param param {};
+        param.sched_priority = threads.capture_priority;
+        const int policy = threads.capture_priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+        error = pthread_setschedparam(thread.handle, policy, &param);
+        if(error != 0)
+        {
+            spdlog::warn("Unable to set the scheduling of a capture thread (real-time priority needs CAP_SYS_NICE): {}",
+                         std::strerror(error));
+        }
+    }
+}
+#else
+static void place(const RegisteredThread& thread, const ThreadSystem& threads)
+{
+}
+#endif
+
+ThreadPlacement::Registration::Registration(std::uint64_t id) : m_id(id)
+{
+}
+
+ThreadPlacement::Registration::~Registration()
+{
+    std::scoped_lock<std::mutex> lock(registry_mutex);
+    registry.erase(m_id);
+}
+
+ThreadPlacement::Registration ThreadPlacement::enter(ThreadRole role)
+{
+    std::scoped_lock<std::mutex> lock(registry_mutex);
+    RegisteredThread thread;
+    thread.role = role;
+#ifdef __linux__
+    thread.handle = pthread_self();
+    // Remember the unpinned cores before any thread is moved
+    default_cores();
+#else
+    thread.handle = 0;
+#endif
+
+    // Threads start out wherever their parent was, so only move them if there's anything to change
+    if(configuration != ThreadSystem())
+        place(thread, configuration);
+
+    const std::uint64_t id = next_id++;
+    registry.emplace(id, thread);
+    return Registration(id);
+}
+
+void ThreadPlacement::configure(const ThreadSystem& threads)
+{
+    std::scoped_lock<std::mutex> lock(registry_mutex);
+    if(threads == configuration)
+        return;
+    configuration = threads;
+
+#ifndef __linux__
+    if(configuration != ThreadSystem())
+        spdlog::warn("Thread placement is only supported on Linux, ignoring it");
+#endif
+    for(const auto& pair : registry)
+        place(pair.second, configuration);
+    spdlog::info("Placed {} threads", registry.size());
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef MELON_THREADPLACEMENT_H
+#define MELON_THREADPLACEMENT_H
+
+#include <cstdint>
+#include "../cmdhandler/statevariables.h"
+
+/** @brief What a thread is used for, which decides the cores it runs on
+ *
+ * @see ThreadSystem
+ */
+enum class ThreadRole
+{
+    /// Reads frames from a camera
+    CAPTURE,
+    /// Converts frames and detects markers in them
+    DETECT,
+    /// Sends detections to the collectors
+    PUBLISH,
+    /// Everything else: command handling, camera management, display and log flushing
+    HOUSEKEEPING
+};
+
+/** @brief Pins threads to cores and sets their scheduling, by their role
+ *
+ * Threads register themselves with their role when they start (see ThreadPlacement::enter()), and are placed
+ * according to the current ThreadSystem. When the configuration changes, every registered thread is moved at once, so
+ * long-running threads don't need to check for changes themselves. <br>
+ * Threads created by a registered thread start out with its placement, so helper threads that can't be registered
+ * (i.e. inside OpenCV) stay on the same cores as the thread that started them
+ *
+ * @note Placement is only supported on Linux. Elsewhere, threads are registered but never moved
+ */
+class ThreadPlacement
+{
+public:
+    /** @brief Registration of a thread. The thread is unregistered when this is destroyed
+     *
+     * @note Must be destroyed on the thread it registered
+     */
+    class Registration
+    {
+    public:
+        Registration(const Registration& other) = delete;
+        Registration& operator=(const Registration& other) = delete;
+        ~Registration();
+
+    private:
+        friend class ThreadPlacement;
+        explicit Registration(std::uint64_t id);
+
+        std::uint64_t m_id;
+    };
+
+    /** @brief Register the calling thread and place it according to the current configuration
+     *
+     * @param role [in] What the thread is used for
+     * @return Registration that has to be kept for as long as the thread runs
+     */
+    static Registration enter(ThreadRole role);
+
+    /** @brief Change the configuration and move every registered thread accordingly
+     *
+     * @param threads [in] The new configuration
+     */
+    static void configure(const ThreadSystem& threads);
+};
+
+#endif //MELON_THREADPLACEMENT_H
\ No newline at end of file
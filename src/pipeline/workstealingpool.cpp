@@ -0,0 +1,138 @@
+#include "workstealingpool.h"
+#include "threadplacement.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+{
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(std::size_t i = 0; i < threads; ++i)
+        m_queues.push_back(std::make_unique<Queue>());
+    for(std::size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back(&WorkStealingPool::thread_func, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_wait_mutex);
+        m_stopping = true;
+    }
+    m_wait_cond.notify_all();
+    for(auto& thread : m_threads)
+        thread.join();
+}
+
+std::size_t WorkStealingPool::size() const { return m_threads.size(); }
+
+void WorkStealingPool::run(std::size_t tasks, const std::function<void(std::size_t)>& task)
+{
+    if(tasks == 0)
+        return;
+
+    Job job;
+    job.function = &task;
+    job.remaining = tasks;
+
+    // Deal the tasks out to the threads' queues
+    const std::size_t first_queue = m_next_queue.fetch_add(1) % m_queues.size();
+    for(std::size_t i = 0; i < tasks; ++i)
+    {
+        Queue& queue = *m_queues[(first_queue + i) % m_queues.size()];
+        std::scoped_lock<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({&job, i});
+    }
+    {
+        std::scoped_lock<std::mutex> lock(m_wait_mutex);
+        ++m_task_counter;
+    }
+    m_wait_cond.notify_all();
+
+    // Help out instead of waiting. This may run tasks from other jobs as well, which is fine since they're all short
+    Task next;
+    while(job.remaining > 0 && take_task(first_queue, next))
+        run_task(next);
+
+    // Wait for the tasks that other threads are still running
+    {
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.done.wait(lock, [&job]{ return job.remaining == 0; });
+    }
+
+    if(job.exception)
+        std::rethrow_exception(job.exception);
+}
+
+void WorkStealingPool::thread_func(std::size_t index)
+{
+    auto placement = ThreadPlacement::enter(ThreadRole::DETECT);
+    while(true)
+    {
+        std::uint64_t task_counter;
+        {
+            std::scoped_lock<std::mutex> lock(m_wait_mutex);
+            if(m_stopping)
+                return;
+            task_counter = m_task_counter;
+        }
+
+        Task task;
+        while(take_task(index, task))
+            run_task(task);
+
+        // Sleep until more tasks are added
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wait_cond.wait(lock, [&]{ return m_stopping || m_task_counter != task_counter; });
+    }
+}
+
+bool WorkStealingPool::take_task(std::size_t index, Task& task)
+{
+    // Take the oldest task from the thread's own queue
+    {
+        Queue& own = *m_queues[index];
+        std::scoped_lock<std::mutex> lock(own.mutex);
+        if(!own.tasks.empty())
+        {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the newest task from another queue, since the owner will get to it last
+    for(std::size_t i = 1; i < m_queues.size(); ++i)
+    {
+        Queue& other = *m_queues[(index + i) % m_queues.size()];
+        std::scoped_lock<std::mutex> lock(other.mutex);
+        if(!other.tasks.empty())
+        {
+            task = other.tasks.back();
+            other.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::run_task(const Task& task)
+{
+    Job& job = *task.job;
+    try
+    {
+        (*job.function)(task.index);
+    }
+    catch(...)
+    {
+        std::scoped_lock<std::mutex> lock(job.mutex);
+        if(!job.exception)
+            job.exception = std::current_exception();
+    }
+
+    // The job lives on the stack of its run() call, so it must not be touched after the last task is marked as done
+    std::scoped_lock<std::mutex> lock(job.mutex);
+    if(--job.remaining == 0)
+        job.done.notify_all();
+}
\ No newline at end of file
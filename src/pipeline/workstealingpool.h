@@ -0,0 +1,115 @@
+#ifndef MELON_WORKSTEALINGPOOL_H
+#define MELON_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** @brief Thread pool for splitting a single job into many small tasks
+ *
+ * Each thread has its own task queue. The tasks of a job are dealt out to the queues round-robin, and a thread that
+ * runs out of tasks steals from the back of the other threads' queues, so a thread that got stuck with slow tasks
+ * doesn't hold up the job. The thread calling WorkStealingPool::run() steals tasks as well instead of sitting idle. <br>
+ * Several threads may run jobs on the same pool at once
+ */
+class WorkStealingPool
+{
+public:
+    /** @brief Create a new pool and start its threads
+     *
+     * @param threads [in] Amount of threads. 0 uses one per core
+     */
+    explicit WorkStealingPool(std::size_t threads);
+    WorkStealingPool(const WorkStealingPool& other) = delete;
+    ~WorkStealingPool();
+
+    /** @brief Run a job and wait for it to finish
+     *
+     * If any of the tasks throws, the rest of the tasks are still run and the first exception is rethrown once the job
+     * is finished
+     *
+     * @param tasks [in] Amount of tasks in the job
+     * @param task [in] Function run once for each task, given the task's index
+     */
+    void run(std::size_t tasks, const std::function<void(std::size_t)>& task);
+
+    /** @brief Get the amount of threads in the pool
+     *
+     * @return Amount of threads, not counting callers of WorkStealingPool::run()
+     */
+    std::size_t size() const;
+
+private:
+    /** @brief Shared state of a job passed to WorkStealingPool::run()
+     *
+     */
+    struct Job
+    {
+        const std::function<void(std::size_t)>* function;
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr exception;
+    };
+
+    /** @brief A single task of a job
+     *
+     */
+    struct Task
+    {
+        Job* job;
+        std::size_t index;
+    };
+
+    /** @brief Task queue of a single thread
+     *
+     */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /** @brief Callback function for the pool's threads
+     *
+     * @param index [in] Index of the thread's own queue
+     */
+    void thread_func(std::size_t index);
+
+    /** @brief Take a task, from the front of the given queue or from the back of any other queue
+     *
+     * @param index [in] Index of the queue to look at first
+     * @param task [out] Task that was taken
+     * @return True if a task was taken, false if every queue was empty
+     */
+    bool take_task(std::size_t index, Task& task);
+
+    /** @brief Run a task and mark it as finished
+     *
+     * @param task [in] Task to run
+     */
+    static void run_task(const Task& task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    // Queue that the next job starts dealing tasks out at, so that small jobs don't all land on the first thread
+    std::atomic<std::size_t> m_next_queue {0};
+
+    // Idle threads wait here for new tasks. The counter is changed whenever tasks are added so that threads can't
+    // miss a wakeup between checking the queues and waiting
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait_cond;
+    std::uint64_t m_task_counter {0};
+    bool m_stopping {false};
+
+    std::vector<std::thread> m_threads;
+};
+
+#endif //MELON_WORKSTEALINGPOOL_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <opencv2/core.hpp>
+#include "../../src/camera/framepool.h"
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+/*
+ * These tests replace the global operator new and delete to count heap allocations, which affects everything in the
+ * program. So they're built into their own AllocationTests executable rather than AllTests
+ */
+
+// Heap allocations made while counting. Every operator new of the test program goes through the replacements below
+static std::atomic<bool> counting {false};
+static std::atomic<std::uint64_t> heap_allocations {0};
+
+void* operator new(std::size_t bytes)
+{
+    if(counting)
+        ++heap_allocations;
+    if(void* p = std::malloc(bytes == 0 ? 1 : bytes))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment)
+{
+    if(counting)
+        ++heap_allocations;
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t size = (std::max<std::size_t>(bytes, 1) + align - 1) / align * align;
+#ifdef _MSC_VER
+    if(void* p = _aligned_malloc(size, align))
+#else
+    if(void* p = std::aligned_alloc(align, size))
+#endif
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#ifdef _MSC_VER
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+/** @brief Counts the cv::Mat pixel buffers allocated while counting
+ *
+ * OpenCV allocates pixel data with its own allocator rather than operator new, so it's counted separately
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage) const override
+    {
+        if(counting)
+            ++allocations;
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* data) const override
+    {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+
+    mutable std::atomic<std::uint64_t> allocations {0};
+};
+
+class SteadyStateSuite : public testing::Test{
+protected:
+    void SetUp(){
+        cv::Mat::setDefaultAllocator(&mat_allocator);
+        // OpenCV's thread pool allocates a small job for every parallel call, which isn't part of the frame path
+        threads = cv::getNumThreads();
+        cv::setNumThreads(1);
+    }
+
+    void TearDown(){
+        counting = false;
+        cv::Mat::setDefaultAllocator(nullptr);
+        cv::setNumThreads(threads);
+    }
+public:
+    CountingMatAllocator mat_allocator;
+    int threads = 0;
+};
+
+/**
+ * Check that once the pools are filled, capturing frames into a ring and converting them to grayscale the way the
+ * camera workers do makes no heap allocations at all
+ */
+TEST_F(SteadyStateSuite, Frame_Path_Allocates_Nothing)
+{
+    const cv::Size size(641, 479);
+    const std::size_t ring_size = 4;
+    FramePool capture_pool, gray_pool;
+    std::vector<Frame> ring(ring_size), grays(ring_size);
+
+    auto capture = [&](std::size_t i)
+    {
+        Frame& frame = ring[i % ring_size];
+        capture_pool.acquire(frame, size, CV_8UC1, ring_size + 1);
+        frame.format = PixelFormat::BAYER_RG8;
+        frame.image.setTo(cv::Scalar(static_cast<double>(i % 256)));
+
+        Frame& gray = grays[i % ring_size];
+        gray_pool.acquire(gray, size, CV_8UC1, ring_size + 1);
+        uchar* const data = gray.image.data;
+        frame.gray(gray.image);
+        return gray.image.data == data;
+    };
+
+    // Fill the pools and let OpenCV set up whatever it keeps around
+    for(std::size_t i = 0; i < 2 * ring_size; ++i)
+        ASSERT_TRUE(capture(i));
+    const std::uint64_t pool_allocations = capture_pool.allocations() + gray_pool.allocations();
+
+    bool in_place = true;
+    counting = true;
+    for(std::size_t i = 0; i < 1000; ++i)
+        in_place = capture(i) && in_place;
+    counting = false;
+
+    EXPECT_TRUE(in_place);
+    EXPECT_EQ(heap_allocations, 0u);
+    EXPECT_EQ(mat_allocator.allocations, 0u);
+    EXPECT_EQ(capture_pool.allocations() + gray_pool.allocations(), pool_allocations);
+}
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include "../../src/camera/framepool.h"
+
+class FramePoolSuite : public testing::Test{
+};
+
+/**
+ * Check that the pool grows when every buffer is held, and starts over when the resolution changes
+ */
+TEST_F(FramePoolSuite, Grows_And_Refills)
+{
+    FramePool pool;
+    std::vector<Frame> held(3);
+    for(auto& frame : held)
+        pool.acquire(frame, cv::Size(64, 48), CV_8UC1, 2);
+    EXPECT_EQ(pool.allocations(), 3u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(held[0].image.data) % 4096, 0u);
+
+    held[0].release();
+    pool.acquire(held[0], cv::Size(64, 48), CV_8UC1, 2);
+    EXPECT_EQ(pool.allocations(), 3u);
+
+    pool.acquire(held[1], cv::Size(32, 24), CV_8UC1, 2);
+    EXPECT_EQ(pool.allocations(), 5u);
+    EXPECT_EQ(held[1].image.size(), cv::Size(32, 24));
+}
@@ -112,3 +112,414 @@ TEST_F(CameraSystemSuite, Invalid_Matrices_Given)
     EXPECT_THAT(response, HasSubstr("list of doubles"));
     ASSERT_EQ(testing_state.camera.distortion_matrix.empty(), true);
 }
+
+/**
+ * Check that the capture thread variables get set correctly and invalid values are rejected
+ */
+TEST_F(CameraSystemSuite, Sets_Capture_Variables)
+{
+    //check defaults
+    ASSERT_EQ(testing_state.camera.capture_buffer_size, 0);
+    ASSERT_EQ(testing_state.camera.capture_policy, "drop_oldest");
+
+    std::string response = command_handler::do_command({"set", "camera", "capture_buffer_size", "8"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'capture_buffer_size' variable set"));
+    ASSERT_EQ(testing_state.camera.capture_buffer_size, 8);
+
+    response = command_handler::do_command({"set", "camera", "capture_policy", "BLOCK"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("capture_policy set to 'block'"));
+    ASSERT_EQ(testing_state.camera.capture_policy, "block");
+
+    //test invalid values
+    response = command_handler::do_command({"set", "camera", "capture_buffer_size", "-1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 0"));
+    ASSERT_EQ(testing_state.camera.capture_buffer_size, 8);
+
+    response = command_handler::do_command({"set", "camera", "capture_policy", "newest"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("Valid options are"));
+    ASSERT_EQ(testing_state.camera.capture_policy, "block");
+
+    //check listing
+    response = command_handler::do_command({"list", "camera"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("capture_buffer_size: 8"));
+    EXPECT_THAT(response, HasSubstr("capture_policy: block"));
+}
+
+/**
+ * Check that the pixel format can only be set to a supported format
+ */
+TEST_F(CameraSystemSuite, Sets_Pixel_Format)
+{
+    ASSERT_EQ(testing_state.camera.pixel_format, "bgr8");
+
+    std::string response = command_handler::do_command({"set", "camera", "pixel_format", "Mono8"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("pixel_format set to 'mono8'"));
+    ASSERT_EQ(testing_state.camera.pixel_format, "mono8");
+
+    response = command_handler::do_command({"set", "camera", "pixel_format", "rgb16"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("Valid options are"));
+    ASSERT_EQ(testing_state.camera.pixel_format, "mono8");
+
+    response = command_handler::do_command({"get", "camera", "pixel_format"}, testing_state);
+    ASSERT_EQ(response, "pixel_format: mono8");
+}
+
+/**
+ * Check that the sensor region variables get set correctly and invalid regions are rejected
+ */
+TEST_F(CameraSystemSuite, Sets_Sensor_Region)
+{
+    std::string response = command_handler::do_command({"set", "camera", "roi", "10,20,640,480"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'roi' variable set"));
+    ASSERT_EQ(testing_state.camera.roi, cv::Rect(10, 20, 640, 480));
+    ASSERT_FALSE(testing_state.camera.auto_roi);
+
+    //auto keeps the manual region as its bounds
+    response = command_handler::do_command({"set", "camera", "roi", "auto"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("set to 'auto'"));
+    ASSERT_TRUE(testing_state.camera.auto_roi);
+    ASSERT_EQ(testing_state.camera.roi, cv::Rect(10, 20, 640, 480));
+
+    response = command_handler::do_command({"set", "camera", "roi", "full"}, testing_state);
+    ASSERT_FALSE(testing_state.camera.auto_roi);
+    ASSERT_TRUE(testing_state.camera.roi.empty());
+
+    //test invalid regions
+    response = command_handler::do_command({"set", "camera", "roi", "10,20,640"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("4 integers"));
+    response = command_handler::do_command({"set", "camera", "roi", "10,20,0,480"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("positive width and height"));
+    ASSERT_TRUE(testing_state.camera.roi.empty());
+
+    response = command_handler::do_command({"set", "camera", "binning", "2"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'binning' variable set"));
+    ASSERT_EQ(testing_state.camera.binning, 2);
+
+    response = command_handler::do_command({"set", "camera", "decimation", "0"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 1"));
+    ASSERT_EQ(testing_state.camera.decimation, 1);
+
+    response = command_handler::do_command({"get", "camera", "roi"}, testing_state);
+    ASSERT_EQ(response, "roi: full");
+}
+
+/**
+ * Check that the acquisition variables get set correctly and invalid values are rejected
+ */
+TEST_F(CameraSystemSuite, Sets_Acquisition_Variables)
+{
+    std::string response = command_handler::do_command({"set", "camera", "exposure_time", "1500.5"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'exposure_time' variable set"));
+    ASSERT_DOUBLE_EQ(testing_state.camera.exposure_time, 1500.5);
+
+    response = command_handler::do_command({"set", "camera", "frame_rate", "-5"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 0"));
+    ASSERT_DOUBLE_EQ(testing_state.camera.frame_rate, 0);
+
+    response = command_handler::do_command({"set", "camera", "gain", "loud"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("valid number"));
+    ASSERT_LT(testing_state.camera.gain, 0);
+
+    //0dB is a fixed gain, not automatic gain
+    response = command_handler::do_command({"set", "camera", "gain", "0"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'gain' variable set"));
+    ASSERT_DOUBLE_EQ(testing_state.camera.gain, 0);
+    response = command_handler::do_command({"get", "camera", "gain"}, testing_state);
+    ASSERT_EQ(response, "gain: 0");
+
+    response = command_handler::do_command({"set", "camera", "gain", "auto"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("set to 'auto'"));
+    ASSERT_LT(testing_state.camera.gain, 0);
+    response = command_handler::do_command({"get", "camera", "gain"}, testing_state);
+    ASSERT_EQ(response, "gain: auto");
+
+    ASSERT_EQ(testing_state.camera.stream_buffer_mode, "newest_only");
+    response = command_handler::do_command({"set", "camera", "stream_buffer_mode", "oldest_first"}, testing_state);
+    ASSERT_EQ(testing_state.camera.stream_buffer_mode, "oldest_first");
+
+    response = command_handler::do_command({"set", "camera", "stream_buffer_count", "3"}, testing_state);
+    ASSERT_EQ(testing_state.camera.stream_buffer_count, 3);
+
+    response = command_handler::do_command({"get", "camera", "exposure_time"}, testing_state);
+    ASSERT_EQ(response, "exposure_time: 1500.5");
+}
+
+/**
+ * Check that named cameras are created when set and are kept separate from the default camera
+ */
+TEST_F(CameraSystemSuite, Sets_Named_Cameras)
+{
+    std::string response = command_handler::do_command({"get", "camera:left", "source"}, testing_state);
+    ASSERT_EQ(response, "camera 'left' not found");
+    ASSERT_TRUE(testing_state.cameras.empty());
+
+    //an unknown variable or an invalid value doesn't leave an empty camera behind
+    response = command_handler::do_command({"set", "camera:left", "colour", "red"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("does not exist"));
+    response = command_handler::do_command({"set", "camera:left", "binning", "0"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 1"));
+    ASSERT_TRUE(testing_state.cameras.empty());
+
+    response = command_handler::do_command({"set", "camera:left", "source", "12345"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("source set to"));
+    ASSERT_EQ(testing_state.cameras.at("left").source, "12345");
+    ASSERT_EQ(testing_state.camera.source, "");
+
+    response = command_handler::do_command({"get", "camera:left", "source"}, testing_state);
+    ASSERT_EQ(response, "source: 12345");
+
+    response = command_handler::do_command({"set", "camera:default", "source", "0"}, testing_state);
+    ASSERT_EQ(testing_state.camera.source, "0");
+    ASSERT_EQ(testing_state.find_camera("default"), &testing_state.camera);
+    ASSERT_EQ(testing_state.find_camera("right"), nullptr);
+
+    //setting a variable to its default value still creates the camera
+    response = command_handler::do_command({"set", "camera:right", "binning", "1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("set with value 1"));
+    ASSERT_NE(testing_state.find_camera("right"), nullptr);
+    ASSERT_EQ(testing_state.cameras.at("right"), CameraSystem{});
+}
+
+/**
+ * Check that the cameras system lists and removes named cameras
+ */
+TEST_F(CameraSystemSuite, Lists_And_Deletes_Cameras)
+{
+    command_handler::do_command({"set", "camera", "type", "opencv"}, testing_state);
+    command_handler::do_command({"set", "camera:left", "type", "spinnaker"}, testing_state);
+
+    std::string response = command_handler::do_command({"list", "cameras"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("default: opencv"));
+    EXPECT_THAT(response, HasSubstr("left: spinnaker"));
+    ASSERT_EQ(testing_state.camera_names(), std::vector<std::string>({"default", "left"}));
+
+    response = command_handler::do_command({"delete", "cameras", "left"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("has been removed"));
+    ASSERT_TRUE(testing_state.cameras.empty());
+
+    response = command_handler::do_command({"delete", "cameras", "left"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("does not exist"));
+}
+
+/**
+ * Check that the replay variables get set correctly and invalid values are rejected
+ */
+TEST_F(CameraSystemSuite, Sets_Replay_Variables)
+{
+    std::string response = command_handler::do_command({"set", "camera", "type", "replay"}, testing_state);
+    ASSERT_EQ(testing_state.camera.type, "replay");
+
+    ASSERT_EQ(testing_state.camera.replay_mode, "fast");
+    response = command_handler::do_command({"set", "camera", "replay_mode", "Recorded"}, testing_state);
+    ASSERT_EQ(testing_state.camera.replay_mode, "recorded");
+
+    response = command_handler::do_command({"set", "camera", "replay_mode", "slow"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("Valid options are"));
+    ASSERT_EQ(testing_state.camera.replay_mode, "recorded");
+
+    response = command_handler::do_command({"set", "camera", "replay_preload", "true"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'replay_preload' variable set"));
+    ASSERT_TRUE(testing_state.camera.replay_preload);
+
+    response = command_handler::do_command({"set", "camera", "replay_loop", "maybe"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("acceptable values are 'true' and 'false'"));
+    ASSERT_TRUE(testing_state.camera.replay_loop);
+
+    response = command_handler::do_command({"get", "camera", "replay_loop"}, testing_state);
+    ASSERT_EQ(response, "replay_loop: true");
+}
+
+/**
+ * Check that the synthetic camera variables get set correctly and invalid values are rejected
+ */
+TEST_F(CameraSystemSuite, Sets_Synthetic_Variables)
+{
+    std::string response = command_handler::do_command({"set", "camera", "type", "synthetic"}, testing_state);
+    ASSERT_EQ(testing_state.camera.type, "synthetic");
+
+    response = command_handler::do_command({"set", "camera", "synthetic_robots", "1000"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'synthetic_robots' variable set"));
+    ASSERT_EQ(testing_state.camera.synthetic_robots, 1000);
+
+    response = command_handler::do_command({"set", "camera", "synthetic_marker_size", "4"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 8"));
+    ASSERT_EQ(testing_state.camera.synthetic_marker_size, 40);
+
+    response = command_handler::do_command({"set", "camera", "synthetic_noise", "2.5"}, testing_state);
+    ASSERT_DOUBLE_EQ(testing_state.camera.synthetic_noise, 2.5);
+
+    response = command_handler::do_command({"get", "camera", "synthetic_noise"}, testing_state);
+    ASSERT_EQ(response, "synthetic_noise: 2.5");
+}
+
+/**
+ * Check that the amount of detection threads can't be set below 1
+ */
+TEST_F(CameraSystemSuite, Sets_Detect_Threads)
+{
+    std::string response = command_handler::do_command({"set", "camera", "detect_threads", "4"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'detect_threads' variable set"));
+    ASSERT_EQ(testing_state.camera.detect_threads, 4);
+
+    response = command_handler::do_command({"set", "camera", "detect_threads", "0"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 1"));
+    ASSERT_EQ(testing_state.camera.detect_threads, 4);
+
+    response = command_handler::do_command({"delete", "camera", "detect_threads"}, testing_state);
+    ASSERT_EQ(testing_state.camera.detect_threads, 2);
+}
+
+/**
+ * Check that the detection tile variables get set correctly and can be deleted back to their defaults
+ */
+TEST_F(CameraSystemSuite, Sets_Detect_Tiles)
+{
+    std::string response = command_handler::do_command({"set", "camera", "detect_tile_size", "512"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'detect_tile_size' variable set"));
+    ASSERT_EQ(testing_state.camera.detect_tile_size, 512);
+
+    response = command_handler::do_command({"set", "camera", "detect_tile_overlap", "-1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 0"));
+    ASSERT_EQ(testing_state.camera.detect_tile_overlap, 100);
+
+    response = command_handler::do_command({"get", "camera", "detect_tile_size"}, testing_state);
+    ASSERT_EQ(response, "detect_tile_size: 512");
+
+    response = command_handler::do_command({"delete", "camera", "detect_tile_size"}, testing_state);
+    ASSERT_EQ(testing_state.camera.detect_tile_size, 0);
+}
+
+/**
+ * Check that the pyramid levels get set within their range and can be deleted back to full resolution detection
+ */
+TEST_F(CameraSystemSuite, Sets_Detect_Pyramid_Levels)
+{
+    std::string response = command_handler::do_command({"set", "camera", "detect_pyramid_levels", "2"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'detect_pyramid_levels' variable set"));
+    ASSERT_EQ(testing_state.camera.detect_pyramid_levels, 2);
+
+    response = command_handler::do_command({"set", "camera", "detect_pyramid_levels", "4"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at most 3"));
+    ASSERT_EQ(testing_state.camera.detect_pyramid_levels, 2);
+
+    response = command_handler::do_command({"get", "camera", "detect_pyramid_levels"}, testing_state);
+    ASSERT_EQ(response, "detect_pyramid_levels: 2");
+
+    response = command_handler::do_command({"delete", "camera", "detect_pyramid_levels"}, testing_state);
+    ASSERT_EQ(testing_state.camera.detect_pyramid_levels, 0);
+}
+
+/**
+ * Check that presets set every detector setting, and that changing one of them on its own shows a custom preset
+ */
+TEST_F(CameraSystemSuite, Sets_Detector_Preset)
+{
+    std::string response = command_handler::do_command({"get", "camera", "detector_preset"}, testing_state);
+    ASSERT_EQ(response, "detector_preset: balanced");
+
+    response = command_handler::do_command({"set", "camera", "detector_preset", "accurate"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("set to 'accurate'"));
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_step, 5);
+    ASSERT_EQ(testing_state.camera.detector_corner_refinement, "subpix");
+
+    response = command_handler::do_command({"set", "camera", "detector_preset", "slow"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("Valid options are: fast, balanced, accurate"));
+    ASSERT_EQ(testing_state.camera.detector_corner_refinement, "subpix");
+
+    response = command_handler::do_command({"set", "camera", "detector_preset", "fast"}, testing_state);
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_min, 5);
+    ASSERT_EQ(testing_state.camera.detector_corner_refinement, "none");
+    response = command_handler::do_command({"list", "camera"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("detector_preset: fast"));
+
+    command_handler::do_command({"set", "camera", "detector_threshold_constant", "10"}, testing_state);
+    response = command_handler::do_command({"get", "camera", "detector_preset"}, testing_state);
+    ASSERT_EQ(response, "detector_preset: custom");
+
+    command_handler::do_command({"delete", "camera", "detector_preset"}, testing_state);
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_min, CameraSystem{}.detector_threshold_win_min);
+    ASSERT_DOUBLE_EQ(testing_state.camera.detector_threshold_constant, CameraSystem{}.detector_threshold_constant);
+}
+
+/**
+ * Check that the individual detector settings get set, and that their ranges are kept consistent
+ */
+TEST_F(CameraSystemSuite, Sets_Detector_Variables)
+{
+    std::string response = command_handler::do_command({"set", "camera", "detector_threshold_win_min", "7"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'detector_threshold_win_min' variable set"));
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_min, 7);
+
+    response = command_handler::do_command({"set", "camera", "detector_threshold_win_min", "2"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 3"));
+    response = command_handler::do_command({"set", "camera", "detector_threshold_win_min", "31"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at most 23"));
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_min, 7);
+
+    response = command_handler::do_command({"set", "camera", "detector_threshold_win_max", "5"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 7"));
+    ASSERT_EQ(testing_state.camera.detector_threshold_win_max, 23);
+
+    response = command_handler::do_command({"set", "camera", "detector_corner_refinement", "contour"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("set to 'contour'"));
+    response = command_handler::do_command({"get", "camera", "detector_corner_refinement"}, testing_state);
+    ASSERT_EQ(response, "detector_corner_refinement: contour");
+
+    response = command_handler::do_command({"set", "camera", "detector_min_perimeter_rate", "0.1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'detector_min_perimeter_rate' variable set"));
+    response = command_handler::do_command({"set", "camera", "detector_max_perimeter_rate", "0.05"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 0.1"));
+    ASSERT_DOUBLE_EQ(testing_state.camera.detector_max_perimeter_rate, 4.0);
+}
+
+/**
+ * Check that only ArUco's predefined dictionaries can be selected
+ */
+TEST_F(CameraSystemSuite, Sets_Marker_Dictionary_In_Range)
+{
+    std::string response = command_handler::do_command({"set", "camera", "marker_dictionary", "21"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("between 0 and 20"));
+    response = command_handler::do_command({"set", "camera", "marker_dictionary", "-1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("between 0 and 20"));
+    ASSERT_EQ(testing_state.camera.marker_dictionary, 0);
+}
+
+/**
+ * Check the latency budget gets set, and a running camera's load level is shown
+ */
+TEST_F(CameraSystemSuite, Reports_Load_Level)
+{
+    std::string response = command_handler::do_command({"set", "camera:left", "latency_budget", "40"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'latency_budget' variable set"));
+    ASSERT_DOUBLE_EQ(testing_state.cameras.at("left").latency_budget, 40);
+
+    response = command_handler::do_command({"get", "cameras", "left"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("not running"));
+
+    testing_state.camera_status["left"].load_level = "roi_only";
+    response = command_handler::do_command({"get", "cameras", "left"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("load_level: roi_only"));
+
+    response = command_handler::do_command({"list", "cameras"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("load: roi_only"));
+}
+
+/**
+ * Check that the amount of tracked frames between full scans gets set and can be deleted to turn tracking off
+ */
+TEST_F(CameraSystemSuite, Sets_Tracking_Frames)
+{
+    std::string response = command_handler::do_command({"set", "camera", "tracking_frames", "10"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'tracking_frames' variable set"));
+    ASSERT_EQ(testing_state.camera.tracking_frames, 10);
+
+    response = command_handler::do_command({"set", "camera", "tracking_frames", "-1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at least 0"));
+    ASSERT_EQ(testing_state.camera.tracking_frames, 10);
+
+    response = command_handler::do_command({"get", "camera", "tracking_frames"}, testing_state);
+    ASSERT_EQ(response, "tracking_frames: 10");
+
+    response = command_handler::do_command({"delete", "camera", "tracking_frames"}, testing_state);
+    ASSERT_EQ(testing_state.camera.tracking_frames, 0);
+}
@@ -72,4 +72,42 @@ TEST_F(CmdHandlerSuite, Empty_Command)
     //check that response handles correctly
     EXPECT_THAT(response, HasSubstr("command:"));
     EXPECT_THAT(response, HasSubstr("not found"));
-}
\ No newline at end of file
+}
+
+/**
+ * Test that the shutdown command marks the state as shutting down
+ */
+TEST_F(CmdHandlerSuite, Shutdown_Command)
+{
+    ASSERT_FALSE(testing_state.shutdown);
+
+    std::string response = command_handler::do_command({"shutdown"}, testing_state);
+
+    EXPECT_THAT(response, HasSubstr("shutting down"));
+    ASSERT_TRUE(testing_state.shutdown);
+}
+
+/**
+ * Test that the stop, start and restart commands change whether the pipelines run, and that restarting is counted
+ */
+TEST_F(CmdHandlerSuite, Pipeline_Commands)
+{
+    ASSERT_TRUE(testing_state.pipeline.running);
+
+    std::string response = command_handler::do_command({"stop"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("stopping pipelines"));
+    ASSERT_FALSE(testing_state.pipeline.running);
+
+    response = command_handler::do_command({"stop"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("already stopped"));
+
+    response = command_handler::do_command({"start"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("starting pipelines"));
+    ASSERT_TRUE(testing_state.pipeline.running);
+
+    const unsigned restarts = testing_state.pipeline.restarts;
+    response = command_handler::do_command({"restart"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("restarting pipelines"));
+    ASSERT_TRUE(testing_state.pipeline.running);
+    ASSERT_NE(restarts, testing_state.pipeline.restarts);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "../../src/cmdhandler/globalstate.h"
+
+class GlobalStateSuite : public testing::Test{
+protected:
+    /** @brief Publish a state with one robot added
+     *
+     * @param name [in] Name of the robot
+     * @param ids [in] Marker ids of the robot
+     */
+    void add_robot(const std::string& name, const std::vector<int>& ids){
+        StateVariables state = global_state.get_state();
+        state.robot.robots[name] = ids;
+        global_state.receive(state);
+    }
+public:
+    GlobalState global_state;
+};
+
+/**
+ * Check that a snapshot taken before an update keeps the state it was taken with
+ */
+TEST_F(GlobalStateSuite, Snapshot_Unaffected_By_Updates)
+{
+    add_robot("r1", {1, 2, 3, 4});
+    std::shared_ptr<const StateVariables> snapshot = global_state.snapshot();
+    const unsigned version = snapshot->version;
+
+    add_robot("r2", {5, 6, 7, 8});
+    global_state.report_status("cam", CameraStatus{CameraSystemVars::LOAD_LEVEL_NONE, 12});
+    global_state.request_shutdown();
+
+    EXPECT_EQ(snapshot->version, version);
+    EXPECT_EQ(snapshot->robot.robots.size(), 1u);
+    EXPECT_TRUE(snapshot->camera_status.empty());
+    EXPECT_FALSE(snapshot->shutdown);
+
+    std::shared_ptr<const StateVariables> current = global_state.snapshot();
+    EXPECT_EQ(current->robot.robots.size(), 2u);
+    EXPECT_EQ(current->camera_status.size(), 1u);
+    EXPECT_TRUE(current->shutdown);
+}
+
+/**
+ * Check that the version only advances when the state actually changes
+ */
+TEST_F(GlobalStateSuite, Version_Advances_On_Change)
+{
+    EXPECT_EQ(global_state.version(), 0u);
+    add_robot("r1", {1, 2, 3, 4});
+    EXPECT_EQ(global_state.version(), 1u);
+
+    // Neither an unchanged state nor an unchanged status publish a new snapshot
+    global_state.receive(global_state.get_state());
+    global_state.report_status("cam", CameraStatus());
+    global_state.report_status("cam", CameraStatus());
+    EXPECT_EQ(global_state.version(), 2u);
+    global_state.clear_status("cam");
+    global_state.clear_status("cam");
+    EXPECT_EQ(global_state.version(), 3u);
+    EXPECT_EQ(global_state.snapshot()->version, 3u);
+}
+
+/**
+ * Check that a snapshot is only reported as changed for the subsystems that changed since it was taken
+ */
+TEST_F(GlobalStateSuite, Update_Only_Reports_Changed_Subsystems)
+{
+    std::shared_ptr<const StateVariables> robots, collectors;
+    // A null snapshot always counts as changed
+    EXPECT_TRUE(global_state.update(robots, StateSubsystem::ROBOT));
+    EXPECT_TRUE(global_state.update(collectors, StateSubsystem::COLLECTOR));
+
+    add_robot("r1", {1, 2, 3, 4});
+    EXPECT_TRUE(global_state.update(robots, StateSubsystem::ROBOT));
+    EXPECT_FALSE(global_state.update(collectors, StateSubsystem::COLLECTOR));
+    // Both snapshots are moved to the current one either way
+    EXPECT_EQ(robots->version, global_state.version());
+    EXPECT_EQ(collectors->version, global_state.version());
+    EXPECT_FALSE(global_state.update(robots, StateSubsystem::ROBOT));
+
+    // A change to another subsystem in between doesn't hide an earlier one
+    StateVariables state = global_state.get_state();
+    state.collector.collectors["gcs"] = asio::ip::udp::endpoint(asio::ip::make_address("127.0.0.1"), 5000);
+    global_state.receive(state);
+    add_robot("r2", {5, 6, 7, 8});
+    EXPECT_TRUE(global_state.update(collectors, StateSubsystem::COLLECTOR));
+    EXPECT_TRUE(global_state.update(robots, StateSubsystem::ROBOT | StateSubsystem::COLLECTOR));
+
+    global_state.request_shutdown();
+    EXPECT_FALSE(global_state.update(robots, StateSubsystem::ROBOT | StateSubsystem::COLLECTOR));
+    EXPECT_FALSE(global_state.update(collectors, StateSubsystem::ALL & ~StateSubsystem::SHUTDOWN));
+}
+
+/**
+ * Check that waiting for an update ignores changes to other subsystems and returns once a given subsystem changes
+ */
+TEST_F(GlobalStateSuite, Wait_Update_Wakes_For_Subsystem)
+{
+    std::shared_ptr<const StateVariables> state = global_state.snapshot();
+    EXPECT_FALSE(global_state.wait_update(state, StateSubsystem::ROBOT, std::chrono::milliseconds(10)));
+
+    std::thread writer([this]{
+        global_state.report_status("cam", CameraStatus());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        add_robot("r1", {1, 2, 3, 4});
+    });
+    const bool changed = global_state.wait_update(state, StateSubsystem::ROBOT, std::chrono::seconds(5));
+    writer.join();
+
+    EXPECT_TRUE(changed);
+    EXPECT_EQ(state->robot.robots.size(), 1u);
+    EXPECT_EQ(state->version, global_state.version());
+}
@@ -68,6 +68,32 @@ TEST_F(StateSystemSuite, Saves_Deletes_Loads)
     EXPECT_THAT(response, HasSubstr("tests_state"));
 }
 
+/**
+ * Test that camera variables whose valid values include 0 or false keep them through a save and load
+ */
+TEST_F(StateSystemSuite, Saves_Loads_Zero_Values)
+{
+    command_handler::do_command({"set", "camera", "roi_margin", "0"}, testing_state);
+    ASSERT_EQ(testing_state.camera.roi_margin, 0);
+    command_handler::do_command({"set", "camera", "replay_loop", "false"}, testing_state);
+    ASSERT_FALSE(testing_state.camera.replay_loop);
+    command_handler::do_command({"set", "camera", "display_rate", "0"}, testing_state);
+    ASSERT_EQ(testing_state.camera.display_rate, 0);
+
+    std::string response = command_handler::do_command({"save", "state", "tests_zero_state"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("current state saved"));
+    command_handler::do_command({"delete", "state", "current"}, testing_state);
+    ASSERT_EQ(testing_state.camera.roi_margin, CameraSystem{}.roi_margin);
+    ASSERT_TRUE(testing_state.camera.replay_loop);
+    ASSERT_EQ(testing_state.camera.display_rate, CameraSystem{}.display_rate);
+
+    response = command_handler::do_command({"load", "state", "tests_zero_state"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("current state loaded"));
+    ASSERT_EQ(testing_state.camera.roi_margin, 0);
+    ASSERT_FALSE(testing_state.camera.replay_loop);
+    ASSERT_EQ(testing_state.camera.display_rate, 0);
+}
+
 /**
  * Test that response string indicates a non-existent state was given to delete
  */
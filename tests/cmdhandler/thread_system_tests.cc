@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "../../src/cmdhandler/command_handler.h"
+
+using ::testing::HasSubstr;
+
+class ThreadSystemSuite : public testing::Test{
+protected:
+    static void SetUpTestSuite() {
+        testing_state = StateVariables();
+    }
+
+    void TearDown(){
+        testing_state = StateVariables();
+    }
+public:
+    static StateVariables testing_state;
+};
+
+StateVariables ThreadSystemSuite::testing_state;
+
+/**
+ * Check core lists get set into state and read back
+ */
+TEST_F(ThreadSystemSuite, Sets_Cores)
+{
+    std::string response = command_handler::do_command({"get", "threads", "capture_cores"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("capture_cores: any"));
+
+    response = command_handler::do_command({"set", "threads", "capture_cores", "2,3"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'capture_cores' variable set"));
+    ASSERT_EQ(testing_state.threads.capture_cores, std::vector<int>({2, 3}));
+
+    response = command_handler::do_command({"get", "threads", "capture_cores"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("capture_cores: 2,3"));
+
+    response = command_handler::do_command({"set", "threads", "detect_cores", "1,-1"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("non-negative"));
+    ASSERT_TRUE(testing_state.threads.detect_cores.empty());
+
+    response = command_handler::do_command({"delete", "threads", "capture_cores"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("has been deleted"));
+    ASSERT_TRUE(testing_state.threads.capture_cores.empty());
+}
+
+/**
+ * Check the capture priority is limited to the real-time priority range
+ */
+TEST_F(ThreadSystemSuite, Sets_Capture_Priority)
+{
+    std::string response = command_handler::do_command({"set", "threads", "capture_priority", "50"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("'capture_priority' variable set"));
+    ASSERT_EQ(testing_state.threads.capture_priority, 50);
+
+    response = command_handler::do_command({"set", "threads", "capture_priority", "100"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("at most 99"));
+    ASSERT_EQ(testing_state.threads.capture_priority, 50);
+
+    response = command_handler::do_command({"list", "threads"}, testing_state);
+    EXPECT_THAT(response, HasSubstr("capture_priority: 50"));
+    EXPECT_THAT(response, HasSubstr("housekeeping_cores: any"));
+}
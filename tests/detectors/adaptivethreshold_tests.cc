@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <opencv2/imgproc.hpp>
+#include "../../src/detectors/adaptivethreshold.h"
+
+class AdaptiveThresholdSuite : public testing::Test{
+protected:
+    /** @brief Check every kernel against cv::adaptiveThreshold()
+     *
+     * @param image [in] Single channel, 8 bit image to threshold
+     * @param constant [in] Amount subtracted from the mean
+     * @param sizes [in] Window sizes to check
+     */
+    static void expect_matches_opencv(const cv::Mat& image, double constant,
+                                      const std::vector<int>& sizes = window_sizes){
+        for(ThresholdKernel kernel : {ThresholdKernel::FASTEST, ThresholdKernel::SCALAR})
+        {
+            std::vector<cv::Mat> thresholds;
+            adaptive_threshold(image, sizes, constant, thresholds, kernel);
+            ASSERT_EQ(thresholds.size(), sizes.size());
+            for(std::size_t i = 0; i < sizes.size(); ++i)
+            {
+                cv::Mat expected;
+                cv::adaptiveThreshold(image, expected, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV,
+                                      sizes[i], constant);
+                ASSERT_EQ(thresholds[i].size(), image.size());
+                EXPECT_EQ(cv::countNonZero(thresholds[i] != expected), 0)
+                    << "window size " << sizes[i] << ", " << image.cols << "x" << image.rows << ", constant "
+                    << constant << (kernel == ThresholdKernel::SCALAR ? ", scalar" : ", fastest");
+            }
+        }
+    }
+
+    /** @brief Make an image of noise over a gradient, so that pixels are close to their window's mean everywhere
+     *
+     * @param size [in] Size of the image
+     * @return Single channel, 8 bit image
+     */
+    static cv::Mat make_image(cv::Size size){
+        cv::Mat image(size, CV_8UC1);
+        for(int y = 0; y < size.height; ++y)
+        {
+            for(int x = 0; x < size.width; ++x)
+                image.at<uchar>(y, x) = cv::saturate_cast<uchar>(x * 255 / size.width / 2 + y % 64);
+        }
+        cv::Mat noise(size, CV_8UC1);
+        cv::theRNG().state = 1234;
+        cv::randu(noise, 0, 64);
+        image += noise;
+        return image;
+    }
+
+    static void SetUpTestSuite(){
+        // Every odd window size from the smallest one up to ones larger than the smallest images
+        window_sizes.clear();
+        for(int size = 3; size <= 51; size += 2)
+            window_sizes.push_back(size);
+    }
+public:
+    static std::vector<int> window_sizes;
+};
+
+std::vector<int> AdaptiveThresholdSuite::window_sizes;
+
+/**
+ * Check that every kernel matches OpenCV on images whose width isn't a multiple of the vector width, including ones
+ * smaller than the largest window
+ */
+TEST_F(AdaptiveThresholdSuite, Matches_OpenCV)
+{
+    for(const cv::Size& size : {cv::Size(641, 479), cv::Size(37, 23), cv::Size(9, 7)})
+    {
+        const cv::Mat image = make_image(size);
+        // ArUco's default constant, no constant, a negative one and one that OpenCV rounds down
+        for(double constant : {7.0, 0.0, -3.0, 2.5})
+            expect_matches_opencv(image, constant);
+    }
+}
+
+/**
+ * Check that images too large for a 32 bit integral image still match OpenCV. The image is bright enough that the sum
+ * of all of its pixels is over INT32_MAX
+ */
+TEST_F(AdaptiveThresholdSuite, Large_Image_Matches_OpenCV)
+{
+    const cv::Size size(4000, 3000);
+    const cv::Mat image = 255 - make_image(size) / 4;
+    ASSERT_GT(cv::sum(image)[0], static_cast<double>(std::numeric_limits<std::int32_t>::max()));
+    expect_matches_opencv(image, 7, {3, 23, 51});
+}
+
+/**
+ * Check that the vectorized kernels give the same result as thresholding one pixel at a time
+ */
+TEST_F(AdaptiveThresholdSuite, Kernels_Agree)
+{
+    const cv::Mat image = make_image(cv::Size(1283, 721));
+    std::vector<cv::Mat> fastest, scalar;
+    adaptive_threshold(image, window_sizes, 7, fastest, ThresholdKernel::FASTEST);
+    adaptive_threshold(image, window_sizes, 7, scalar, ThresholdKernel::SCALAR);
+    ASSERT_EQ(fastest.size(), scalar.size());
+    for(std::size_t i = 0; i < fastest.size(); ++i)
+        EXPECT_EQ(cv::countNonZero(fastest[i] != scalar[i]), 0) << "window size " << window_sizes[i];
+}
+
+/**
+ * Check that a region of a larger image is thresholded as if it was a whole image, like OpenCV does
+ */
+TEST_F(AdaptiveThresholdSuite, Region_Matches_OpenCV)
+{
+    const cv::Mat image = make_image(cv::Size(640, 480));
+    expect_matches_opencv(image(cv::Rect(101, 53, 317, 199)), 7);
+}
+
+/**
+ * Check that the thresholded images are reused when they already have the right size
+ */
+TEST_F(AdaptiveThresholdSuite, Reuses_Thresholds)
+{
+    const cv::Mat image = make_image(cv::Size(64, 48));
+    std::vector<cv::Mat> thresholds;
+    adaptive_threshold(image, {3, 13, 23}, 7, thresholds);
+    const uchar* data = thresholds[1].data;
+    adaptive_threshold(image, {3, 13, 23}, 7, thresholds);
+    EXPECT_EQ(thresholds[1].data, data);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <opencv2/aruco.hpp>
+#include <opencv2/imgproc.hpp>
+#include "../../src/detectors/markerdetector.h"
+#include "../../src/pipeline/workstealingpool.h"
+
+class MarkerDetectorSuite : public testing::Test{
+protected:
+    /** @brief Draw a marker onto a white image
+     *
+     * @param image [in, out] Image to draw on
+     * @param id [in] Id of the marker in DICT_4X4_50
+     * @param top_left [in] Position of the marker's top left corner
+     * @param size [in] Side length of the marker in pixels
+     */
+    static void draw_marker(cv::Mat& image, int id, cv::Point top_left, int size){
+        cv::Mat marker;
+        cv::aruco::drawMarker(cv::aruco::getPredefinedDictionary(cv::aruco::DICT_4X4_50), id, size, marker, 1);
+        marker.copyTo(image(cv::Rect(top_left, cv::Size(size, size))));
+    }
+public:
+    // Same settings as a camera system's defaults: no tile size, but an overlap of 100 pixels
+    static constexpr int DEFAULT_TILE_SIZE = 0;
+    static constexpr int DEFAULT_TILE_OVERLAP = 100;
+};
+
+/**
+ * Check that the default tiling settings search frames as a whole, even with a tiling pool
+ */
+TEST_F(MarkerDetectorSuite, Default_Settings_Search_Whole_Frame)
+{
+    WorkStealingPool pool(2);
+    MarkerDetector::Tiling tiling;
+    tiling.size = DEFAULT_TILE_SIZE;
+    tiling.overlap = DEFAULT_TILE_OVERLAP;
+    tiling.pool = &pool;
+    MarkerDetector detector(CameraCalib(), cv::aruco::DICT_4X4_50, nullptr, tiling);
+    EXPECT_FALSE(detector.is_tiled(cv::Size(1280, 720)));
+
+    // A marker larger than the overlap could only be missed if the frame was split into tiles
+    cv::Mat image(720, 1280, CV_8UC1, cv::Scalar(255));
+    draw_marker(image, 7, cv::Point(500, 200), 300);
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int> ids;
+    detector.find(image, corners, ids);
+    ASSERT_EQ(ids.size(), 1u);
+    EXPECT_EQ(ids[0], 7);
+}
+
+/**
+ * Check that frames larger than a tile are tiled once a tile size is set, and that tiles hold at least the overlap
+ */
+TEST_F(MarkerDetectorSuite, Tile_Size_Enables_Tiling)
+{
+    WorkStealingPool pool(2);
+    MarkerDetector::Tiling tiling;
+    tiling.size = 50;
+    tiling.overlap = DEFAULT_TILE_OVERLAP;
+    tiling.pool = &pool;
+    MarkerDetector detector(CameraCalib(), cv::aruco::DICT_4X4_50, nullptr, tiling);
+    EXPECT_TRUE(detector.is_tiled(cv::Size(1280, 720)));
+    // The tile size is raised to the overlap, so a frame of a single tile and its overlap isn't split
+    EXPECT_FALSE(detector.is_tiled(cv::Size(200, 200)));
+
+    cv::Mat image(720, 1280, CV_8UC1, cv::Scalar(255));
+    draw_marker(image, 3, cv::Point(100, 100), 60);
+    draw_marker(image, 9, cv::Point(900, 500), 60);
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int> ids;
+    detector.find(image, corners, ids);
+    ASSERT_EQ(ids.size(), 2u);
+}
+
+/**
+ * Check that searching coarse-to-fine finds the same markers as searching the whole frame, in the same places
+ */
+TEST_F(MarkerDetectorSuite, Pyramid_Finds_Whole_Frame_Markers)
+{
+    cv::Mat image(720, 1280, CV_8UC1, cv::Scalar(255));
+    const int sizes[] = {80, 120, 160, 240};
+    const cv::Point positions[] = {{100, 100}, {500, 80}, {900, 400}, {200, 400}};
+    for(int i = 0; i < 4; ++i)
+        draw_marker(image, 10 + i, positions[i], sizes[i]);
+
+    std::vector<std::vector<cv::Point2f>> expected_corners;
+    std::vector<int> expected_ids;
+    MarkerDetector(CameraCalib(), cv::aruco::DICT_4X4_50).find(image, expected_corners, expected_ids);
+    ASSERT_EQ(expected_ids.size(), 4u);
+
+    for(int levels = 1; levels <= 2; ++levels)
+    {
+        MarkerDetector detector(CameraCalib(), cv::aruco::DICT_4X4_50, nullptr, {}, levels);
+        std::vector<std::vector<cv::Point2f>> corners;
+        std::vector<int> ids;
+        detector.find(image, corners, ids);
+        ASSERT_EQ(ids.size(), expected_ids.size()) << levels << " pyramid levels";
+
+        // Corners are refined at full resolution, so they match the whole frame search
+        for(std::size_t i = 0; i < expected_ids.size(); ++i)
+        {
+            const auto it = std::find(ids.begin(), ids.end(), expected_ids[i]);
+            ASSERT_NE(it, ids.end()) << "marker " << expected_ids[i] << ", " << levels << " pyramid levels";
+            const auto& marker_corners = corners[it - ids.begin()];
+            for(std::size_t j = 0; j < 4; ++j)
+                EXPECT_LT(cv::norm(marker_corners[j] - expected_corners[i][j]), 1.0);
+        }
+    }
+}
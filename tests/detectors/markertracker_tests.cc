@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "../../src/detectors/markertracker.h"
+
+using namespace std::chrono_literals;
+
+class MarkerTrackerSuite : public testing::Test{
+protected:
+    /** @brief Make a square marker
+     *
+     * @param id [in] Id of the marker
+     * @param top_left [in] Position of the marker's top left corner on the sensor
+     * @param size [in] Side length of the marker in pixels
+     * @return Marker with its corners set
+     */
+    static Marker make_marker(int id, cv::Point2f top_left, float size){
+        Marker marker {};
+        marker.id = id;
+        marker.corners = {top_left, top_left + cv::Point2f(size, 0), top_left + cv::Point2f(size, size),
+                          top_left + cv::Point2f(0, size)};
+        return marker;
+    }
+
+    /** @brief Plan the search of a frame covering the whole sensor
+     *
+     * @param timestamp [in] When the frame was captured
+     * @param tracked_frames [in] Frames searched only in windows between two searches of the whole frame
+     * @return Windows to search, empty to search the whole frame
+     */
+    std::vector<cv::Rect> plan(std::chrono::steady_clock::time_point timestamp, int tracked_frames = 10){
+        Frame frame;
+        frame.image = cv::Mat(SENSOR_SIZE, CV_8UC1);
+        frame.timestamp = timestamp;
+        std::vector<cv::Rect> windows;
+        tracker.plan(frame, tracked_frames, windows);
+        return windows;
+    }
+
+    /** @brief Get the center of a window
+     *
+     * @param window [in] Window to get the center of
+     * @return Center of the window
+     */
+    static cv::Point2f center(const cv::Rect& window){
+        return cv::Point2f(window.x + window.width / 2.0f, window.y + window.height / 2.0f);
+    }
+public:
+    const cv::Size SENSOR_SIZE {1280, 720};
+    const std::chrono::steady_clock::time_point start;
+    MarkerTracker tracker;
+};
+
+/**
+ * Check that the whole frame is searched until some markers have been found
+ */
+TEST_F(MarkerTrackerSuite, Searches_Whole_Frame_Without_Tracks)
+{
+    EXPECT_TRUE(plan(start).empty());
+    tracker.update({}, start, true);
+    EXPECT_TRUE(plan(start + 10ms).empty());
+}
+
+/**
+ * Check that the window of a moving marker is centered on where it's predicted to be at the frame's timestamp
+ */
+TEST_F(MarkerTrackerSuite, Predicts_Moving_Markers)
+{
+    // Moving right at 100 pixels per second
+    tracker.update({make_marker(1, cv::Point2f(100, 100), 40)}, start, true);
+    tracker.update({make_marker(1, cv::Point2f(110, 100), 40)}, start + 100ms, true);
+
+    const std::vector<cv::Rect> windows = plan(start + 200ms);
+    ASSERT_EQ(windows.size(), 1u);
+    const cv::Rect predicted(120, 100, 40, 40);
+    EXPECT_EQ(windows[0] & predicted, predicted);
+    EXPECT_NEAR(center(windows[0]).x, 140, 1);
+    EXPECT_NEAR(center(windows[0]).y, 120, 1);
+}
+
+/**
+ * Check that the whole frame is searched again after the given amount of frames searched in windows, and always with
+ * no tracked frames
+ */
+TEST_F(MarkerTrackerSuite, Full_Scan_After_Tracked_Frames)
+{
+    tracker.update({make_marker(1, cv::Point2f(100, 100), 40)}, start, true);
+
+    EXPECT_FALSE(plan(start + 10ms, 2).empty());
+    EXPECT_FALSE(plan(start + 20ms, 2).empty());
+    EXPECT_TRUE(plan(start + 30ms, 2).empty());
+    EXPECT_FALSE(plan(start + 40ms, 2).empty());
+
+    EXPECT_TRUE(plan(start + 50ms, 0).empty());
+}
+
+/**
+ * Check that a marker missing from its window makes the next frame be searched as a whole, and that its track is kept
+ * where it was last seen rather than moved along
+ */
+TEST_F(MarkerTrackerSuite, Keeps_Marker_Missing_From_Window)
+{
+    tracker.update({make_marker(1, cv::Point2f(100, 100), 40)}, start, true);
+    tracker.update({make_marker(1, cv::Point2f(110, 100), 40)}, start + 100ms, true);
+    ASSERT_FALSE(plan(start + 200ms).empty());
+    tracker.update({}, start + 200ms, false);
+
+    EXPECT_TRUE(plan(start + 300ms).empty());
+
+    // Frames are planned before the whole frame's results are in, so the old track is still searched
+    const std::vector<cv::Rect> windows = plan(start + 1s);
+    ASSERT_EQ(windows.size(), 1u);
+    EXPECT_NEAR(center(windows[0]).x, 130, 1);
+    EXPECT_NEAR(center(windows[0]).y, 120, 1);
+}
+
+/**
+ * Check that markers a search of the whole frame didn't find are forgotten
+ */
+TEST_F(MarkerTrackerSuite, Drops_Markers_Missing_From_Full_Scan)
+{
+    const Marker near = make_marker(1, cv::Point2f(100, 100), 40);
+    const Marker far = make_marker(2, cv::Point2f(800, 400), 40);
+    tracker.update({near, far}, start, true);
+    EXPECT_EQ(plan(start + 10ms).size(), 2u);
+
+    tracker.update({near}, start + 10ms, true);
+    const std::vector<cv::Rect> windows = plan(start + 20ms);
+    ASSERT_EQ(windows.size(), 1u);
+    EXPECT_TRUE(windows[0].contains(cv::Point(120, 120)));
+
+    tracker.update({}, start + 20ms, true);
+    EXPECT_TRUE(plan(start + 30ms).empty());
+}
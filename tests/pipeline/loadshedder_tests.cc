@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "../../src/pipeline/loadshedder.h"
+
+using namespace std::chrono_literals;
+
+class LoadShedderSuite : public testing::Test{
+protected:
+    void SetUp(){
+        shedder.set_budget(10);
+    }
+
+    /** @brief Record frames 10 ms apart, starting at the current time
+     *
+     * @param latency [in] Latency of every frame, in milliseconds
+     * @param queue_fill [in] How full the queues were for every frame
+     * @param duration [in] How long to record frames for. The current time is moved on by this much
+     * @return Amount of times the level changed
+     */
+    int record_for(double latency, double queue_fill, std::chrono::milliseconds duration){
+        int changes = 0;
+        for(const auto end = now + duration; now < end; now += 10ms)
+        {
+            if(shedder.record(latency, queue_fill, now))
+                ++changes;
+        }
+        return changes;
+    }
+public:
+    LoadShedder shedder;
+    std::chrono::steady_clock::time_point now;
+};
+
+/**
+ * Check that without a budget, no load is shed no matter how slow the pipeline is
+ */
+TEST_F(LoadShedderSuite, No_Budget_Never_Sheds)
+{
+    shedder.set_budget(0);
+    EXPECT_EQ(record_for(1000, 1, 10s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+}
+
+/**
+ * Check that a latency over the budget moves up a level once every half second, up to the highest level
+ */
+TEST_F(LoadShedderSuite, Escalates_Over_Budget)
+{
+    // The first frame starts the hold, so the level can't change until half a second later
+    EXPECT_EQ(record_for(20, 0, 500ms), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+    EXPECT_EQ(record_for(20, 0, 10ms), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+
+    EXPECT_EQ(record_for(20, 0, 490ms), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+    EXPECT_EQ(record_for(20, 0, 10ms), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::ROI_ONLY);
+
+    EXPECT_EQ(record_for(20, 0, 10s), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::LOW_RESOLUTION);
+}
+
+/**
+ * Check that full queues move up a level once the latency is over half the budget, but not before
+ */
+TEST_F(LoadShedderSuite, Escalates_On_Full_Queues)
+{
+    EXPECT_EQ(record_for(4, 1, 10s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+
+    EXPECT_EQ(record_for(6, 0, 10s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+
+    EXPECT_GT(record_for(6, 1, 1s), 0);
+    EXPECT_NE(shedder.level(), LoadShedder::Level::NONE);
+}
+
+/**
+ * Check that a latency between half the budget and the budget neither moves the level up nor down
+ */
+TEST_F(LoadShedderSuite, Holds_Level_Within_Budget)
+{
+    record_for(20, 0, 510ms);
+    ASSERT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+
+    EXPECT_EQ(record_for(7, 0, 30s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+}
+
+/**
+ * Check that once the pipeline is comfortably within the budget, the level moves down one step every 3 seconds
+ */
+TEST_F(LoadShedderSuite, Recovers_When_Calm)
+{
+    record_for(20, 0, 10s);
+    ASSERT_EQ(shedder.level(), LoadShedder::Level::LOW_RESOLUTION);
+
+    // The smoothed latency takes a few frames to drop below half the budget, so it isn't calm for 3 seconds yet
+    EXPECT_EQ(record_for(1, 0, 3s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::LOW_RESOLUTION);
+    EXPECT_EQ(record_for(1, 0, 1s), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::ROI_ONLY);
+
+    // Every step down waits another 3 seconds, including the frame that made it
+    record_for(1, 0, 2s);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::ROI_ONLY);
+    EXPECT_EQ(record_for(1, 0, 10s), 2);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+}
+
+/**
+ * Check that a frame that isn't calm restarts the wait before moving down
+ */
+TEST_F(LoadShedderSuite, Busy_Frames_Delay_Recovery)
+{
+    record_for(20, 0, 510ms);
+    ASSERT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+    record_for(1, 0, 2s);
+
+    // Full queues aren't calm, even though the latency is well within the budget
+    record_for(1, 1, 100ms);
+    EXPECT_EQ(record_for(1, 0, 2s), 0);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::SKIP_FRAMES);
+    EXPECT_EQ(record_for(1, 0, 2s), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+}
+
+/**
+ * Check that removing the budget stops shedding load straight away
+ */
+TEST_F(LoadShedderSuite, Removing_Budget_Stops_Shedding)
+{
+    record_for(20, 0, 10s);
+    ASSERT_EQ(shedder.level(), LoadShedder::Level::LOW_RESOLUTION);
+
+    shedder.set_budget(0);
+    EXPECT_EQ(record_for(20, 0, 10ms), 1);
+    EXPECT_EQ(shedder.level(), LoadShedder::Level::NONE);
+}